@@ -0,0 +1,530 @@
+/*
+## Binary Descriptors
+
+ORB and BRIEF describe a keypoint with 256 bits instead of 128 floats, and two descriptors are compared by the
+Hamming distance: the number of bits set in their XOR. The search is the same brute force as for the float
+descriptors, only the kernel changes:
+
+- Scalar: one popcnt per 64-bit word, spread over independent accumulators.
+- AVX2: per-nibble popcount through a pshufb lookup, folded into 64-bit lanes with psadbw. Descriptors longer than
+  a few vectors go through a Harley-Seal carry-save adder first, so only one vector in four is popcounted.
+- AVX-512: VPOPCNTQ on whole 512-bit vectors, with a masked load for the part that does not fill a vector.
+
+The widest kernels the host supports are picked at runtime, and every supported set is benchmarked and checked
+against the scalar results. The search runs for LONG_BITS and 256-bit (ORB) descriptors, followed by a top-k
+search over the 256-bit ones with the widest kernels.
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <utility>
+#include <limits>
+#include <new>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    BITS = 256,
+    LONG_BITS = 1'024,
+    NUM_OF_ACCUMULATORS = 4,
+    HARLEY_SEAL_GROUP = 4,
+    TOP_K = 10,
+};
+
+enum class InstructionSet : std::uint8_t
+{
+    SCALAR,
+    AVX2,
+    AVX512,
+};
+
+
+/*
+ * Hamming kernels, one set per instruction set, each in its own target region so it can be dispatched to at
+ * runtime. The kernels take the number of 64-bit words at compile time and return the number of differing bits.
+ * GCC only inlines a target-specific function into a caller of the same target, so every set also has a Run()
+ * that compiles the code handed to it for that target and flattens the kernels into it.
+ */
+
+#pragma GCC push_options
+#pragma GCC target("popcnt")
+
+struct ScalarKernels
+{
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::SCALAR};
+
+    template <size_t Words>
+    static std::uint32_t Hamming(std::uint64_t const * const lhs, std::uint64_t const * const rhs) noexcept
+    {
+        std::uint64_t count[NUM_OF_ACCUMULATORS] = {0, 0, 0, 0};
+
+        [&]<size_t... IDX>(std::index_sequence<IDX...>) -> void
+        {
+            ((count[IDX % NUM_OF_ACCUMULATORS] += static_cast<std::uint64_t>(_mm_popcnt_u64(lhs[IDX] ^ rhs[IDX]))), ...);
+        }(std::make_index_sequence<Words>{});
+
+        return static_cast<std::uint32_t>(count[0] + count[1] + count[2] + count[3]);
+    }
+
+    template <typename Function>
+    __attribute__((flatten)) static void Run(Function const & function) noexcept
+    {
+        function.template operator()<ScalarKernels>();
+    }
+};
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,popcnt")
+
+struct AVX2Kernels
+{
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::AVX2};
+    static constexpr size_t WIDTH{4};
+
+    template <size_t Words>
+    static std::uint32_t Hamming(std::uint64_t const * const lhs, std::uint64_t const * const rhs) noexcept
+    {
+        constexpr size_t vectors = Words / WIDTH;
+        constexpr size_t grouped = Words / (WIDTH * HARLEY_SEAL_GROUP) * HARLEY_SEAL_GROUP;
+
+        auto const load = [&](size_t const vector) -> __m256i
+        {
+            return _mm256_xor_si256(_mm256_load_si256(reinterpret_cast<__m256i const *>(lhs) + vector), _mm256_load_si256(reinterpret_cast<__m256i const *>(rhs) + vector));
+        };
+
+        __m256i total = _mm256_setzero_si256();
+
+        if constexpr (grouped != 0)
+        {
+            /* Every group of four vectors is added into the ones and twos planes and only the carries are counted */
+            __m256i ones = _mm256_setzero_si256();
+            __m256i twos = _mm256_setzero_si256();
+            __m256i twosLow, twosHigh, fours;
+
+            for (size_t vector = 0; vector < grouped; vector += HARLEY_SEAL_GROUP)
+            {
+                CarrySaveAdd(twosLow, ones, ones, load(vector + 0), load(vector + 1));
+                CarrySaveAdd(twosHigh, ones, ones, load(vector + 2), load(vector + 3));
+                CarrySaveAdd(fours, twos, twos, twosLow, twosHigh);
+
+                total = _mm256_add_epi64(total, Count(fours));
+            }
+
+            total = _mm256_slli_epi64(total, 2);
+            total = _mm256_add_epi64(total, _mm256_slli_epi64(Count(twos), 1));
+            total = _mm256_add_epi64(total, Count(ones));
+        }
+
+        for (size_t vector = grouped; vector < vectors; ++vector)
+        {
+            total = _mm256_add_epi64(total, Count(load(vector)));
+        }
+
+        __m128i const sum128 = _mm_add_epi64(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1)); /* Add the lower and upper halves */
+        auto result = static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_add_epi64(sum128, _mm_unpackhi_epi64(sum128, sum128))));
+
+        for (size_t word = vectors * WIDTH; word < Words; ++word)
+        {
+            result += static_cast<std::uint64_t>(_mm_popcnt_u64(lhs[word] ^ rhs[word]));
+        }
+
+        return static_cast<std::uint32_t>(result);
+    }
+
+    template <typename Function>
+    __attribute__((flatten)) static void Run(Function const & function) noexcept
+    {
+        function.template operator()<AVX2Kernels>();
+    }
+
+private:
+    /*
+     * Bits set in each 64-bit lane: the count of every nibble comes from a 16-entry table, and psadbw adds the
+     * eight byte counts of each lane.
+     */
+    static __m256i Count(__m256i const vector) noexcept
+    {
+        __m256i const table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        __m256i const nibbleMask = _mm256_set1_epi8(0x0F);
+
+        __m256i const low = _mm256_shuffle_epi8(table, _mm256_and_si256(vector, nibbleMask));                         /* Count the low nibbles */
+        __m256i const high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(vector, 4), nibbleMask)); /* Count the high nibbles */
+        return _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256());                                   /* Sum the bytes of each lane */
+    }
+
+    /*
+     * Adds three bit planes: high receives the carries and low the sum bits.
+     */
+    static void CarrySaveAdd(__m256i & high, __m256i & low, __m256i const first, __m256i const second, __m256i const third) noexcept
+    {
+        __m256i const partial = _mm256_xor_si256(first, second);
+        high = _mm256_or_si256(_mm256_and_si256(first, second), _mm256_and_si256(partial, third));
+        low = _mm256_xor_si256(partial, third);
+    }
+};
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512vl,avx512vpopcntdq")
+
+struct AVX512Kernels
+{
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::AVX512};
+    static constexpr size_t WIDTH{8};
+
+    template <size_t Words>
+    static std::uint32_t Hamming(std::uint64_t const * const lhs, std::uint64_t const * const rhs) noexcept
+    {
+        __m512i sum[NUM_OF_ACCUMULATORS] = {_mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512()};
+
+        [&]<size_t... IDX>(std::index_sequence<IDX...>) -> void
+        {
+            ((sum[IDX % NUM_OF_ACCUMULATORS] = _mm512_add_epi64(sum[IDX % NUM_OF_ACCUMULATORS], _mm512_popcnt_epi64(_mm512_xor_si512(_mm512_load_si512(lhs + IDX * WIDTH), _mm512_load_si512(rhs + IDX * WIDTH))))), ...);
+        }(std::make_index_sequence<Words / WIDTH>{});
+
+        if constexpr (Words < WIDTH && Words % (WIDTH / 2) == 0)
+        {
+            /* A 256-bit descriptor fits one ymm register, and its count needs a much shorter reduction */
+            __m256i const difference = _mm256_xor_si256(_mm256_load_si256(reinterpret_cast<__m256i const *>(lhs)), _mm256_load_si256(reinterpret_cast<__m256i const *>(rhs)));
+            __m256i const count = _mm256_popcnt_epi64(difference);
+            __m128i const sum128 = _mm_add_epi64(_mm256_castsi256_si128(count), _mm256_extracti128_si256(count, 1));
+            return static_cast<std::uint32_t>(_mm_cvtsi128_si64(_mm_add_epi64(sum128, _mm_unpackhi_epi64(sum128, sum128))));
+        }
+
+        if constexpr (Words % WIDTH != 0)
+        {
+            __mmask8 constexpr mask = (1U << (Words % WIDTH)) - 1U;
+            __m512i const difference = _mm512_xor_si512(_mm512_maskz_load_epi64(mask, lhs + Words / WIDTH * WIDTH), _mm512_maskz_load_epi64(mask, rhs + Words / WIDTH * WIDTH));
+            sum[0] = _mm512_add_epi64(sum[0], _mm512_popcnt_epi64(difference));
+        }
+
+        return static_cast<std::uint32_t>(_mm512_reduce_add_epi64(_mm512_add_epi64(_mm512_add_epi64(sum[0], sum[1]), _mm512_add_epi64(sum[2], sum[3]))));
+    }
+
+    template <typename Function>
+    __attribute__((flatten)) static void Run(Function const & function) noexcept
+    {
+        function.template operator()<AVX512Kernels>();
+    }
+};
+
+#pragma GCC pop_options
+
+
+class DescriptorGenerator
+{
+protected:
+    static std::mt19937 randomEngine;
+    static std::function<std::uint64_t()> generator;
+};
+
+std::mt19937 DescriptorGenerator::randomEngine{SEED};
+std::function<std::uint64_t()> DescriptorGenerator::generator = []() -> std::uint64_t
+{
+    auto const high = static_cast<std::uint64_t>(randomEngine());
+    return high << 32U | static_cast<std::uint64_t>(randomEngine());
+};
+
+
+template <size_t Bits> requires (Bits % 64 == 0)
+class BinaryDescriptor : private DescriptorGenerator
+{
+public:
+    static constexpr size_t BITS = Bits;
+    static constexpr size_t WORDS = Bits / 64;
+
+    BinaryDescriptor() noexcept
+    {
+        std::generate(words, words + WORDS, generator);
+    }
+
+    template <typename Kernels>
+    static std::uint32_t getHamming(BinaryDescriptor const & lhs, BinaryDescriptor const & rhs) noexcept
+    {
+        return Kernels::template Hamming<WORDS>(lhs.words, rhs.words);
+    }
+
+private:
+    alignas(ALIGN) std::uint64_t words[WORDS];
+};
+
+
+template <size_t K>
+class TopK
+{
+public:
+    void Reset() noexcept
+    {
+        std::fill(distances, distances + K, std::numeric_limits<std::uint32_t>::max());
+        std::fill(indices, indices + K, 0U);
+    }
+
+    /*
+     * Sorted insert without data-dependent branches, ties keep the earlier index in front.
+     */
+    void Insert(std::uint32_t const distance, std::uint32_t const index) noexcept
+    {
+        if (distance >= distances[K - 1])
+        {
+            return;
+        }
+
+#pragma GCC unroll 16
+        for (size_t slot = K - 1; slot > 0; --slot)
+        {
+            bool const shift = distance < distances[slot - 1];
+            bool const place = distance < distances[slot];
+
+            distances[slot] = shift ? distances[slot - 1] : (place ? distance : distances[slot]);
+            indices[slot] = shift ? indices[slot - 1] : (place ? index : indices[slot]);
+        }
+
+        bool const first = distance < distances[0];
+
+        distances[0] = first ? distance : distances[0];
+        indices[0] = first ? index : indices[0];
+    }
+
+    std::uint32_t Index(size_t const rank) const noexcept
+    {
+        return indices[rank];
+    }
+
+private:
+    std::uint32_t distances[K];
+    std::uint32_t indices[K];
+};
+
+
+alignas(ALIGN) BinaryDescriptor<BITS> set1[NUM_OF_POINTS];
+alignas(ALIGN) BinaryDescriptor<BITS> set2[NUM_OF_POINTS];
+
+alignas(ALIGN) BinaryDescriptor<LONG_BITS> longSet1[NUM_OF_POINTS];
+alignas(ALIGN) BinaryDescriptor<LONG_BITS> longSet2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesReference[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesHamming[NUM_OF_POINTS];
+
+alignas(ALIGN) TopK<TOP_K> neighbours[NUM_OF_POINTS];
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> double;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs) noexcept -> size_t;
+
+auto inline GetInstructionSet() noexcept -> InstructionSet;
+auto inline GetInstructionSetName(InstructionSet const instructionSet) noexcept -> std::string_view;
+
+template <typename Function>
+auto inline Dispatch(InstructionSet const instructionSet, Function const & function) noexcept -> void;
+
+template <typename Kernels, size_t Bits>
+auto inline CompareHamming(BinaryDescriptor<Bits> const * const lhs, BinaryDescriptor<Bits> const * const rhs, size_t * const indices) noexcept -> void;
+template <typename Kernels, size_t Bits>
+auto inline SearchTopK(BinaryDescriptor<Bits> const * const lhs, BinaryDescriptor<Bits> const * const rhs) noexcept -> void;
+
+template <size_t Bits>
+auto inline TestKernels(BinaryDescriptor<Bits> const * const lhs, BinaryDescriptor<Bits> const * const rhs) noexcept -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    std::cout << std::format("Instruction Set : {}\n", GetInstructionSetName(GetInstructionSet()));
+
+    TestKernels(longSet1, longSet2);
+
+    TestKernels(set1, set2);
+
+    std::cout << std::format("Starting Top-{} Hamming ({} bits)\n", static_cast<size_t>(TOP_K), static_cast<size_t>(BITS));
+    TestSpeed([] { Dispatch(GetInstructionSet(), []<typename Kernels> { SearchTopK<Kernels>(set1, set2); }); }, "Top-k Hamming");
+
+    std::transform(neighbours, neighbours + NUM_OF_POINTS, indicesHamming, [](auto const & top) { return top.Index(0); });
+    std::cout << std::format("Mismatches against the nearest neighbour : {}\n", CountMismatches(indicesHamming, indicesReference));
+
+    std::transform(neighbours, neighbours + NUM_OF_POINTS, indicesHamming, [](auto const & top) { return top.Index(TOP_K - 1); });
+    ComputeChecksum(indicesHamming, std::format("Top-{} Hamming (last rank)", static_cast<size_t>(TOP_K)));
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> double
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs) noexcept -> size_t
+{
+    return std::inner_product(lhs, lhs + NUM_OF_POINTS, rhs, 0UL, std::plus<>(), std::not_equal_to<>());
+}
+
+auto inline GetInstructionSet() noexcept -> InstructionSet
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512vpopcntdq"))
+    {
+        return InstructionSet::AVX512;
+    }
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+    {
+        return InstructionSet::AVX2;
+    }
+
+    return InstructionSet::SCALAR;
+}
+
+auto inline GetInstructionSetName(InstructionSet const instructionSet) noexcept -> std::string_view
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::AVX512 :
+            return "AVX-512 VPOPCNTQ";
+        case InstructionSet::AVX2 :
+            return "AVX2 Harley-Seal";
+        case InstructionSet::SCALAR :
+            return "Scalar popcnt";
+        default :
+            return "Unknown";
+    }
+}
+
+/*
+ * Runs the function once with the kernels of the given instruction set. The searches hand the work of every
+ * query to Kernels::Run(), as the bodies of the parallel loops are outlined with the target of the function
+ * they are written in.
+ */
+template <typename Function>
+auto inline Dispatch(InstructionSet const instructionSet, Function const & function) noexcept -> void
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::AVX512 :
+            function.template operator()<AVX512Kernels>();
+            break;
+        case InstructionSet::AVX2 :
+            function.template operator()<AVX2Kernels>();
+            break;
+        case InstructionSet::SCALAR :
+            function.template operator()<ScalarKernels>();
+            break;
+        default :
+            break;
+    }
+}
+
+template <typename Kernels, size_t Bits>
+auto inline CompareHamming(BinaryDescriptor<Bits> const * const lhs, BinaryDescriptor<Bits> const * const rhs, size_t * const indices) noexcept -> void
+{
+    #pragma omp parallel for schedule(static)
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        Kernels::Run([&]<typename> -> void
+        {
+            std::uint32_t minDistance = std::numeric_limits<std::uint32_t>::max();
+            size_t minIndex = 0;
+
+            for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+            {
+                std::uint32_t const currentDistance = BinaryDescriptor<Bits>::template getHamming<Kernels>(lhs[idx1], rhs[idx2]);
+
+                if (currentDistance < minDistance)
+                {
+                    minDistance = currentDistance;
+                    minIndex = idx2;
+                }
+            }
+
+            indices[idx1] = minIndex;
+        });
+    }
+}
+
+template <typename Kernels, size_t Bits>
+auto inline SearchTopK(BinaryDescriptor<Bits> const * const lhs, BinaryDescriptor<Bits> const * const rhs) noexcept -> void
+{
+    #pragma omp parallel for schedule(static)
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        Kernels::Run([&]<typename> -> void
+        {
+            auto & top = neighbours[idx1];
+            top.Reset();
+
+            for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+            {
+                top.Insert(BinaryDescriptor<Bits>::template getHamming<Kernels>(lhs[idx1], rhs[idx2]), static_cast<std::uint32_t>(idx2));
+            }
+        });
+    }
+}
+
+/*
+ * Brute-force Hamming search with every instruction set the host supports, from scalar up. Integer distances tie
+ * often, and all kernels keep the lowest index, so their results must match the scalar ones exactly.
+ */
+template <size_t Bits>
+auto inline TestKernels(BinaryDescriptor<Bits> const * const lhs, BinaryDescriptor<Bits> const * const rhs) noexcept -> void
+{
+    constexpr double comparisons = static_cast<double>(NUM_OF_POINTS) * static_cast<double>(NUM_OF_POINTS);
+
+    for (auto const instructionSet : {InstructionSet::SCALAR, InstructionSet::AVX2, InstructionSet::AVX512})
+    {
+        if (instructionSet > GetInstructionSet())
+        {
+            break;
+        }
+
+        auto const name = GetInstructionSetName(instructionSet);
+        auto * const indices = instructionSet == InstructionSet::SCALAR ? indicesReference : indicesHamming;
+
+        std::cout << std::format("Starting Comparing Hamming ({}, {} bits)\n", name, Bits);
+        auto const seconds = TestSpeed([&] { Dispatch(instructionSet, [&]<typename Kernels> { CompareHamming<Kernels>(lhs, rhs, indices); }); }, std::format("CompareHamming ({})", name));
+
+        std::cout << std::format("Throughput for {} : {:.2f} G comparisons/s\n", name, comparisons / seconds / 1e9);
+        ComputeChecksum(indices, std::format("Hamming ({}, {} bits)", name, Bits));
+
+        if (instructionSet != InstructionSet::SCALAR)
+        {
+            std::cout << std::format("Mismatches against Scalar : {}\n", CountMismatches(indices, indicesReference));
+        }
+
+        Cooldown();
+    }
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+/*
+ * The .dset and .gt files written by DistanceDataset and the recall table its engines append to. DistanceDataset
+ * and every engine program that runs on its datasets include this header, so the format is defined only here.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+static constexpr std::uint32_t DATASET_MAGIC{0x54455344U};      /* "DSET" */
+static constexpr std::uint32_t DATASET_VERSION{1U};
+static constexpr std::uint32_t GROUND_TRUTH_MAGIC{0x55525447U}; /* "GTRU" */
+static constexpr std::uint32_t GROUND_TRUTH_VERSION{1U};
+
+static constexpr std::string_view CSV_FILE{"../recall.csv"};
+static constexpr std::string_view CSV_HEADER{"dataset,engine,parameter,k,recall,qps,threads,memory_mb\n"};
+
+
+enum class DataType : std::uint32_t
+{
+    FLOAT32 = 0,
+    UINT8 = 1,
+};
+
+struct DatasetHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t dimensions;
+    DataType dtype;
+    std::uint64_t count;
+    std::uint64_t alignment;
+    std::uint64_t payloadOffset;
+    std::uint64_t stride;
+    std::uint8_t reserved[16];
+};
+
+static_assert(sizeof(DatasetHeader) == 64, "The payload must start on the first aligned boundary");
+
+struct GroundTruthHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t queries;
+    std::uint32_t neighbours;
+    std::uint64_t fingerprint;
+};
+
+/*
+ * The exact neighbours of every query of a dataset, empty when an engine program runs on its own sets.
+ */
+struct GroundTruth
+{
+    std::string dataset;
+    std::uint32_t neighbours;
+    std::vector<std::uint32_t> ids;
+};
+
+
+/*
+ * Checks that file holds float records of exactly one Descriptor each, moves it to the payload and returns the
+ * number of records.
+ */
+template <typename Descriptor>
+auto inline ReadDatasetHeader(std::ifstream & file, std::string_view const fileName) -> size_t
+{
+    static_assert(sizeof(Descriptor) == Descriptor::DIMENSIONS * sizeof(float), "A float record must be exactly one Descriptor");
+
+    DatasetHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    if (!file || header.magic != DATASET_MAGIC || header.version != DATASET_VERSION || header.dtype != DataType::FLOAT32 || header.dimensions != Descriptor::DIMENSIONS ||
+        header.stride != sizeof(Descriptor))
+    {
+        throw std::runtime_error{std::format("Dataset {} is not a set of {}-D float descriptors", fileName, Descriptor::DIMENSIONS)};
+    }
+
+    file.seekg(static_cast<std::streamoff>(header.payloadOffset));
+
+    return header.count;
+}
+
+/*
+ * Reads a .dset into a set of an engine program, so it must hold exactly count descriptors.
+ */
+template <typename Descriptor>
+auto inline ReadDataset(std::string const & fileName, Descriptor * const descriptors, size_t const count) -> void
+{
+    std::ifstream file{fileName, std::ios::binary};
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error{std::format("Failed to open dataset: {}", fileName)};
+    }
+
+    if (auto const stored = ReadDatasetHeader<Descriptor>(file, fileName); stored != count)
+    {
+        throw std::runtime_error{std::format("Dataset {} holds {} descriptors instead of {}", fileName, stored, count)};
+    }
+
+    file.read(reinterpret_cast<char *>(descriptors), static_cast<std::streamsize>(count * sizeof(Descriptor)));
+
+    if (!file)
+    {
+        throw std::runtime_error{std::format("Dataset {} is truncated", fileName)};
+    }
+}
+
+/*
+ * FNV-1a over the counts and bytes of the references and the queries, stored in the .gt to tie it to both sets.
+ */
+template <typename Descriptor>
+auto inline Fingerprint(Descriptor const * const references, size_t const referenceCount, Descriptor const * const queries, size_t const queryCount) noexcept -> std::uint64_t
+{
+    std::uint64_t hash{0xCBF29CE484222325UL};
+
+    auto const mix = [&hash](void const * const data, size_t const size)
+    {
+        auto const * const bytes = static_cast<std::uint8_t const *>(data);
+
+        for (size_t idx = 0; idx < size; ++idx)
+        {
+            hash = (hash ^ bytes[idx]) * 0x100000001B3UL;
+        }
+    };
+
+    mix(&referenceCount, sizeof(referenceCount));
+    mix(references, referenceCount * sizeof(Descriptor));
+    mix(&queryCount, sizeof(queryCount));
+    mix(queries, queryCount * sizeof(Descriptor));
+
+    return hash;
+}
+
+/*
+ * Replaces the queries and references of an engine program with ../<name>_query.dset and ../<name>_base.dset and
+ * returns their cached ground truth ../<name>.gt, which must have been computed for exactly these two sets.
+ */
+template <typename Descriptor>
+auto inline LoadDataset(std::string_view const name, Descriptor * const queries, Descriptor * const references, size_t const count) -> GroundTruth
+{
+    ReadDataset(std::format("../{}_query.dset", name), queries, count);
+    ReadDataset(std::format("../{}_base.dset", name), references, count);
+
+    auto const fileName = std::format("../{}.gt", name);
+    std::ifstream file{fileName, std::ios::binary};
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error{std::format("Failed to open ground truth: {}", fileName)};
+    }
+
+    GroundTruthHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    if (!file || header.magic != GROUND_TRUTH_MAGIC || header.version != GROUND_TRUTH_VERSION || header.queries != count || header.neighbours == 0)
+    {
+        throw std::runtime_error{std::format("{} is not the ground truth of {} queries", fileName, count)};
+    }
+
+    if (header.fingerprint != Fingerprint(references, count, queries, count))
+    {
+        throw std::runtime_error{std::format("{} was computed for other sets, rerun DistanceDataset", fileName)};
+    }
+
+    GroundTruth groundTruth{std::string{name}, header.neighbours, std::vector<std::uint32_t>(count * header.neighbours)};
+    file.read(reinterpret_cast<char *>(groundTruth.ids.data()), static_cast<std::streamsize>(groundTruth.ids.size() * sizeof(std::uint32_t)));
+
+    if (!file)
+    {
+        throw std::runtime_error{std::format("Ground truth {} is truncated", fileName)};
+    }
+
+    std::cout << std::format("Dataset {} : {} references, {} queries, top-{} ground truth\n", name, count, count, header.neighbours);
+
+    return groundTruth;
+}
+
+/*
+ * Recall@1 in percent of the single-best results of count queries against their nearest neighbour in the ground
+ * truth, zero without a dataset.
+ */
+auto inline GroundTruthRecall(GroundTruth const & groundTruth, size_t const * const found, size_t const count) noexcept -> double
+{
+    if (groundTruth.dataset.empty() || count == 0)
+    {
+        return 0.0;
+    }
+
+    size_t hits{0};
+
+    for (size_t idx1 = 0; idx1 < count; ++idx1)
+    {
+        hits += found[idx1] == groundTruth.ids[idx1 * groundTruth.neighbours];
+    }
+
+    return static_cast<double>(hits) / static_cast<double>(count) * 100.0;
+}
+
+/*
+ * Adds one point to the recall/QPS/memory table of DistanceDataset. Only runs on one of its datasets are recorded.
+ */
+auto inline AppendRecall(GroundTruth const & groundTruth, std::string_view const engine, std::string_view const parameter, size_t const k, double const recall,
+                         double const queriesPerSecond, int const threads, size_t const bytes) -> void
+{
+    if (groundTruth.dataset.empty())
+    {
+        return;
+    }
+
+    auto const exists = std::filesystem::exists(CSV_FILE);
+    std::ofstream csv{CSV_FILE.data(), std::ios::app};
+
+    if (!csv.is_open())
+    {
+        throw std::runtime_error{std::format("Failed to open output file: {}", CSV_FILE)};
+    }
+
+    if (!exists)
+    {
+        csv << CSV_HEADER;
+    }
+
+    csv << std::format("{},{},{},{},{:.4f},{:.2f},{},{:.3f}\n", groundTruth.dataset, engine, parameter, k, recall, queriesPerSecond, threads, static_cast<double>(bytes) / 1e6);
+
+    if (!csv)
+    {
+        throw std::runtime_error{std::format("Failed to write to: {}", CSV_FILE)};
+    }
+}
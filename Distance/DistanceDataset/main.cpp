@@ -0,0 +1,985 @@
+/*
+## Clustered Datasets and Recall Harness
+
+The other benchmarks draw every feature i.i.d. from U[0, 1). That is the worst case for pruning and indexing,
+because every reference is almost equally far from every query, and it is unlike real SIFT data. This program
+generates datasets from a Gaussian mixture that can be tuned towards real data:
+
+    - clusters: the number of mixture components, with centers drawn from U[0, 1)^128.
+    - size exponent: cluster c is drawn with a weight proportional to (c + 1)^-exponent, so the cluster sizes
+      follow a power law instead of being equal.
+    - intrinsic dimensions: each cluster spreads along its own random orthonormal basis of that many directions,
+      with only a small isotropic noise in the other dimensions.
+    - duplicate fraction: this share of the references copies an earlier reference with a small noise added.
+
+Features are clamped to non-negative values, as in SIFT. The references and queries of a uniform and a clustered
+dataset are written in the .dset format read by DistanceMapped, and the harness reads them back from there.
+
+The exact top-NUM_OF_NEIGHBOURS L2 neighbours of every query are computed once by brute force and cached in a .gt
+file next to the queries. The cache holds a fingerprint of both datasets and is recomputed when they change.
+
+Every engine sweeps its tuning parameter and reports Recall@NUM_OF_NEIGHBOURS, queries per second (all OpenMP
+threads) and index memory. The points are printed and written to ../recall.csv for plotting:
+
+    - Brute force: the exact scan, one point.
+    - IVF-Flat: a k-means coarse quantizer of NUM_OF_LISTS lists, with the lists stored contiguously and nprobe
+      lists scanned per query.
+    - SQ8: the references quantized to one byte per dimension and scanned with an integer kernel, with a shortlist
+      of candidates re-ranked with the exact kernel.
+
+Both sets of a dataset hold NUM_OF_POINTS descriptors, the size of set1 and set2 in the other programs, so the
+engine programs (DistanceKDForest, DistanceHNSW, DistanceIVFPQ, DistanceQuantized, DistanceHalf, DistancePivot,
+DistanceEarlyAbandon and DistanceProjection) can be run on one afterwards with its name as argument. They score
+their L2 search against the same .gt file and append their points to ../recall.csv, which this program starts
+anew. Each row records the k of its recall and the number of threads its queries per second were measured on.
+The file formats and the shared reading and scoring code are in Dataset.hpp, which each of them includes.
+
+The other Distance programs are not wired, because they would add no point to the recall/speed trade-off:
+
+    - DistanceSIMD, DistanceSIMDOpenMP, DistanceGEMM and DistanceSoA are exact scans whose cost does not depend
+      on the data, so they sit at 100 % recall with the queries per second of their uniform run; the brute-force
+      point of this program stands for them.
+    - DistanceBinary, DistanceMetrics, DistanceMatching and DistanceRange do not answer the float L2 nearest
+      neighbour query of the .gt: Hamming distance on bit descriptors, other metrics, ratio-tested matches and
+      fixed-radius results.
+    - DistanceMapped and DistanceStreaming measure mapping and disk throughput, DistanceService and
+      DistanceSharded the latency and batching of an exact search, and DistanceMutable inserts, deletes and
+      compaction of an IVF store whose search is the IVF-Flat engine of this program.
+*/
+
+#include "Dataset.hpp"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <fstream>
+#include <vector>
+#include <stdexcept>
+#include <filesystem>
+#include <array>
+
+#include <immintrin.h>
+#include <omp.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    PAYLOAD_ALIGNMENT = 64,
+    NUM_OF_REFERENCES = NUM_OF_POINTS,
+    NUM_OF_QUERIES = NUM_OF_POINTS,
+    NUM_OF_NEIGHBOURS = 10,
+    NUM_OF_LISTS = 128,
+    KMEANS_SAMPLE = 20'000,
+    KMEANS_ITERATIONS = 8,
+    SQ8_LEVELS = 255,
+};
+
+static constexpr std::array<size_t, 7> NPROBE{1, 2, 4, 8, 16, 32, 64};
+static constexpr std::array<size_t, 5> SHORTLIST{10, 20, 40, 80, 160};
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+static_assert(sizeof(DatasetHeader) == PAYLOAD_ALIGNMENT, "The payload must start on the first aligned boundary");
+
+struct MixtureParameters
+{
+    size_t clusters;
+    double sizeExponent;
+    size_t intrinsicDimensions;
+    float spread;
+    float noise;
+    double duplicateFraction;
+    float duplicateNoise;
+};
+
+static constexpr MixtureParameters SIFT_LIKE{.clusters = 512, .sizeExponent = 1.0, .intrinsicDimensions = 12, .spread = 0.08F, .noise = 0.01F, .duplicateFraction = 0.05, .duplicateNoise = 0.002F};
+
+struct Candidate
+{
+    float distance;
+    std::uint32_t index;
+
+    bool operator<(Candidate const & other) const noexcept
+    {
+        return distance < other.distance;
+    }
+};
+
+struct Dataset
+{
+    std::string name;
+    std::vector<Descriptor> references;
+    std::vector<Descriptor> queries;
+    std::vector<std::uint32_t> groundTruth;
+};
+
+struct Measurement
+{
+    double recall;
+    double queriesPerSecond;
+};
+
+using Neighbours = std::vector<std::uint32_t>;
+
+
+/*
+ * Gaussian mixture with power-law component weights. Each component has a center and an orthonormal basis of
+ * intrinsicDimensions directions along which its points spread.
+ */
+class Mixture
+{
+public:
+    Mixture(MixtureParameters const & parameters, std::mt19937 & engine) : parameters{parameters}, centers(parameters.clusters),
+        bases(parameters.clusters * parameters.intrinsicDimensions * Descriptor::DIMENSIONS)
+    {
+        std::vector<double> weights(parameters.clusters);
+
+        for (size_t cluster = 0; cluster < parameters.clusters; ++cluster)
+        {
+            weights[cluster] = std::pow(static_cast<double>(cluster + 1), -parameters.sizeExponent);
+        }
+
+        component = std::discrete_distribution<size_t>{weights.begin(), weights.end()};
+
+        std::uniform_real_distribution<float> uniform{0.0F, 1.0F};
+        std::normal_distribution<float> normal{0.0F, 1.0F};
+
+        for (size_t cluster = 0; cluster < parameters.clusters; ++cluster)
+        {
+            for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+            {
+                centers[cluster][dim] = uniform(engine);
+            }
+
+            auto * const basis = Basis(cluster);
+
+            /* Gram-Schmidt on random Gaussian directions */
+            for (size_t direction = 0; direction < parameters.intrinsicDimensions; ++direction)
+            {
+                auto * const vector = basis + direction * Descriptor::DIMENSIONS;
+                std::generate(vector, vector + Descriptor::DIMENSIONS, [&] { return normal(engine); });
+
+                for (size_t previous = 0; previous < direction; ++previous)
+                {
+                    auto const * const other = basis + previous * Descriptor::DIMENSIONS;
+                    auto const projection = std::inner_product(vector, vector + Descriptor::DIMENSIONS, other, 0.0F);
+
+                    std::transform(vector, vector + Descriptor::DIMENSIONS, other, vector, [projection](auto const lhs, auto const rhs) { return lhs - projection * rhs; });
+                }
+
+                auto const norm = std::sqrt(std::inner_product(vector, vector + Descriptor::DIMENSIONS, vector, 0.0F));
+                std::transform(vector, vector + Descriptor::DIMENSIONS, vector, [norm](auto const value) { return value / norm; });
+            }
+        }
+    }
+
+    void Sample(Descriptor & descriptor, std::mt19937 & engine)
+    {
+        std::normal_distribution<float> normal{0.0F, 1.0F};
+
+        auto const cluster = component(engine);
+        auto const * const basis = Basis(cluster);
+
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            descriptor[dim] = centers[cluster][dim] + parameters.noise * normal(engine);
+        }
+
+        for (size_t direction = 0; direction < parameters.intrinsicDimensions; ++direction)
+        {
+            auto const latent = parameters.spread * normal(engine);
+            auto const * const vector = basis + direction * Descriptor::DIMENSIONS;
+
+            for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+            {
+                descriptor[dim] += latent * vector[dim];
+            }
+        }
+
+        Clamp(descriptor);
+    }
+
+    static void Clamp(Descriptor & descriptor) noexcept
+    {
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            descriptor[dim] = std::max(descriptor[dim], 0.0F);
+        }
+    }
+
+private:
+    float * Basis(size_t const cluster) noexcept
+    {
+        return bases.data() + cluster * parameters.intrinsicDimensions * Descriptor::DIMENSIONS;
+    }
+
+    MixtureParameters parameters;
+    std::vector<Descriptor> centers;
+    std::vector<float> bases;
+    std::discrete_distribution<size_t> component;
+};
+
+
+/*
+ * Coarse k-means lists with the references copied in list order, so a probe scans contiguous memory.
+ */
+struct IVFFlat
+{
+    std::vector<float> centroids;
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> ids;
+    std::vector<Descriptor> lists;
+};
+
+/*
+ * One byte per dimension: code = round((value - minimum) / scale) with a per-dimension range.
+ */
+struct ScalarQuantizer
+{
+    std::array<float, Descriptor::DIMENSIONS> minimum;
+    std::array<float, Descriptor::DIMENSIONS> scale;
+    std::vector<std::uint8_t> codes;
+};
+
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void;
+
+auto inline GenerateUniform(Dataset & dataset) -> void;
+auto inline GenerateClustered(Dataset & dataset, MixtureParameters const & parameters) -> void;
+
+auto inline WriteDataset(std::string_view const fileName, std::vector<Descriptor> const & descriptors) -> void;
+auto inline ReadDataset(std::string_view const fileName) -> std::vector<Descriptor>;
+auto inline LoadDataset(std::string_view const name, std::function<void(Dataset &)> const & generate) -> Dataset;
+
+auto inline LoadGroundTruth(Dataset & dataset) -> void;
+auto inline ComputeGroundTruth(Dataset & dataset) noexcept -> void;
+
+auto inline PushCandidate(std::vector<Candidate> & heap, size_t const size, float const distance, std::uint32_t const index) noexcept -> void;
+auto inline TakeNeighbours(std::vector<Candidate> & heap, std::uint32_t * const neighbours) noexcept -> void;
+auto inline Measure(Dataset const & dataset, std::function<void(Descriptor const &, std::uint32_t *)> const & search) noexcept -> Measurement;
+
+auto inline SquaredDistance(float const * const lhs, float const * const rhs, size_t const dims) noexcept -> float;
+auto inline Nearest(float const * const point, float const * const centroids, size_t const dims, size_t const k) noexcept -> size_t;
+auto inline KMeans(float const * const points, size_t const count, size_t const stride, size_t const dims, size_t const k, float * const centroids, std::mt19937 & engine) noexcept -> void;
+
+auto inline BuildIVFFlat(std::vector<Descriptor> const & references) -> IVFFlat;
+auto inline SearchIVFFlat(IVFFlat const & index, Descriptor const & query, size_t const nprobe, std::uint32_t * const neighbours) noexcept -> void;
+auto inline BuildScalarQuantizer(std::vector<Descriptor> const & references) -> ScalarQuantizer;
+auto inline SearchScalarQuantizer(ScalarQuantizer const & quantizer, std::vector<Descriptor> const & references, Descriptor const & query, size_t const shortlist, std::uint32_t * const neighbours) noexcept -> void;
+
+auto inline RunEngines(Dataset const & dataset, std::ofstream & csv) -> void;
+auto inline Report(std::ofstream & csv, Dataset const & dataset, std::string_view const engine, std::string_view const parameter, Measurement const & measurement, size_t const bytes) -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    try
+    {
+        std::ofstream csv{CSV_FILE.data()};
+
+        if (!csv.is_open())
+        {
+            throw std::runtime_error{std::format("Failed to open output file: {}", CSV_FILE)};
+        }
+
+        csv << CSV_HEADER;
+
+        auto uniform = LoadDataset("uniform", GenerateUniform);
+        LoadGroundTruth(uniform);
+        RunEngines(uniform, csv);
+
+        Cooldown();
+
+        auto clustered = LoadDataset("clustered", [](Dataset & dataset) { GenerateClustered(dataset, SIFT_LIKE); });
+        LoadGroundTruth(clustered);
+        RunEngines(clustered, csv);
+
+        std::cout << std::format("Results written to {}\n", CSV_FILE);
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+}
+
+/*
+ * The same i.i.d. U[0, 1) features as the other benchmarks.
+ */
+auto inline GenerateUniform(Dataset & dataset) -> void
+{
+    dataset.references.resize(NUM_OF_REFERENCES);
+    dataset.queries.resize(NUM_OF_QUERIES);
+}
+
+auto inline GenerateClustered(Dataset & dataset, MixtureParameters const & parameters) -> void
+{
+    std::mt19937 engine{SEED};
+    Mixture mixture{parameters, engine};
+
+    dataset.references.resize(NUM_OF_REFERENCES);
+    dataset.queries.resize(NUM_OF_QUERIES);
+
+    std::bernoulli_distribution duplicate{parameters.duplicateFraction};
+    std::normal_distribution<float> noise{0.0F, parameters.duplicateNoise};
+
+    for (size_t idx = 0; idx < NUM_OF_REFERENCES; ++idx)
+    {
+        auto & reference = dataset.references[idx];
+
+        if (idx == 0 || !duplicate(engine))
+        {
+            mixture.Sample(reference, engine);
+            continue;
+        }
+
+        reference = dataset.references[std::uniform_int_distribution<size_t>{0, idx - 1}(engine)];
+
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            reference[dim] += noise(engine);
+        }
+
+        Mixture::Clamp(reference);
+    }
+
+    for (auto & query : dataset.queries)
+    {
+        mixture.Sample(query, engine);
+    }
+}
+
+auto inline WriteDataset(std::string_view const fileName, std::vector<Descriptor> const & descriptors) -> void
+{
+    std::ofstream file{fileName.data(), std::ios::binary};
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error{std::format("Failed to open output file: {}", fileName)};
+    }
+
+    DatasetHeader const header{DATASET_MAGIC, DATASET_VERSION, Descriptor::DIMENSIONS, DataType::FLOAT32, descriptors.size(), PAYLOAD_ALIGNMENT, sizeof(DatasetHeader), sizeof(Descriptor), {}};
+
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    file.write(reinterpret_cast<char const *>(descriptors.data()), static_cast<std::streamsize>(descriptors.size() * sizeof(Descriptor)));
+
+    if (!file)
+    {
+        throw std::runtime_error{std::format("Failed to write dataset: {}", fileName)};
+    }
+}
+
+auto inline ReadDataset(std::string_view const fileName) -> std::vector<Descriptor>
+{
+    std::ifstream file{fileName.data(), std::ios::binary};
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error{std::format("Failed to open dataset: {}", fileName)};
+    }
+
+    std::vector<Descriptor> descriptors(ReadDatasetHeader<Descriptor>(file, fileName));
+
+    file.read(reinterpret_cast<char *>(descriptors.data()), static_cast<std::streamsize>(descriptors.size() * sizeof(Descriptor)));
+
+    if (!file)
+    {
+        throw std::runtime_error{std::format("Dataset {} is truncated", fileName)};
+    }
+
+    return descriptors;
+}
+
+/*
+ * Generates the dataset, writes it as ../<name>_base.dset and ../<name>_query.dset and reads it back, so the
+ * engines run on exactly what the other programs would map.
+ */
+auto inline LoadDataset(std::string_view const name, std::function<void(Dataset &)> const & generate) -> Dataset
+{
+    Dataset dataset{std::string{name}, {}, {}, {}};
+
+    auto const baseFile = std::format("../{}_base.dset", name);
+    auto const queryFile = std::format("../{}_query.dset", name);
+
+    std::cout << std::format("Starting Generating {} Dataset\n", name);
+
+    TestSpeed([&]
+    {
+        Dataset generated{};
+        generate(generated);
+
+        WriteDataset(baseFile, generated.references);
+        WriteDataset(queryFile, generated.queries);
+    }, "Generate");
+
+    dataset.references = ReadDataset(baseFile);
+    dataset.queries = ReadDataset(queryFile);
+
+    std::cout << std::format("Dataset {} : {} references, {} queries\n", name, dataset.references.size(), dataset.queries.size());
+
+    return dataset;
+}
+
+/*
+ * Reads ../<name>.gt when its header matches the dataset, otherwise computes the ground truth and caches it.
+ */
+auto inline LoadGroundTruth(Dataset & dataset) -> void
+{
+    auto const fileName = std::format("../{}.gt", dataset.name);
+    auto const fingerprint = Fingerprint(dataset.references.data(), dataset.references.size(), dataset.queries.data(), dataset.queries.size());
+    GroundTruthHeader const expected{GROUND_TRUTH_MAGIC, GROUND_TRUTH_VERSION, static_cast<std::uint32_t>(dataset.queries.size()), NUM_OF_NEIGHBOURS, fingerprint};
+
+    dataset.groundTruth.resize(dataset.queries.size() * NUM_OF_NEIGHBOURS);
+
+    if (std::ifstream cache{fileName, std::ios::binary}; cache.is_open())
+    {
+        GroundTruthHeader header{};
+        cache.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+        if (cache && header.magic == expected.magic && header.version == expected.version && header.queries == expected.queries && header.neighbours == expected.neighbours &&
+            header.fingerprint == expected.fingerprint)
+        {
+            cache.read(reinterpret_cast<char *>(dataset.groundTruth.data()), static_cast<std::streamsize>(dataset.groundTruth.size() * sizeof(std::uint32_t)));
+
+            if (cache)
+            {
+                std::cout << std::format("Ground truth loaded from {}\n", fileName);
+                return;
+            }
+        }
+    }
+
+    std::cout << std::format("Starting Computing Ground Truth for {}\n", dataset.name);
+    TestSpeed([&] { ComputeGroundTruth(dataset); }, "Ground Truth");
+
+    std::ofstream cache{fileName, std::ios::binary};
+
+    cache.write(reinterpret_cast<char const *>(&expected), sizeof(expected));
+    cache.write(reinterpret_cast<char const *>(dataset.groundTruth.data()), static_cast<std::streamsize>(dataset.groundTruth.size() * sizeof(std::uint32_t)));
+
+    if (!cache)
+    {
+        throw std::runtime_error{std::format("Failed to write ground truth: {}", fileName)};
+    }
+}
+
+auto inline ComputeGroundTruth(Dataset & dataset) noexcept -> void
+{
+    auto const queries = static_cast<std::int64_t>(dataset.queries.size());
+
+    #pragma omp parallel
+    {
+        std::vector<Candidate> heap;
+        heap.reserve(NUM_OF_NEIGHBOURS);
+
+        #pragma omp for schedule(dynamic)
+        for (std::int64_t query = 0; query < queries; ++query)
+        {
+            for (size_t reference = 0; reference < dataset.references.size(); ++reference)
+            {
+                PushCandidate(heap, NUM_OF_NEIGHBOURS, Descriptor::getL2Norm(dataset.queries[static_cast<size_t>(query)], dataset.references[reference]), static_cast<std::uint32_t>(reference));
+            }
+
+            TakeNeighbours(heap, dataset.groundTruth.data() + static_cast<size_t>(query) * NUM_OF_NEIGHBOURS);
+        }
+    }
+}
+
+auto inline PushCandidate(std::vector<Candidate> & heap, size_t const size, float const distance, std::uint32_t const index) noexcept -> void
+{
+    if (heap.size() < size)
+    {
+        heap.push_back(Candidate{distance, index});
+        std::push_heap(heap.begin(), heap.end());
+    }
+    else if (distance < heap.front().distance)
+    {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = Candidate{distance, index};
+        std::push_heap(heap.begin(), heap.end());
+    }
+}
+
+/*
+ * Writes the NUM_OF_NEIGHBOURS closest candidates of the heap in increasing distance and empties it.
+ */
+auto inline TakeNeighbours(std::vector<Candidate> & heap, std::uint32_t * const neighbours) noexcept -> void
+{
+    std::sort_heap(heap.begin(), heap.end());
+
+    for (size_t rank = 0; rank < NUM_OF_NEIGHBOURS; ++rank)
+    {
+        neighbours[rank] = rank < heap.size() ? heap[rank].index : std::numeric_limits<std::uint32_t>::max();
+    }
+
+    heap.clear();
+}
+
+/*
+ * Runs the search for every query on all threads and scores it against the ground truth, ignoring the order
+ * within the top NUM_OF_NEIGHBOURS.
+ */
+auto inline Measure(Dataset const & dataset, std::function<void(Descriptor const &, std::uint32_t *)> const & search) noexcept -> Measurement
+{
+    auto const queries = static_cast<std::int64_t>(dataset.queries.size());
+    Neighbours results(dataset.queries.size() * NUM_OF_NEIGHBOURS);
+
+    auto const start = std::chrono::steady_clock::now();
+
+    #pragma omp parallel for schedule(dynamic)
+    for (std::int64_t query = 0; query < queries; ++query)
+    {
+        search(dataset.queries[static_cast<size_t>(query)], results.data() + static_cast<size_t>(query) * NUM_OF_NEIGHBOURS);
+    }
+
+    auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t hits{0};
+
+    for (size_t query = 0; query < dataset.queries.size(); ++query)
+    {
+        auto const * const truth = dataset.groundTruth.data() + query * NUM_OF_NEIGHBOURS;
+        auto const * const found = results.data() + query * NUM_OF_NEIGHBOURS;
+
+        hits += static_cast<size_t>(std::count_if(found, found + NUM_OF_NEIGHBOURS, [truth](auto const id) { return std::find(truth, truth + NUM_OF_NEIGHBOURS, id) != truth + NUM_OF_NEIGHBOURS; }));
+    }
+
+    return Measurement{static_cast<double>(hits) / static_cast<double>(dataset.queries.size() * NUM_OF_NEIGHBOURS) * 100.0, static_cast<double>(queries) / seconds};
+}
+
+auto inline SquaredDistance(float const * const lhs, float const * const rhs, size_t const dims) noexcept -> float
+{
+    float sum{0.0};
+
+    for (size_t dim = 0; dim < dims; ++dim)
+    {
+        auto const diff = lhs[dim] - rhs[dim];
+        sum += diff * diff;
+    }
+
+    return sum;
+}
+
+auto inline Nearest(float const * const point, float const * const centroids, size_t const dims, size_t const k) noexcept -> size_t
+{
+    float minDistance = std::numeric_limits<float>::max();
+    size_t minIndex{0};
+
+    for (size_t centroid = 0; centroid < k; ++centroid)
+    {
+        auto const distance = SquaredDistance(point, centroids + centroid * dims, dims);
+
+        if (distance < minDistance)
+        {
+            minDistance = distance;
+            minIndex = centroid;
+        }
+    }
+
+    return minIndex;
+}
+
+/*
+ * Lloyd iterations over count points of dims floats placed stride floats apart. The centroids start on
+ * distinct random points and an emptied centroid is moved to a random point.
+ */
+auto inline KMeans(float const * const points, size_t const count, size_t const stride, size_t const dims, size_t const k, float * const centroids, std::mt19937 & engine) noexcept -> void
+{
+    std::vector<std::uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0U);
+    std::shuffle(order.begin(), order.end(), engine);
+
+    for (size_t centroid = 0; centroid < k; ++centroid)
+    {
+        std::copy_n(points + order[centroid] * stride, dims, centroids + centroid * dims);
+    }
+
+    std::vector<std::uint32_t> assignment(count);
+    std::vector<double> sums(k * dims);
+    std::vector<size_t> sizes(k);
+    std::uniform_int_distribution<size_t> pick{0, count - 1};
+
+    for (size_t iteration = 0; iteration < KMEANS_ITERATIONS; ++iteration)
+    {
+        #pragma omp parallel for
+        for (size_t idx = 0; idx < count; ++idx)
+        {
+            assignment[idx] = static_cast<std::uint32_t>(Nearest(points + idx * stride, centroids, dims, k));
+        }
+
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(sizes.begin(), sizes.end(), 0UL);
+
+        for (size_t idx = 0; idx < count; ++idx)
+        {
+            auto const centroid = assignment[idx];
+            ++sizes[centroid];
+
+            for (size_t dim = 0; dim < dims; ++dim)
+            {
+                sums[centroid * dims + dim] += static_cast<double>(points[idx * stride + dim]);
+            }
+        }
+
+        for (size_t centroid = 0; centroid < k; ++centroid)
+        {
+            if (sizes[centroid] == 0)
+            {
+                std::copy_n(points + pick(engine) * stride, dims, centroids + centroid * dims);
+                continue;
+            }
+
+            for (size_t dim = 0; dim < dims; ++dim)
+            {
+                centroids[centroid * dims + dim] = static_cast<float>(sums[centroid * dims + dim] / static_cast<double>(sizes[centroid]));
+            }
+        }
+    }
+}
+
+/*
+ * Trains the coarse quantizer on the first KMEANS_SAMPLE references and groups all of them by list (CSR).
+ */
+auto inline BuildIVFFlat(std::vector<Descriptor> const & references) -> IVFFlat
+{
+    constexpr auto stride = sizeof(Descriptor) / sizeof(float);
+
+    IVFFlat index{std::vector<float>(NUM_OF_LISTS * Descriptor::DIMENSIONS), std::vector<std::uint32_t>(NUM_OF_LISTS + 1, 0U), std::vector<std::uint32_t>(references.size()), {}};
+    std::mt19937 engine{SEED};
+
+    KMeans(&references[0][0], std::min<size_t>(KMEANS_SAMPLE, references.size()), stride, Descriptor::DIMENSIONS, NUM_OF_LISTS, index.centroids.data(), engine);
+
+    std::vector<std::uint32_t> assignment(references.size());
+
+    #pragma omp parallel for
+    for (size_t idx = 0; idx < references.size(); ++idx)
+    {
+        assignment[idx] = static_cast<std::uint32_t>(Nearest(&references[idx][0], index.centroids.data(), Descriptor::DIMENSIONS, NUM_OF_LISTS));
+    }
+
+    for (auto const list : assignment)
+    {
+        ++index.offsets[list + 1];
+    }
+
+    std::partial_sum(index.offsets.begin(), index.offsets.end(), index.offsets.begin());
+
+    std::vector<std::uint32_t> cursor(index.offsets.begin(), index.offsets.end() - 1);
+    index.lists.resize(references.size());
+
+    for (size_t idx = 0; idx < references.size(); ++idx)
+    {
+        auto const position = cursor[assignment[idx]]++;
+
+        index.ids[position] = static_cast<std::uint32_t>(idx);
+        index.lists[position] = references[idx];
+    }
+
+    return index;
+}
+
+auto inline SearchIVFFlat(IVFFlat const & index, Descriptor const & query, size_t const nprobe, std::uint32_t * const neighbours) noexcept -> void
+{
+    std::array<Candidate, NUM_OF_LISTS> lists{};
+
+    for (size_t list = 0; list < NUM_OF_LISTS; ++list)
+    {
+        lists[list] = Candidate{SquaredDistance(&query[0], index.centroids.data() + list * Descriptor::DIMENSIONS, Descriptor::DIMENSIONS), static_cast<std::uint32_t>(list)};
+    }
+
+    std::partial_sort(lists.begin(), lists.begin() + static_cast<std::ptrdiff_t>(nprobe), lists.end());
+
+    std::vector<Candidate> heap;
+    heap.reserve(NUM_OF_NEIGHBOURS);
+
+    for (size_t probe = 0; probe < nprobe; ++probe)
+    {
+        auto const list = lists[probe].index;
+
+        for (auto position = index.offsets[list]; position < index.offsets[list + 1]; ++position)
+        {
+            PushCandidate(heap, NUM_OF_NEIGHBOURS, Descriptor::getL2Norm(query, index.lists[position]), index.ids[position]);
+        }
+    }
+
+    TakeNeighbours(heap, neighbours);
+}
+
+auto inline BuildScalarQuantizer(std::vector<Descriptor> const & references) -> ScalarQuantizer
+{
+    ScalarQuantizer quantizer{};
+
+    quantizer.minimum.fill(std::numeric_limits<float>::max());
+    std::array<float, Descriptor::DIMENSIONS> maximum{};
+    maximum.fill(std::numeric_limits<float>::lowest());
+
+    for (auto const & reference : references)
+    {
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            quantizer.minimum[dim] = std::min(quantizer.minimum[dim], reference[dim]);
+            maximum[dim] = std::max(maximum[dim], reference[dim]);
+        }
+    }
+
+    for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+    {
+        quantizer.scale[dim] = std::max(maximum[dim] - quantizer.minimum[dim], std::numeric_limits<float>::min()) / static_cast<float>(SQ8_LEVELS);
+    }
+
+    quantizer.codes.resize(references.size() * Descriptor::DIMENSIONS);
+
+    for (size_t idx = 0; idx < references.size(); ++idx)
+    {
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            auto const level = std::round((references[idx][dim] - quantizer.minimum[dim]) / quantizer.scale[dim]);
+            quantizer.codes[idx * Descriptor::DIMENSIONS + dim] = static_cast<std::uint8_t>(std::clamp(level, 0.0F, static_cast<float>(SQ8_LEVELS)));
+        }
+    }
+
+    return quantizer;
+}
+
+/*
+ * Scans the codes with a squared difference in integers (the scales are ignored, which only matters when the
+ * ranges of the dimensions differ a lot) and re-ranks the shortlist with the exact kernel.
+ */
+auto inline SearchScalarQuantizer(ScalarQuantizer const & quantizer, std::vector<Descriptor> const & references, Descriptor const & query, size_t const shortlist, std::uint32_t * const neighbours) noexcept -> void
+{
+    alignas(ALIGN) std::array<std::int32_t, Descriptor::DIMENSIONS> code{};
+
+    for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+    {
+        auto const level = std::round((query[dim] - quantizer.minimum[dim]) / quantizer.scale[dim]);
+        code[dim] = static_cast<std::int32_t>(std::clamp(level, 0.0F, static_cast<float>(SQ8_LEVELS)));
+    }
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(shortlist);
+
+    for (size_t idx = 0; idx < references.size(); ++idx)
+    {
+        auto const * const codes = quantizer.codes.data() + idx * Descriptor::DIMENSIONS;
+        std::int32_t distance{0};
+
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            auto const diff = code[dim] - static_cast<std::int32_t>(codes[dim]);
+            distance += diff * diff;
+        }
+
+        PushCandidate(candidates, shortlist, static_cast<float>(distance), static_cast<std::uint32_t>(idx));
+    }
+
+    std::vector<Candidate> heap;
+    heap.reserve(NUM_OF_NEIGHBOURS);
+
+    for (auto const & candidate : candidates)
+    {
+        PushCandidate(heap, NUM_OF_NEIGHBOURS, Descriptor::getL2Norm(query, references[candidate.index]), candidate.index);
+    }
+
+    TakeNeighbours(heap, neighbours);
+}
+
+auto inline RunEngines(Dataset const & dataset, std::ofstream & csv) -> void
+{
+    auto const & references = dataset.references;
+    auto const floatBytes = references.size() * sizeof(Descriptor);
+
+    std::cout << std::format("Starting Engines on {} Dataset ({} threads)\n", dataset.name, omp_get_max_threads());
+
+    auto const exact = Measure(dataset, [&references](Descriptor const & query, std::uint32_t * const neighbours)
+    {
+        std::vector<Candidate> heap;
+        heap.reserve(NUM_OF_NEIGHBOURS);
+
+        for (size_t idx = 0; idx < references.size(); ++idx)
+        {
+            PushCandidate(heap, NUM_OF_NEIGHBOURS, Descriptor::getL2Norm(query, references[idx]), static_cast<std::uint32_t>(idx));
+        }
+
+        TakeNeighbours(heap, neighbours);
+    });
+
+    Report(csv, dataset, "Brute force", "-", exact, floatBytes);
+
+    IVFFlat index{};
+    TestSpeed([&] { index = BuildIVFFlat(references); }, "IVF-Flat Build");
+
+    auto const ivfBytes = index.lists.size() * sizeof(Descriptor) + index.ids.size() * sizeof(std::uint32_t) + index.centroids.size() * sizeof(float) + index.offsets.size() * sizeof(std::uint32_t);
+
+    for (auto const nprobe : NPROBE)
+    {
+        auto const measurement = Measure(dataset, [&index, nprobe](Descriptor const & query, std::uint32_t * const neighbours) { SearchIVFFlat(index, query, nprobe, neighbours); });
+        Report(csv, dataset, "IVF-Flat", std::format("nprobe={}", nprobe), measurement, ivfBytes);
+    }
+
+    ScalarQuantizer quantizer{};
+    TestSpeed([&] { quantizer = BuildScalarQuantizer(references); }, "SQ8 Build");
+
+    /* The codes are scanned and only the shortlist touches the floats, which could stay on disk */
+    auto const codeBytes = quantizer.codes.size() + 2 * sizeof(quantizer.minimum);
+
+    for (auto const shortlist : SHORTLIST)
+    {
+        auto const measurement = Measure(dataset, [&quantizer, &references, shortlist](Descriptor const & query, std::uint32_t * const neighbours)
+        {
+            SearchScalarQuantizer(quantizer, references, query, shortlist, neighbours);
+        });
+
+        Report(csv, dataset, "SQ8", std::format("shortlist={}", shortlist), measurement, codeBytes);
+    }
+}
+
+auto inline Report(std::ofstream & csv, Dataset const & dataset, std::string_view const engine, std::string_view const parameter, Measurement const & measurement, size_t const bytes) -> void
+{
+    auto const megabytes = static_cast<double>(bytes) / 1e6;
+
+    std::cout << std::format("{:<11} {:<13} : Recall@{} {:6.2f}%, {:>9.1f} queries/s, {:7.2f} MB\n", engine, parameter, static_cast<size_t>(NUM_OF_NEIGHBOURS), measurement.recall,
+                             measurement.queriesPerSecond, megabytes);
+    csv << std::format("{},{},{},{},{:.4f},{:.2f},{},{:.3f}\n", dataset.name, engine, parameter, static_cast<size_t>(NUM_OF_NEIGHBOURS), measurement.recall,
+                       measurement.queriesPerSecond, omp_get_max_threads(), megabytes);
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -0,0 +1,705 @@
+/*
+## Early Abandon
+
+The pairwise kernels are split into 4 checkpoints of 32 dimensions. After each checkpoint the partial sum
+is reduced and compared against the best distance found so far for the query; once it is larger the
+candidate cannot win and the remaining dimensions are skipped. The accumulation order is the same as in the
+full kernel and all terms are non-negative, so a completed evaluation is bit-identical to getL1Norm/getL2Norm
+and an abandoned one is a true lower bound: the checksums stay unchanged.
+
+The optional reordering sorts the 8 groups of 16 dimensions of every query by their expected contribution
+against the reference set, (q - mean)^2 + variance, so the largest terms land in the first checkpoints.
+Because this changes the summation order, the reordered pass only prunes (with a small relative slack that
+covers the rounding difference) and the survivors are re-evaluated with the exact kernel.
+
+A group is one cache line, so a checkpoint touches two lines of the candidate either way. With groups of 8
+dimensions the first checkpoint was spread over four lines and the reordered L2 pass ran about 50 % slower
+than the plain one while evaluating the same share of dimensions. It still does not pay off on this data:
+the plain order already abandons most candidates at the first checkpoint (27.85 % against 26.10 % of the
+dimensions for L2 on the clustered set), which leaves nothing for the per-query sort and the indirect
+offsets to win back, so the reordered pass stays 5-10 % behind the plain one.
+
+Both variants are benchmarked on the seeded uniform data and on a clustered Gaussian mixture with
+heterogeneous per-dimension spread, which is closer to real descriptors.
+
+Usage: DistanceEarlyAbandon [dataset]. Given the name of a DistanceDataset dataset, only its .dset files are
+searched and both L2 early-abandon passes are scored against its cached .gt and appended to ../recall.csv.
+*/
+
+#include "Dataset.hpp"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <new>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+#define CHECKPOINT(BOUND)             REDUCE_SUM(result, sum);  /* Reduce the partial sum */           \
+                                      ++checkpoints;            /* Count the evaluated checkpoint */   \
+                                      if (result > BOUND)       /* The candidate can no longer win */  \
+                                      {                                                                \
+                                          return result;                                               \
+                                      }
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    FLOAT_GROUP_SIZE = 16,
+    NUM_OF_GROUPS = 8,
+    NUM_OF_CHECKPOINTS = 4,
+    NUM_OF_CLUSTERS = 64,
+};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        return std::sqrt(getSquaredL2Norm(lhs, rhs));
+    }
+
+    static float getSquaredL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    /*
+     * Same accumulation order as getL1Norm, abandoned as soon as a checkpoint exceeds the bound. The returned
+     * value is then a lower bound larger than the bound, otherwise it is the exact distance.
+     */
+    static float getL1NormBounded(Descriptor const & lhs, Descriptor const & rhs, float const bound, size_t & checkpoints) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+        float result{0.0};
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        CHECKPOINT(bound);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        CHECKPOINT(bound);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        CHECKPOINT(bound);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+        CHECKPOINT(bound);
+
+        return result;
+    }
+
+    /*
+     * Squared L2 counterpart of getL1NormBounded (the bound is a squared distance as well).
+     */
+    static float getSquaredL2NormBounded(Descriptor const & lhs, Descriptor const & rhs, float const bound, size_t & checkpoints) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+        float result{0.0};
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        CHECKPOINT(bound);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        CHECKPOINT(bound);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        CHECKPOINT(bound);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+        CHECKPOINT(bound);
+
+        return result;
+    }
+
+    /*
+     * Bounded kernels that visit the 16-float groups in the given order (offsets into the features).
+     */
+    static float getL1NormOrdered(Descriptor const & lhs, Descriptor const & rhs, size_t const * const order, float const bound, size_t & checkpoints) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+        float result{0.0};
+
+        #pragma GCC unroll 4
+        for (size_t group = 0; group < NUM_OF_GROUPS; group += NUM_OF_GROUPS / NUM_OF_CHECKPOINTS)
+        {
+            L1_NORM(lhs, rhs, order[group + 0]);
+            L1_NORM(lhs, rhs, order[group + 0] + FLOAT_VECTOR_SIZE);
+            L1_NORM(lhs, rhs, order[group + 1]);
+            L1_NORM(lhs, rhs, order[group + 1] + FLOAT_VECTOR_SIZE);
+            CHECKPOINT(bound);
+        }
+
+        return result;
+    }
+
+    static float getSquaredL2NormOrdered(Descriptor const & lhs, Descriptor const & rhs, size_t const * const order, float const bound, size_t & checkpoints) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+        float result{0.0};
+
+        #pragma GCC unroll 4
+        for (size_t group = 0; group < NUM_OF_GROUPS; group += NUM_OF_GROUPS / NUM_OF_CHECKPOINTS)
+        {
+            L2_NORM(lhs, rhs, order[group + 0]);
+            L2_NORM(lhs, rhs, order[group + 0] + FLOAT_VECTOR_SIZE);
+            L2_NORM(lhs, rhs, order[group + 1]);
+            L2_NORM(lhs, rhs, order[group + 1] + FLOAT_VECTOR_SIZE);
+            CHECKPOINT(bound);
+        }
+
+        return result;
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+/*
+ * Relative slack used when pruning with a reordered summation, well above the worst-case rounding difference
+ * of a 128-term float sum.
+ */
+static constexpr float REORDER_SLACK{1.0F + 1e-4F};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesAbandonL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesAbandonL2[NUM_OF_POINTS];
+
+alignas(ALIGN) float dimensionMean[Descriptor::DIMENSIONS];
+alignas(ALIGN) float dimensionVariance[Descriptor::DIMENSIONS];
+
+static size_t evaluatedCheckpoints{0};
+
+static GroundTruth groundTruth{};
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, std::string_view const message) noexcept -> void;
+auto inline ReportPruning(std::string_view const message) noexcept -> void;
+
+auto inline CompareL1() noexcept -> void;
+auto inline CompareL2() noexcept -> void;
+
+auto inline CompareL1EarlyAbandon(bool const reorder) noexcept -> void;
+auto inline CompareL2EarlyAbandon(bool const reorder) noexcept -> void;
+
+auto inline ComputeStatistics() noexcept -> void;
+auto inline ComputeOrder(Descriptor const & query, size_t * const order) noexcept -> void;
+
+auto inline GenerateClustered() noexcept -> void;
+
+auto inline RunBenchmarks(std::string_view const dataset) -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main(int const argc, char const * const argv[])
+{
+    try
+    {
+        if (argc > 2)
+        {
+            std::cerr << "Usage: DistanceEarlyAbandon [dataset]\n";
+            return EXIT_FAILURE;
+        }
+
+        if (argc == 2)
+        {
+            groundTruth = LoadDataset(argv[1], set1, set2, NUM_OF_POINTS);
+            RunBenchmarks(argv[1]);
+
+            return 0;
+        }
+
+        RunBenchmarks("Uniform");
+
+        Cooldown();
+
+        GenerateClustered();
+        RunBenchmarks("Clustered");
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline RunBenchmarks(std::string_view const dataset) -> void
+{
+    std::cout << std::format("Starting Comparing L1 Norm ({})\n", dataset);
+    TestSpeed(CompareL1, "CompareL1");
+
+    ComputeChecksum(indicesL1, "L1 Norm");
+
+    Cooldown();
+
+    std::cout << std::format("Starting Comparing L1 Norm ({}, Early Abandon)\n", dataset);
+    TestSpeed([] { CompareL1EarlyAbandon(false); }, "CompareL1EarlyAbandon");
+
+    ComputeChecksum(indicesAbandonL1, "L1 Norm (Early Abandon)");
+    CountMismatches(indicesL1, indicesAbandonL1, "L1 Norm (Early Abandon)");
+    ReportPruning("L1 Norm (Early Abandon)");
+
+    Cooldown();
+
+    std::cout << std::format("Starting Comparing L1 Norm ({}, Early Abandon, Reordered)\n", dataset);
+    TestSpeed([] { CompareL1EarlyAbandon(true); }, "CompareL1EarlyAbandonReordered");
+
+    ComputeChecksum(indicesAbandonL1, "L1 Norm (Early Abandon, Reordered)");
+    CountMismatches(indicesL1, indicesAbandonL1, "L1 Norm (Early Abandon, Reordered)");
+    ReportPruning("L1 Norm (Early Abandon, Reordered)");
+
+    Cooldown();
+
+    std::cout << std::format("Starting Comparing L2 Norm ({})\n", dataset);
+    TestSpeed(CompareL2, "CompareL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    Cooldown();
+
+    std::cout << std::format("Starting Comparing L2 Norm ({}, Early Abandon)\n", dataset);
+    auto const plain_ms = TestSpeed([] { CompareL2EarlyAbandon(false); }, "CompareL2EarlyAbandon");
+
+    ComputeChecksum(indicesAbandonL2, "L2 Norm (Early Abandon)");
+    CountMismatches(indicesL2, indicesAbandonL2, "L2 Norm (Early Abandon)");
+    ReportPruning("L2 Norm (Early Abandon)");
+
+    auto const plainQueriesPerSecond = static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(plain_ms, 1L)) / 1e3);
+    AppendRecall(groundTruth, "EarlyAbandon", "plain", 1, GroundTruthRecall(groundTruth, indicesAbandonL2, NUM_OF_POINTS), plainQueriesPerSecond, 1, sizeof(set2));
+
+    Cooldown();
+
+    std::cout << std::format("Starting Comparing L2 Norm ({}, Early Abandon, Reordered)\n", dataset);
+    auto const reordered_ms = TestSpeed([] { CompareL2EarlyAbandon(true); }, "CompareL2EarlyAbandonReordered");
+
+    ComputeChecksum(indicesAbandonL2, "L2 Norm (Early Abandon, Reordered)");
+    CountMismatches(indicesL2, indicesAbandonL2, "L2 Norm (Early Abandon, Reordered)");
+    ReportPruning("L2 Norm (Early Abandon, Reordered)");
+
+    auto const reorderedQueriesPerSecond = static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(reordered_ms, 1L)) / 1e3);
+    AppendRecall(groundTruth, "EarlyAbandon", "reordered", 1, GroundTruthRecall(groundTruth, indicesAbandonL2, NUM_OF_POINTS), reorderedQueriesPerSecond, 1,
+                 sizeof(set2) + sizeof(dimensionMean) + sizeof(dimensionVariance));
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+
+    return time_ms;
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, std::string_view const message) noexcept -> void
+{
+    auto const mismatches = std::transform_reduce(lhs, lhs + NUM_OF_POINTS, rhs, 0UL, std::plus<>(), std::not_equal_to<>());
+    std::cout << std::format("Mismatches for {} : {} / {}\n", message, mismatches, static_cast<size_t>(NUM_OF_POINTS));
+}
+
+auto inline ReportPruning(std::string_view const message) noexcept -> void
+{
+    auto constexpr total = static_cast<double>(NUM_OF_POINTS) * static_cast<double>(NUM_OF_POINTS) * static_cast<double>(NUM_OF_CHECKPOINTS);
+    auto const evaluated = 100.0 * static_cast<double>(evaluatedCheckpoints) / total;
+    std::cout << std::format("Dimensions evaluated for {} : {:.2f} %\n", message, evaluated);
+}
+
+
+auto inline CompareL1() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL1Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL2() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL2Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL1EarlyAbandon(bool const reorder) noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    alignas(ALIGN) size_t order[NUM_OF_GROUPS];
+
+    evaluatedCheckpoints = 0;
+
+    if (reorder)
+    {
+        ComputeStatistics();
+    }
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        if (reorder)
+        {
+            ComputeOrder(set1[idx1], order);
+        }
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            if (reorder)
+            {
+                float const bound = minDistance * REORDER_SLACK;
+
+                if (Descriptor::getL1NormOrdered(set1[idx1], set2[idx2], order, bound, evaluatedCheckpoints) > bound)
+                {
+                    continue;
+                }
+
+                currentDistance = Descriptor::getL1Norm(set1[idx1], set2[idx2]);
+            }
+            else
+            {
+                currentDistance = Descriptor::getL1NormBounded(set1[idx1], set2[idx2], minDistance, evaluatedCheckpoints);
+            }
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesAbandonL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL2EarlyAbandon(bool const reorder) noexcept -> void
+{
+    float minDistance{0.0};
+    float minSquaredDistance{0.0};
+    float currentSquaredDistance{0.0};
+    float currentDistance{0.0};
+
+    alignas(ALIGN) size_t order[NUM_OF_GROUPS];
+
+    evaluatedCheckpoints = 0;
+
+    if (reorder)
+    {
+        ComputeStatistics();
+    }
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+        minSquaredDistance = std::numeric_limits<float>::max();
+
+        if (reorder)
+        {
+            ComputeOrder(set1[idx1], order);
+        }
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            if (reorder)
+            {
+                float const bound = minSquaredDistance * REORDER_SLACK;
+
+                if (Descriptor::getSquaredL2NormOrdered(set1[idx1], set2[idx2], order, bound, evaluatedCheckpoints) > bound)
+                {
+                    continue;
+                }
+
+                currentSquaredDistance = Descriptor::getSquaredL2Norm(set1[idx1], set2[idx2]);
+            }
+            else
+            {
+                currentSquaredDistance = Descriptor::getSquaredL2NormBounded(set1[idx1], set2[idx2], minSquaredDistance, evaluatedCheckpoints);
+
+                if (currentSquaredDistance > minSquaredDistance)
+                {
+                    continue;
+                }
+            }
+
+            /* The square root is kept so ties resolve exactly like getL2Norm */
+            currentDistance = std::sqrt(currentSquaredDistance);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                minSquaredDistance = currentSquaredDistance;
+                indicesAbandonL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline ComputeStatistics() noexcept -> void
+{
+    std::fill(dimensionMean, dimensionMean + Descriptor::DIMENSIONS, 0.0F);
+    std::fill(dimensionVariance, dimensionVariance + Descriptor::DIMENSIONS, 0.0F);
+
+    for (auto const & descriptor: set2)
+    {
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            dimensionMean[dim] += descriptor[dim];
+            dimensionVariance[dim] += descriptor[dim] * descriptor[dim];
+        }
+    }
+
+    for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+    {
+        dimensionMean[dim] /= static_cast<float>(NUM_OF_POINTS);
+        dimensionVariance[dim] = dimensionVariance[dim] / static_cast<float>(NUM_OF_POINTS) - dimensionMean[dim] * dimensionMean[dim];
+    }
+}
+
+auto inline ComputeOrder(Descriptor const & query, size_t * const order) noexcept -> void
+{
+    float contribution[NUM_OF_GROUPS]{};
+    float deviation{0.0};
+
+    for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+    {
+        deviation = query[dim] - dimensionMean[dim];
+        contribution[dim / FLOAT_GROUP_SIZE] += deviation * deviation + dimensionVariance[dim];
+    }
+
+    std::iota(order, order + NUM_OF_GROUPS, 0UL);
+    std::sort(order, order + NUM_OF_GROUPS, [&](size_t const lhs, size_t const rhs) -> bool { return contribution[lhs] > contribution[rhs]; });
+    std::transform(order, order + NUM_OF_GROUPS, order, [](size_t const group) -> size_t { return group * FLOAT_GROUP_SIZE; });
+}
+
+auto inline GenerateClustered() noexcept -> void
+{
+    std::mt19937 randomEngine{SEED};
+    std::uniform_real_distribution<float> uniformDistribution{0.0, 1.0};
+    std::uniform_int_distribution<size_t> clusterDistribution{0, NUM_OF_CLUSTERS - 1};
+    std::normal_distribution<float> normalDistribution{0.0, 1.0};
+
+    alignas(ALIGN) float amplitude[Descriptor::DIMENSIONS];
+    alignas(ALIGN) float spread[Descriptor::DIMENSIONS];
+    alignas(ALIGN) float centers[NUM_OF_CLUSTERS][Descriptor::DIMENSIONS];
+
+    /* Heterogeneous dimensions: a few carry most of the variance, like real gradient histograms */
+    for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+    {
+        float const weight = uniformDistribution(randomEngine);
+        amplitude[dim] = weight * weight * weight;
+        spread[dim] = 0.01F + 0.05F * weight;
+    }
+
+    for (auto & center: centers)
+    {
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            center[dim] = 0.5F + amplitude[dim] * (uniformDistribution(randomEngine) - 0.5F);
+        }
+    }
+
+    for (auto * const set: {set1, set2})
+    {
+        for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+        {
+            auto const & center = centers[clusterDistribution(randomEngine)];
+
+            for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+            {
+                set[idx][dim] = std::clamp(center[dim] + spread[dim] * normalDistribution(randomEngine), 0.0F, 1.0F);
+            }
+        }
+    }
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
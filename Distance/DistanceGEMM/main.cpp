@@ -0,0 +1,390 @@
+/*
+## GEMM Formulation
+
+For the L2 norm, ||q - r||^2 = ||q||^2 + ||r||^2 - 2 * q.r, so the all-pairs comparison is one matrix
+multiplication plus a norm add. ||q||^2 is constant for a query and the square root is monotone, so
+neither affects the argmin and both are dropped: the kernel ranks on ||r||^2 - 2 * q.r.
+
+The multiplication is a blocked AVX2/FMA SGEMM with the same register tiling idea as
+GPU/MatrixMultiply/multiply.cl: a 6 x 16 micro-tile of accumulators (12 ymm) is updated with broadcasts of
+the packed queries and aligned loads of the packed references. The argmin is fused in the epilogue of every
+micro-tile, so the 10k x 10k distance matrix is never materialized; each query only keeps 16 running minima
+(one per lane), which are finally re-ranked with the exact pairwise kernel so near-ties resolve like the
+pairwise search.
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <new>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+#define MAGNITUDE(VALUE, IDX)         left = _mm256_load_ps(VALUE.features + IDX); /* Load 8 floats into a vector */           \
+                                      sum = _mm256_fmadd_ps(left, left, sum);      /* Accumulate the squared components */
+
+#define GEMM_ROW(ROW)                 broadcast = _mm256_broadcast_ss(lhs + dim * TILE_QUERIES + ROW);       /* Broadcast one query component */   \
+                                      acc##ROW##0 = _mm256_fmadd_ps(broadcast, right0, acc##ROW##0);         /* Multiply with the first 8 refs */  \
+                                      acc##ROW##1 = _mm256_fmadd_ps(broadcast, right1, acc##ROW##1);         /* Multiply with the last 8 refs */
+
+#define ARGMIN_HALF(ROW, HALF)        distance = _mm256_fnmadd_ps(two, acc##ROW##HALF, norm##HALF);                                                     /* ||r||^2 - 2 * q.r */             \
+                                      best = _mm256_load_ps(bestDistances[query + ROW] + HALF * FLOAT_VECTOR_SIZE);                                     /* Load the running minima */       \
+                                      mask = _mm256_cmp_ps(distance, best, _CMP_LT_OQ);                                                                 /* Lanes that improved */           \
+                                      _mm256_store_ps(bestDistances[query + ROW] + HALF * FLOAT_VECTOR_SIZE,                                                                                \
+                                                      _mm256_blendv_ps(best, distance, mask));                                                          /* Keep the smaller distance */     \
+                                      slot = reinterpret_cast<__m256i *>(bestIndices[query + ROW] + HALF * FLOAT_VECTOR_SIZE);                          /* Running indices as integers */   \
+                                      index = _mm256_castsi256_ps(_mm256_load_si256(slot));                                                             /* Load them for the float blend */ \
+                                      _mm256_store_si256(slot, _mm256_castps_si256(_mm256_blendv_ps(index, _mm256_castsi256_ps(indices##HALF), mask))); /* Keep the matching index */
+
+#define ARGMIN_ROW(ROW)               ARGMIN_HALF(ROW, 0) \
+                                      ARGMIN_HALF(ROW, 1)
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    TILE_QUERIES = 6,
+    TILE_REFERENCES = 2 * FLOAT_VECTOR_SIZE,
+    BLOCK_REFERENCES = 256,
+    NUM_OF_QUERY_PANELS = (NUM_OF_POINTS + TILE_QUERIES - 1) / TILE_QUERIES,
+    NUM_OF_REFERENCE_PANELS = (NUM_OF_POINTS + TILE_REFERENCES - 1) / TILE_REFERENCES,
+    PANELS_PER_BLOCK = BLOCK_REFERENCES / TILE_REFERENCES,
+};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        return std::sqrt(getSquaredL2Norm(lhs, rhs));
+    }
+
+    static float getSquaredL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getSquaredMagnitude(Descriptor const & value) noexcept
+    {
+        __m256 left;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        MAGNITUDE(value, 0 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 1 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 2 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 3 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 4 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 5 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 6 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 7 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 8 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 9 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 10 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 11 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 12 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 13 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 14 * FLOAT_VECTOR_SIZE);
+        MAGNITUDE(value, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    float operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesGEMM[NUM_OF_POINTS];
+
+/*
+ * Packed operands: queries as [panel][dim][6] so a micro-tile broadcasts one scalar per query row, references
+ * as [panel][dim][16] so a micro-tile loads two aligned vectors per dimension. Padded references get an
+ * infinite norm so they never win the argmin.
+ */
+alignas(ALIGN) float packedQueries[NUM_OF_QUERY_PANELS][Descriptor::DIMENSIONS][TILE_QUERIES];
+alignas(ALIGN) float packedReferences[NUM_OF_REFERENCE_PANELS][Descriptor::DIMENSIONS][TILE_REFERENCES];
+alignas(ALIGN) float referenceNorms[NUM_OF_REFERENCE_PANELS * TILE_REFERENCES];
+
+alignas(ALIGN) float bestDistances[NUM_OF_QUERY_PANELS * TILE_QUERIES][TILE_REFERENCES];
+alignas(ALIGN) std::int32_t bestIndices[NUM_OF_QUERY_PANELS * TILE_QUERIES][TILE_REFERENCES];
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, std::string_view const message) noexcept -> void;
+
+auto inline CompareL2() noexcept -> void;
+auto inline CompareL2GEMM() noexcept -> void;
+
+auto inline PackOperands() noexcept -> void;
+auto inline MicroKernel(size_t const queryPanel, size_t const referencePanel) noexcept -> void;
+auto inline ReduceArgmin() noexcept -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    std::cout << "Starting Comparing L2 Norm\n";
+    TestSpeed(CompareL2, "CompareL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm (GEMM)\n";
+    auto const time_ms = TestSpeed(CompareL2GEMM, "CompareL2GEMM");
+
+    ComputeChecksum(indicesGEMM, "L2 Norm (GEMM)");
+    CountMismatches(indicesL2, indicesGEMM, "L2 Norm (GEMM)");
+
+    auto constexpr points = static_cast<double>(NUM_OF_POINTS);
+    auto constexpr flops = 2.0 * points * points * Descriptor::DIMENSIONS;
+    std::cout << std::format("Throughput for CompareL2GEMM : {:.2f} GFLOP/s\n", flops / (static_cast<double>(std::max(time_ms, 1L)) * 1e6));
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+
+    return time_ms;
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, std::string_view const message) noexcept -> void
+{
+    auto const mismatches = std::transform_reduce(lhs, lhs + NUM_OF_POINTS, rhs, 0UL, std::plus<>(), std::not_equal_to<>());
+    std::cout << std::format("Mismatches for {} : {} / {}\n", message, mismatches, static_cast<size_t>(NUM_OF_POINTS));
+}
+
+
+auto inline CompareL2() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL2Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL2GEMM() noexcept -> void
+{
+    PackOperands();
+
+    for (size_t block = 0; block < NUM_OF_REFERENCE_PANELS; block += PANELS_PER_BLOCK)
+    {
+        size_t const blockEnd = std::min(block + PANELS_PER_BLOCK, static_cast<size_t>(NUM_OF_REFERENCE_PANELS));
+
+        for (size_t queryPanel = 0; queryPanel < NUM_OF_QUERY_PANELS; ++queryPanel)
+        {
+            for (size_t referencePanel = block; referencePanel < blockEnd; ++referencePanel)
+            {
+                MicroKernel(queryPanel, referencePanel);
+            }
+        }
+    }
+
+    ReduceArgmin();
+}
+
+auto inline PackOperands() noexcept -> void
+{
+    for (size_t idx = 0; idx < NUM_OF_QUERY_PANELS * TILE_QUERIES; ++idx)
+    {
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            packedQueries[idx / TILE_QUERIES][dim][idx % TILE_QUERIES] = idx < NUM_OF_POINTS ? set1[idx][dim] : 0.0F;
+        }
+
+        std::fill(bestDistances[idx], bestDistances[idx] + TILE_REFERENCES, std::numeric_limits<float>::infinity());
+        std::fill(bestIndices[idx], bestIndices[idx] + TILE_REFERENCES, 0);
+    }
+
+    for (size_t idx = 0; idx < NUM_OF_REFERENCE_PANELS * TILE_REFERENCES; ++idx)
+    {
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            packedReferences[idx / TILE_REFERENCES][dim][idx % TILE_REFERENCES] = idx < NUM_OF_POINTS ? set2[idx][dim] : 0.0F;
+        }
+
+        referenceNorms[idx] = idx < NUM_OF_POINTS ? Descriptor::getSquaredMagnitude(set2[idx]) : std::numeric_limits<float>::infinity();
+    }
+}
+
+auto inline MicroKernel(size_t const queryPanel, size_t const referencePanel) noexcept -> void
+{
+    float const * const lhs = packedQueries[queryPanel][0];
+    float const * const rhs = packedReferences[referencePanel][0];
+
+    __m256 broadcast, right0, right1;
+
+    __m256 acc00 = _mm256_setzero_ps(), acc01 = _mm256_setzero_ps();
+    __m256 acc10 = _mm256_setzero_ps(), acc11 = _mm256_setzero_ps();
+    __m256 acc20 = _mm256_setzero_ps(), acc21 = _mm256_setzero_ps();
+    __m256 acc30 = _mm256_setzero_ps(), acc31 = _mm256_setzero_ps();
+    __m256 acc40 = _mm256_setzero_ps(), acc41 = _mm256_setzero_ps();
+    __m256 acc50 = _mm256_setzero_ps(), acc51 = _mm256_setzero_ps();
+
+    for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+    {
+        right0 = _mm256_load_ps(rhs + dim * TILE_REFERENCES);
+        right1 = _mm256_load_ps(rhs + dim * TILE_REFERENCES + FLOAT_VECTOR_SIZE);
+
+        GEMM_ROW(0);
+        GEMM_ROW(1);
+        GEMM_ROW(2);
+        GEMM_ROW(3);
+        GEMM_ROW(4);
+        GEMM_ROW(5);
+    }
+
+    size_t const query = queryPanel * TILE_QUERIES;
+    auto const first = static_cast<int>(referencePanel * TILE_REFERENCES);
+
+    __m256 const two = _mm256_set1_ps(2.0F);
+    __m256 const norm0 = _mm256_load_ps(referenceNorms + first);
+    __m256 const norm1 = _mm256_load_ps(referenceNorms + first + FLOAT_VECTOR_SIZE);
+    __m256i const indices0 = _mm256_add_epi32(_mm256_set1_epi32(first), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i const indices1 = _mm256_add_epi32(indices0, _mm256_set1_epi32(FLOAT_VECTOR_SIZE));
+
+    __m256 distance, best, mask, index;
+    __m256i * slot;
+
+    ARGMIN_ROW(0);
+    ARGMIN_ROW(1);
+    ARGMIN_ROW(2);
+    ARGMIN_ROW(3);
+    ARGMIN_ROW(4);
+    ARGMIN_ROW(5);
+}
+
+auto inline ReduceArgmin() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+    size_t candidate{0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+        for (size_t lane = 0; lane < TILE_REFERENCES; ++lane)
+        {
+            candidate = static_cast<size_t>(bestIndices[idx1][lane]);
+            currentDistance = Descriptor::getSquaredL2Norm(set1[idx1], set2[candidate]);
+
+            if (currentDistance < minDistance || (currentDistance == minDistance && candidate < indicesGEMM[idx1]))
+            {
+                minDistance = currentDistance;
+                indicesGEMM[idx1] = candidate;
+            }
+        }
+    }
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
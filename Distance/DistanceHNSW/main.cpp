@@ -0,0 +1,1040 @@
+/*
+## HNSW Graph Index
+
+A hierarchical navigable small world graph over set2 that uses the AVX2 getL1Norm/getL2Norm kernels as its
+distance. Every descriptor draws a top level from an exponential distribution (mL = 1 / ln(M)); a query walks
+greedily down the sparse upper levels and runs a best-first beam search of width ef on level 0.
+
+Layout: the levels are drawn up front, so all links fit in two preallocated flat arrays. Level 0 has a fixed
+slot of MAX_M0 + 1 words per descriptor (count followed by ids) and the upper levels share one pool addressed
+through a per-descriptor offset, so a neighbour list is always one contiguous run of 32-bit ids.
+
+Construction is parallel. Every descriptor owns a spinlock that guards its lists: an inserter copies a list
+under the lock before reading it and rewires a neighbour under the lock of that neighbour only. The global
+mutex is held only by the rare insertions that raise the top level. Neighbours are chosen with the diversity
+heuristic of the HNSW paper, both for the new node and when shrinking a full list.
+
+While scanning a neighbour list, the descriptor of the next neighbour is prefetched so its eight cache lines
+are on the way while the current distance is computed. Visited marks are epoch tags, so they are never
+cleared between queries.
+
+The index is saved to and loaded back from a binary file, and the loaded copy is searched again to check it.
+Recall@1 and recall@10 against the exact top-10, queries per second and mean latency are reported for a range
+of ef values.
+
+Usage: DistanceHNSW [dataset]. Given the name of a DistanceDataset dataset, the sets are read from its .dset files
+and the L2 points are scored against its cached .gt and appended to ../recall.csv.
+*/
+
+#include "Dataset.hpp"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <fstream>
+#include <stdexcept>
+#include <cmath>
+
+#include <immintrin.h>
+#include <omp.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    MAX_M = 16,
+    MAX_M0 = 2 * MAX_M,
+    EF_CONSTRUCTION = 100,
+    TOP_K = 10,
+    CACHE_LINE_SIZE = 64,
+};
+
+static constexpr size_t EF_SEARCH[]{10, 20, 40, 80, 160, 320};
+
+static constexpr std::uint32_t FILE_MAGIC{0x57534E48U}; /* "HNSW" */
+static constexpr std::uint32_t FILE_VERSION{1U};
+
+static constexpr std::uint32_t NO_NEIGHBOUR{std::numeric_limits<std::uint32_t>::max()}; /* Fills the ranks a search could not reach */
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+template <size_t K>
+class TopK
+{
+public:
+    void Reset() noexcept
+    {
+        std::fill(distances, distances + K, std::numeric_limits<float>::max());
+        std::fill(indices, indices + K, 0U);
+    }
+
+    /*
+     * Sorted insert without data-dependent branches, ties keep the earlier index in front.
+     */
+    void Insert(float const distance, std::uint32_t const index) noexcept
+    {
+        if (distance >= distances[K - 1])
+        {
+            return;
+        }
+
+#pragma GCC unroll 16
+        for (size_t slot = K - 1; slot > 0; --slot)
+        {
+            bool const shift = distance < distances[slot - 1];
+            bool const place = distance < distances[slot];
+
+            distances[slot] = shift ? distances[slot - 1] : (place ? distance : distances[slot]);
+            indices[slot] = shift ? indices[slot - 1] : (place ? index : indices[slot]);
+        }
+
+        bool const first = distance < distances[0];
+
+        distances[0] = first ? distance : distances[0];
+        indices[0] = first ? index : indices[0];
+    }
+
+    std::uint32_t Index(size_t const rank) const noexcept
+    {
+        return indices[rank];
+    }
+
+private:
+    float distances[K];
+    std::uint32_t indices[K];
+};
+
+
+enum class Norm : std::uint8_t
+{
+    L1,
+    L2,
+};
+
+struct Candidate
+{
+    float distance;
+    std::uint32_t index;
+
+    bool operator<(Candidate const & other) const noexcept
+    {
+        return distance < other.distance || (distance == other.distance && index < other.index);
+    }
+
+    bool operator>(Candidate const & other) const noexcept
+    {
+        return other < *this;
+    }
+};
+
+struct FileHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t numOfPoints;
+    std::uint32_t dimensions;
+    std::uint32_t maxM;
+    std::uint32_t maxM0;
+    std::uint32_t entryPoint;
+    std::uint32_t maxLevel;
+    std::uint64_t upperLinksSize;
+};
+
+
+template <Norm Metric>
+class HNSW
+{
+public:
+    explicit HNSW(Descriptor const * const data) noexcept : data{data} {}
+
+    void Build()
+    {
+        GenerateLevels();
+
+        links0.assign(NUM_OF_POINTS * LINKS0_STRIDE, 0U);
+        locks = std::make_unique<std::atomic_flag[]>(NUM_OF_POINTS);
+
+        entryPoint = 0;
+        maxLevel = levels[0];
+
+#pragma omp parallel for schedule(dynamic, 64)
+        for (size_t idx = 1; idx < NUM_OF_POINTS; ++idx)
+        {
+            Insert(static_cast<std::uint32_t>(idx));
+        }
+    }
+
+    void Search(Descriptor const & query, size_t const ef, std::uint32_t * const result) const
+    {
+        auto current = entryPoint;
+        auto currentDistance = Distance(query, data[current]);
+
+        for (auto level = maxLevel; level > 0; --level)
+        {
+            GreedyStep<false>(query, level, current, currentDistance);
+        }
+
+        auto candidates = SearchLayer<false>(query, current, currentDistance, std::max<size_t>(ef, TOP_K), 0);
+        std::sort_heap(candidates.begin(), candidates.end());
+
+        auto const found = std::min<size_t>(TOP_K, candidates.size());
+
+        for (size_t rank = 0; rank < found; ++rank)
+        {
+            result[rank] = candidates[rank].index;
+        }
+
+        std::fill(result + found, result + TOP_K, NO_NEIGHBOUR);
+    }
+
+    void Save(std::string_view const fileName) const
+    {
+        std::ofstream file{fileName.data(), std::ios::binary};
+
+        if (!file.is_open())
+        {
+            throw std::runtime_error{std::format("Failed to open output file: {}", fileName)};
+        }
+
+        FileHeader const header{FILE_MAGIC, FILE_VERSION, NUM_OF_POINTS, Descriptor::DIMENSIONS, MAX_M, MAX_M0, entryPoint, maxLevel, upperLinks.size()};
+
+        file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        file.write(reinterpret_cast<char const *>(levels.data()), static_cast<std::streamsize>(levels.size() * sizeof(levels[0])));
+        file.write(reinterpret_cast<char const *>(upperOffsets.data()), static_cast<std::streamsize>(upperOffsets.size() * sizeof(upperOffsets[0])));
+        file.write(reinterpret_cast<char const *>(links0.data()), static_cast<std::streamsize>(links0.size() * sizeof(links0[0])));
+        file.write(reinterpret_cast<char const *>(upperLinks.data()), static_cast<std::streamsize>(upperLinks.size() * sizeof(upperLinks[0])));
+
+        if (!file)
+        {
+            throw std::runtime_error{std::format("Failed to write the index to: {}", fileName)};
+        }
+    }
+
+    void Load(std::string_view const fileName)
+    {
+        std::ifstream file{fileName.data(), std::ios::binary};
+
+        if (!file.is_open())
+        {
+            throw std::runtime_error{std::format("Failed to open input file: {}", fileName)};
+        }
+
+        FileHeader header{};
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+        if (!file || header.magic != FILE_MAGIC || header.version != FILE_VERSION)
+        {
+            throw std::runtime_error{std::format("Not an HNSW index file: {}", fileName)};
+        }
+
+        if (header.numOfPoints != NUM_OF_POINTS || header.dimensions != Descriptor::DIMENSIONS || header.maxM != MAX_M || header.maxM0 != MAX_M0)
+        {
+            throw std::runtime_error{std::format("Incompatible HNSW index parameters in: {}", fileName)};
+        }
+
+        entryPoint = header.entryPoint;
+        maxLevel = header.maxLevel;
+
+        levels.resize(NUM_OF_POINTS);
+        upperOffsets.resize(NUM_OF_POINTS);
+
+        file.read(reinterpret_cast<char *>(levels.data()), static_cast<std::streamsize>(levels.size() * sizeof(levels[0])));
+        file.read(reinterpret_cast<char *>(upperOffsets.data()), static_cast<std::streamsize>(upperOffsets.size() * sizeof(upperOffsets[0])));
+
+        if (!file)
+        {
+            throw std::runtime_error{std::format("Truncated HNSW index file: {}", fileName)};
+        }
+
+        ValidateLevels(header.upperLinksSize, fileName);
+
+        links0.resize(NUM_OF_POINTS * LINKS0_STRIDE);
+        upperLinks.resize(header.upperLinksSize);
+
+        file.read(reinterpret_cast<char *>(links0.data()), static_cast<std::streamsize>(links0.size() * sizeof(links0[0])));
+        file.read(reinterpret_cast<char *>(upperLinks.data()), static_cast<std::streamsize>(upperLinks.size() * sizeof(upperLinks[0])));
+
+        if (!file)
+        {
+            throw std::runtime_error{std::format("Truncated HNSW index file: {}", fileName)};
+        }
+
+        ValidateLinks(fileName);
+    }
+
+    bool operator==(HNSW const & other) const noexcept
+    {
+        return entryPoint == other.entryPoint && maxLevel == other.maxLevel && levels == other.levels && links0 == other.links0 && upperLinks == other.upperLinks;
+    }
+
+    size_t MemoryUsage() const noexcept
+    {
+        return levels.size() * sizeof(levels[0]) + upperOffsets.size() * sizeof(upperOffsets[0]) + links0.size() * sizeof(links0[0]) +
+               upperLinks.size() * sizeof(upperLinks[0]);
+    }
+
+    std::uint32_t MaxLevel() const noexcept
+    {
+        return maxLevel;
+    }
+
+private:
+    static constexpr size_t LINKS0_STRIDE = MAX_M0 + 1;
+    static constexpr size_t UPPER_STRIDE = MAX_M + 1;
+
+    /* Highest level GenerateLevels() can draw, -ln(DBL_MIN) / ln(MAX_M), which bounds a loaded level too */
+    static constexpr std::uint32_t MAX_LEVEL = 255;
+
+    static float Distance(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        return Metric == Norm::L2 ? Descriptor::getL2Norm(lhs, rhs) : Descriptor::getL1Norm(lhs, rhs);
+    }
+
+    static void Prefetch(Descriptor const & descriptor) noexcept
+    {
+        auto const * const bytes = reinterpret_cast<char const *>(&descriptor);
+
+        for (size_t offset = 0; offset < sizeof(Descriptor); offset += CACHE_LINE_SIZE)
+        {
+            _mm_prefetch(bytes + offset, _MM_HINT_T0);
+        }
+    }
+
+    static size_t MaxLinks(std::uint32_t const level) noexcept
+    {
+        return level == 0 ? MAX_M0 : MAX_M;
+    }
+
+    /*
+     * Each thread keeps one tag per descriptor; a new search bumps the epoch instead of clearing the tags.
+     */
+    struct Visited
+    {
+        std::vector<std::uint32_t> tags = std::vector<std::uint32_t>(NUM_OF_POINTS, 0U);
+        std::uint32_t epoch{0};
+
+        void Next() noexcept
+        {
+            if (++epoch == 0)
+            {
+                std::fill(tags.begin(), tags.end(), 0U);
+                epoch = 1;
+            }
+        }
+
+        bool TestAndSet(std::uint32_t const index) noexcept
+        {
+            bool const seen = tags[index] == epoch;
+            tags[index] = epoch;
+            return seen;
+        }
+    };
+
+    void GenerateLevels()
+    {
+        std::mt19937 engine{SEED};
+        std::uniform_real_distribution<double> distribution{std::numeric_limits<double>::min(), 1.0};
+
+        auto const levelMultiplier = 1.0 / std::log(static_cast<double>(MAX_M));
+
+        levels.resize(NUM_OF_POINTS);
+        upperOffsets.resize(NUM_OF_POINTS);
+
+        std::uint32_t upperSize{0};
+
+        for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+        {
+            levels[idx] = static_cast<std::uint32_t>(-std::log(distribution(engine)) * levelMultiplier);
+            upperOffsets[idx] = upperSize;
+            upperSize += levels[idx] * static_cast<std::uint32_t>(UPPER_STRIDE);
+        }
+
+        upperLinks.assign(upperSize, 0U);
+    }
+
+    /*
+     * The levels must lay out the upper pool exactly as GenerateLevels() does, and the entry point must be a
+     * descriptor of the top level, before anything is allocated from the header sizes.
+     */
+    void ValidateLevels(std::uint64_t const upperLinksSize, std::string_view const fileName) const
+    {
+        std::uint64_t upperSize{0};
+        std::uint32_t topLevel{0};
+
+        for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+        {
+            if (upperOffsets[idx] != upperSize || levels[idx] > MAX_LEVEL)
+            {
+                throw std::runtime_error{std::format("Corrupt levels of descriptor {} in HNSW index file: {}", idx, fileName)};
+            }
+
+            upperSize += levels[idx] * UPPER_STRIDE;
+            topLevel = std::max(topLevel, levels[idx]);
+        }
+
+        if (upperSize != upperLinksSize || topLevel != maxLevel || entryPoint >= NUM_OF_POINTS || levels[entryPoint] != maxLevel)
+        {
+            throw std::runtime_error{std::format("Corrupt HNSW index header in: {}", fileName)};
+        }
+    }
+
+    /*
+     * Every list must fit its slot and only name descriptors that exist on its level, so a search never reads
+     * outside the link arrays.
+     */
+    void ValidateLinks(std::string_view const fileName) const
+    {
+        for (std::uint32_t index = 0; index < NUM_OF_POINTS; ++index)
+        {
+            for (std::uint32_t level = 0; level <= levels[index]; ++level)
+            {
+                auto const * const links = Links(index, level);
+
+                if (links[0] > MaxLinks(level))
+                {
+                    throw std::runtime_error{std::format("Corrupt link count of descriptor {} on level {} in HNSW index file: {}", index, level, fileName)};
+                }
+
+                for (size_t idx = 1; idx <= links[0]; ++idx)
+                {
+                    if (links[idx] >= NUM_OF_POINTS || levels[links[idx]] < level)
+                    {
+                        throw std::runtime_error{std::format("Corrupt link of descriptor {} on level {} in HNSW index file: {}", index, level, fileName)};
+                    }
+                }
+            }
+        }
+    }
+
+    std::uint32_t * Links(std::uint32_t const index, std::uint32_t const level) noexcept
+    {
+        return level == 0 ? links0.data() + index * LINKS0_STRIDE : upperLinks.data() + upperOffsets[index] + (level - 1) * UPPER_STRIDE;
+    }
+
+    std::uint32_t const * Links(std::uint32_t const index, std::uint32_t const level) const noexcept
+    {
+        return level == 0 ? links0.data() + index * LINKS0_STRIDE : upperLinks.data() + upperOffsets[index] + (level - 1) * UPPER_STRIDE;
+    }
+
+    void Lock(std::uint32_t const index) const noexcept
+    {
+        while (locks[index].test_and_set(std::memory_order_acquire))
+        {
+            locks[index].wait(true, std::memory_order_relaxed);
+        }
+    }
+
+    void Unlock(std::uint32_t const index) const noexcept
+    {
+        locks[index].clear(std::memory_order_release);
+        locks[index].notify_one();
+    }
+
+    /*
+     * Copies the list of index at level into buffer (under the lock of index while building). Returns the count.
+     */
+    template <bool Concurrent>
+    size_t ReadLinks(std::uint32_t const index, std::uint32_t const level, std::uint32_t * const buffer) const noexcept
+    {
+        if constexpr (Concurrent)
+        {
+            Lock(index);
+        }
+
+        auto const * const links = Links(index, level);
+        auto const count = links[0];
+        std::copy(links + 1, links + 1 + count, buffer);
+
+        if constexpr (Concurrent)
+        {
+            Unlock(index);
+        }
+
+        return count;
+    }
+
+    template <bool Concurrent>
+    void GreedyStep(Descriptor const & query, std::uint32_t const level, std::uint32_t & current, float & currentDistance) const noexcept
+    {
+        std::uint32_t buffer[MAX_M0];
+        bool changed{true};
+
+        while (changed)
+        {
+            changed = false;
+
+            auto const count = ReadLinks<Concurrent>(current, level, buffer);
+
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                if (idx + 1 < count)
+                {
+                    Prefetch(data[buffer[idx + 1]]);
+                }
+
+                auto const distance = Distance(query, data[buffer[idx]]);
+
+                if (distance < currentDistance)
+                {
+                    currentDistance = distance;
+                    current = buffer[idx];
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    /*
+     * Best-first search of width ef on one level. Returns the results as a max-heap on the distance.
+     */
+    template <bool Concurrent>
+    std::vector<Candidate> SearchLayer(Descriptor const & query, std::uint32_t const entry, float const entryDistance, size_t const ef, std::uint32_t const level) const
+    {
+        thread_local Visited visited;
+        visited.Next();
+
+        std::vector<Candidate> candidates;
+        std::vector<Candidate> results;
+        candidates.reserve(ef * MAX_M0);
+        results.reserve(ef + 1);
+
+        std::uint32_t buffer[MAX_M0];
+
+        visited.TestAndSet(entry);
+        candidates.push_back(Candidate{entryDistance, entry});
+        results.push_back(Candidate{entryDistance, entry});
+
+        while (!candidates.empty())
+        {
+            std::pop_heap(candidates.begin(), candidates.end(), std::greater<>());
+            auto const closest = candidates.back();
+            candidates.pop_back();
+
+            if (closest.distance > results.front().distance && results.size() >= ef)
+            {
+                break;
+            }
+
+            auto const count = ReadLinks<Concurrent>(closest.index, level, buffer);
+
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                if (idx + 1 < count)
+                {
+                    Prefetch(data[buffer[idx + 1]]);
+                }
+
+                auto const neighbour = buffer[idx];
+
+                if (visited.TestAndSet(neighbour))
+                {
+                    continue;
+                }
+
+                auto const distance = Distance(query, data[neighbour]);
+
+                if (results.size() < ef || distance < results.front().distance)
+                {
+                    candidates.push_back(Candidate{distance, neighbour});
+                    std::push_heap(candidates.begin(), candidates.end(), std::greater<>());
+
+                    results.push_back(Candidate{distance, neighbour});
+                    std::push_heap(results.begin(), results.end());
+
+                    if (results.size() > ef)
+                    {
+                        std::pop_heap(results.begin(), results.end());
+                        results.pop_back();
+                    }
+                }
+            }
+        }
+
+        return results;
+    }
+
+    /*
+     * Diversity heuristic: walking the candidates from the closest, keep one only if it is closer to the base
+     * than to every neighbour kept so far. Writes at most maxLinks ids to selected and returns the count.
+     */
+    size_t SelectNeighbours(std::vector<Candidate> & candidates, size_t const maxLinks, std::uint32_t * const selected) const noexcept
+    {
+        std::sort(candidates.begin(), candidates.end());
+
+        size_t count{0};
+
+        for (auto const & candidate : candidates)
+        {
+            if (count == maxLinks)
+            {
+                break;
+            }
+
+            bool const diverse = std::none_of(selected, selected + count,
+                                              [&](std::uint32_t const kept) { return Distance(data[candidate.index], data[kept]) < candidate.distance; });
+
+            if (diverse)
+            {
+                selected[count++] = candidate.index;
+            }
+        }
+
+        return count;
+    }
+
+    void Connect(std::uint32_t const neighbour, std::uint32_t const index, std::uint32_t const level)
+    {
+        auto const maxLinks = MaxLinks(level);
+
+        Lock(neighbour);
+
+        auto * const links = Links(neighbour, level);
+
+        if (links[0] < maxLinks)
+        {
+            links[links[0] + 1] = index;
+            ++links[0];
+        }
+        else
+        {
+            std::vector<Candidate> candidates;
+            candidates.reserve(maxLinks + 1);
+
+            candidates.push_back(Candidate{Distance(data[neighbour], data[index]), index});
+
+            for (size_t idx = 1; idx <= links[0]; ++idx)
+            {
+                candidates.push_back(Candidate{Distance(data[neighbour], data[links[idx]]), links[idx]});
+            }
+
+            links[0] = static_cast<std::uint32_t>(SelectNeighbours(candidates, maxLinks, links + 1));
+        }
+
+        Unlock(neighbour);
+    }
+
+    void Insert(std::uint32_t const index)
+    {
+        auto const level = levels[index];
+
+        std::unique_lock<std::mutex> globalLock{entryMutex};
+
+        auto current = entryPoint;
+        auto const topLevel = maxLevel;
+
+        if (level <= topLevel)
+        {
+            /* Only an insertion that raises the top level keeps the global lock */
+            globalLock.unlock();
+        }
+
+        auto const & query = data[index];
+        auto currentDistance = Distance(query, data[current]);
+
+        for (auto searchLevel = topLevel; searchLevel > level; --searchLevel)
+        {
+            GreedyStep<true>(query, searchLevel, current, currentDistance);
+        }
+
+        std::uint32_t selected[MAX_M0];
+
+        for (auto searchLevel = std::min(level, topLevel) + 1; searchLevel-- > 0;)
+        {
+            auto candidates = SearchLayer<true>(query, current, currentDistance, EF_CONSTRUCTION, searchLevel);
+
+            auto const closest = *std::min_element(candidates.begin(), candidates.end());
+            current = closest.index;
+            currentDistance = closest.distance;
+
+            auto const count = SelectNeighbours(candidates, MAX_M, selected);
+
+            Lock(index);
+            auto * const links = Links(index, searchLevel);
+            std::copy(selected, selected + count, links + 1);
+            links[0] = static_cast<std::uint32_t>(count);
+            Unlock(index);
+
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                Connect(selected[idx], index, searchLevel);
+            }
+        }
+
+        if (level > topLevel)
+        {
+            entryPoint = index;
+            maxLevel = level;
+        }
+    }
+
+    Descriptor const * data;
+
+    std::vector<std::uint32_t> levels;
+    std::vector<std::uint32_t> upperOffsets;
+    std::vector<std::uint32_t> links0;
+    std::vector<std::uint32_t> upperLinks;
+
+    std::uint32_t entryPoint{0};
+    std::uint32_t maxLevel{0};
+
+    std::unique_ptr<std::atomic_flag[]> locks;
+    std::mutex entryMutex;
+};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+alignas(ALIGN) TopK<TOP_K> exactL1[NUM_OF_POINTS];
+alignas(ALIGN) TopK<TOP_K> exactL2[NUM_OF_POINTS];
+
+alignas(ALIGN) std::uint32_t approximate[NUM_OF_POINTS][TOP_K];
+
+static GroundTruth groundTruth{};
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+
+template <Norm Metric>
+auto inline CompareExact(TopK<TOP_K> * const exact, size_t * const indices) noexcept -> void;
+
+template <Norm Metric>
+auto inline Benchmark(TopK<TOP_K> const * const exact, long const bruteForce_ms, std::string_view const fileName, std::string_view const message) -> void;
+template <Norm Metric>
+auto inline SearchAll(HNSW<Metric> const & index, size_t const ef) -> void;
+auto inline ComputeRecall(TopK<TOP_K> const * const exact, size_t const ef, long const time_us, std::string_view const message) noexcept -> void;
+
+auto inline GroundTruthRecall(size_t const k) noexcept -> double;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main(int const argc, char const * const argv[])
+{
+    if (argc > 2)
+    {
+        std::cerr << "Usage: DistanceHNSW [dataset]\n";
+        return EXIT_FAILURE;
+    }
+
+    if (argc == 2)
+    {
+        try
+        {
+            groundTruth = LoadDataset(argv[1], set1, set2, NUM_OF_POINTS);
+        }
+        catch (std::exception const & exception)
+        {
+            std::cerr << exception.what() << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "Starting Comparing L1 Norm (Exact Top-10)\n";
+    auto const bruteForceL1_ms = TestSpeed([] { CompareExact<Norm::L1>(exactL1, indicesL1); }, "CompareExactL1");
+
+    ComputeChecksum(indicesL1, "L1 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm (Exact Top-10)\n";
+    auto const bruteForceL2_ms = TestSpeed([] { CompareExact<Norm::L2>(exactL2, indicesL2); }, "CompareExactL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    Cooldown();
+
+    try
+    {
+        Benchmark<Norm::L1>(exactL1, bruteForceL1_ms, "hnsw_l1.bin", "L1 Norm");
+
+        Cooldown();
+
+        Benchmark<Norm::L2>(exactL2, bruteForceL2_ms, "hnsw_l2.bin", "L2 Norm");
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+
+    return time_ms;
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+/*
+ * Brute-force top-10, the first neighbour is the same index the single-best search records.
+ */
+template <Norm Metric>
+auto inline CompareExact(TopK<TOP_K> * const exact, size_t * const indices) noexcept -> void
+{
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        exact[idx1].Reset();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Metric == Norm::L2 ? Descriptor::getL2Norm(set1[idx1], set2[idx2]) : Descriptor::getL1Norm(set1[idx1], set2[idx2]);
+            exact[idx1].Insert(currentDistance, static_cast<std::uint32_t>(idx2));
+        }
+
+        indices[idx1] = exact[idx1].Index(0);
+    }
+}
+
+template <Norm Metric>
+auto inline Benchmark(TopK<TOP_K> const * const exact, long const bruteForce_ms, std::string_view const fileName, std::string_view const message) -> void
+{
+    HNSW<Metric> index{set2};
+
+    std::cout << std::format("Starting Building HNSW {} ({} threads)\n", message, omp_get_max_threads());
+    auto const build_ms = TestSpeed([&index] { index.Build(); }, std::format("BuildHNSW ({})", message));
+
+    std::cout << std::format("Index for {} : {} levels, {:.2f} MB of links, {:.0f} insertions/s\n", message, index.MaxLevel() + 1,
+                             static_cast<double>(index.MemoryUsage()) / 1e6, static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(build_ms, 1L)) / 1e3));
+
+    index.Save(fileName);
+
+    HNSW<Metric> loaded{set2};
+    loaded.Load(fileName);
+
+    if (loaded != index)
+    {
+        throw std::runtime_error{std::format("The index for {} read back from {} differs from the one saved", message, fileName)};
+    }
+
+    std::cout << std::format("Save/Load for {} : identical\n", message);
+
+    std::cout << std::format("Brute force for {} : {:.0f} queries/s\n", message, static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(bruteForce_ms, 1L)) / 1e3));
+
+    for (auto const ef : EF_SEARCH)
+    {
+        auto const start = std::chrono::high_resolution_clock::now();
+        SearchAll(loaded, ef);
+        auto const stop = std::chrono::high_resolution_clock::now();
+
+        auto const time_us = std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count();
+        ComputeRecall(exact, ef, time_us, message);
+
+        /* The links are searched together with the float descriptors they point to */
+        if constexpr (Metric == Norm::L2)
+        {
+            auto const k = std::min<size_t>(TOP_K, groundTruth.neighbours);
+            auto const queriesPerSecond = static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(time_us, 1L)) / 1e6);
+
+            AppendRecall(groundTruth, "HNSW", std::format("ef={}", ef), k, GroundTruthRecall(k), queriesPerSecond, 1, loaded.MemoryUsage() + sizeof(set2));
+        }
+    }
+}
+
+/*
+ * Queries run one after the other on a single thread, so the time per query is its latency.
+ */
+template <Norm Metric>
+auto inline SearchAll(HNSW<Metric> const & index, size_t const ef) -> void
+{
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        index.Search(set1[idx1], ef, approximate[idx1]);
+    }
+}
+
+auto inline ComputeRecall(TopK<TOP_K> const * const exact, size_t const ef, long const time_us, std::string_view const message) noexcept -> void
+{
+    size_t hitsAt1{0};
+    size_t hitsAt10{0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        hitsAt1 += approximate[idx1][0] == exact[idx1].Index(0);
+
+        for (size_t rank = 0; rank < TOP_K; ++rank)
+        {
+            hitsAt10 += std::find(approximate[idx1], approximate[idx1] + TOP_K, exact[idx1].Index(rank)) != approximate[idx1] + TOP_K;
+        }
+    }
+
+    auto const recallAt1 = static_cast<double>(hitsAt1) / static_cast<double>(NUM_OF_POINTS) * 100.0;
+    auto const recallAt10 = static_cast<double>(hitsAt10) / static_cast<double>(NUM_OF_POINTS * TOP_K) * 100.0;
+    auto const latency_us = static_cast<double>(time_us) / static_cast<double>(NUM_OF_POINTS);
+    auto const qps = 1e6 / std::max(latency_us, 1e-3);
+
+    std::cout << std::format("ef {:>3} for {} : Recall@1 {:6.2f}%, Recall@10 {:6.2f}%, {:>7.0f} queries/s, {:6.1f} us/query\n", ef, message, recallAt1, recallAt10, qps,
+                             latency_us);
+}
+
+/*
+ * Recall@k in percent of the approximate results against the top k of the cached ground truth, ignoring the order,
+ * zero without a dataset.
+ */
+auto inline GroundTruthRecall(size_t const k) noexcept -> double
+{
+    if (groundTruth.dataset.empty() || k == 0)
+    {
+        return 0.0;
+    }
+
+    size_t hits{0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        auto const * const truth = groundTruth.ids.data() + idx1 * groundTruth.neighbours;
+
+        hits += static_cast<size_t>(std::count_if(approximate[idx1], approximate[idx1] + k, [truth, k](auto const id) { return std::find(truth, truth + k, id) != truth + k; }));
+    }
+
+    return static_cast<double>(hits) / static_cast<double>(NUM_OF_POINTS * k) * 100.0;
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -0,0 +1,667 @@
+/*
+## Half-Precision Storage
+
+The descriptors are stored as FP16 (IEEE binary16, converted with F16C) or BF16 (the upper half of a float,
+rounded to nearest even) and expanded to FP32 inside the kernels: _mm256_cvtph_ps for FP16, a zero-extend and
+16-bit shift for BF16. Accumulation stays in FP32. A half descriptor is 256 B instead of 512 B.
+
+The 10k seeded sets report checksum agreement with the FP32 search. The large benchmark streams a reference
+set well beyond the last-level cache for a few queries, where the search is bound by memory bandwidth and
+halving the bytes per descriptor should nearly double the throughput.
+
+Usage: DistanceHalf [dataset]. Given the name of a DistanceDataset dataset, only the L2 searches of its .dset
+files run: FP16 and BF16 are scored against its cached .gt and appended to ../recall.csv, so the recall lost to
+the narrower storage is measured on data with close neighbours.
+*/
+
+#include "Dataset.hpp"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <bit>
+#include <new>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+#define L1_HALF(LHS, RHS, IDX)        left = Expand(LHS.features + IDX);                       /* Expand 8 halves from lhs into a vector */                                 \
+                                      right = Expand(RHS.features + IDX);                      /* Expand 8 halves from rhs into a vector */                                 \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_HALF(LHS, RHS, IDX)        left = Expand(LHS.features + IDX);          /* Expand 8 halves from lhs into a vector */ \
+                                      right = Expand(RHS.features + IDX);         /* Expand 8 halves from rhs into a vector */ \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+#define ALIGNED_NEW    std::align_val_t(std::hardware_destructive_interference_size)
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    LARGE_NUM_OF_POINTS = 2'000'000UL,
+    LARGE_NUM_OF_QUERIES = 8,
+};
+
+enum class HalfFormat : std::uint8_t
+{
+    FP16,
+    BF16,
+};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+template <HalfFormat Format>
+class HalfDescriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = Descriptor::DIMENSIONS;
+
+    HalfDescriptor() noexcept = default;
+
+    explicit HalfDescriptor(Descriptor const & descriptor) noexcept
+    {
+        for (size_t dim = 0; dim < DIMENSIONS; dim += FLOAT_VECTOR_SIZE)
+        {
+            if constexpr (Format == HalfFormat::FP16)
+            {
+                __m128i const half = _mm256_cvtps_ph(_mm256_load_ps(&descriptor[dim]), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                _mm_store_si128(reinterpret_cast<__m128i *>(features + dim), half);
+            }
+            else
+            {
+                for (size_t idx = dim; idx < dim + FLOAT_VECTOR_SIZE; ++idx)
+                {
+                    auto const bits = std::bit_cast<std::uint32_t>(descriptor[idx]);
+                    features[idx] = static_cast<std::uint16_t>((bits + 0x7FFFU + ((bits >> 16U) & 1U)) >> 16U);
+                }
+            }
+        }
+    }
+
+    static float getL1Norm(HalfDescriptor const & lhs, HalfDescriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_HALF(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_HALF(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(HalfDescriptor const & lhs, HalfDescriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_HALF(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_HALF(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+private:
+    static __m256 Expand(std::uint16_t const * const halves) noexcept
+    {
+        __m128i const packed = _mm_load_si128(reinterpret_cast<__m128i const *>(halves));
+
+        if constexpr (Format == HalfFormat::FP16)
+        {
+            return _mm256_cvtph_ps(packed);
+        }
+        else
+        {
+            return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(packed), 16));
+        }
+    }
+
+    alignas(ALIGN) std::uint16_t features[DIMENSIONS]{};
+};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) HalfDescriptor<HalfFormat::FP16> fp16Set1[NUM_OF_POINTS];
+alignas(ALIGN) HalfDescriptor<HalfFormat::FP16> fp16Set2[NUM_OF_POINTS];
+
+alignas(ALIGN) HalfDescriptor<HalfFormat::BF16> bf16Set1[NUM_OF_POINTS];
+alignas(ALIGN) HalfDescriptor<HalfFormat::BF16> bf16Set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesHalfL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesHalfL2[NUM_OF_POINTS];
+
+static Descriptor * largeSet{nullptr};
+static HalfDescriptor<HalfFormat::FP16> * largeFp16Set{nullptr};
+static HalfDescriptor<HalfFormat::BF16> * largeBf16Set{nullptr};
+
+alignas(ALIGN) size_t largeIndices[LARGE_NUM_OF_QUERIES];
+
+static GroundTruth groundTruth{};
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, std::string_view const message) noexcept -> void;
+
+auto inline CompareL1() noexcept -> void;
+auto inline CompareL2() noexcept -> void;
+
+auto inline Convert() noexcept -> void;
+
+template <typename Set>
+auto inline CompareHalfL1(Set const * const lhs, Set const * const rhs) noexcept -> void;
+template <typename Set>
+auto inline CompareHalfL2(Set const * const lhs, Set const * const rhs) noexcept -> void;
+
+auto inline LargeSetup() noexcept -> void;
+template <typename Set>
+auto inline CompareLargeL2(Set const * const queries, Set const * const references) noexcept -> void;
+auto inline ReportThroughput(long const time_ms, size_t const descriptorSize, std::string_view const message) noexcept -> void;
+
+auto inline Check(void const * const ptr, std::string_view const message) noexcept -> void;
+auto inline Cleanup() noexcept -> void;
+
+auto inline RunDataset() -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main(int const argc, char const * const argv[])
+{
+    try
+    {
+        if (argc > 2)
+        {
+            std::cerr << "Usage: DistanceHalf [dataset]\n";
+            return EXIT_FAILURE;
+        }
+
+        if (argc == 2)
+        {
+            groundTruth = LoadDataset(argv[1], set1, set2, NUM_OF_POINTS);
+            RunDataset();
+
+            return 0;
+        }
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Starting Comparing L1 Norm\n";
+    TestSpeed(CompareL1, "CompareL1");
+
+    ComputeChecksum(indicesL1, "L1 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm\n";
+    TestSpeed(CompareL2, "CompareL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    Convert();
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L1 Norm (FP16)\n";
+    TestSpeed([] { CompareHalfL1(fp16Set1, fp16Set2); }, "CompareHalfL1 (FP16)");
+
+    ComputeChecksum(indicesHalfL1, "L1 Norm (FP16)");
+    CountMismatches(indicesL1, indicesHalfL1, "L1 Norm (FP16)");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm (FP16)\n";
+    TestSpeed([] { CompareHalfL2(fp16Set1, fp16Set2); }, "CompareHalfL2 (FP16)");
+
+    ComputeChecksum(indicesHalfL2, "L2 Norm (FP16)");
+    CountMismatches(indicesL2, indicesHalfL2, "L2 Norm (FP16)");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L1 Norm (BF16)\n";
+    TestSpeed([] { CompareHalfL1(bf16Set1, bf16Set2); }, "CompareHalfL1 (BF16)");
+
+    ComputeChecksum(indicesHalfL1, "L1 Norm (BF16)");
+    CountMismatches(indicesL1, indicesHalfL1, "L1 Norm (BF16)");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm (BF16)\n";
+    TestSpeed([] { CompareHalfL2(bf16Set1, bf16Set2); }, "CompareHalfL2 (BF16)");
+
+    ComputeChecksum(indicesHalfL2, "L2 Norm (BF16)");
+    CountMismatches(indicesL2, indicesHalfL2, "L2 Norm (BF16)");
+
+    Cooldown();
+
+    std::cout << std::format("Starting Large Set Setup ({} references)\n", static_cast<size_t>(LARGE_NUM_OF_POINTS));
+    LargeSetup();
+
+    std::cout << "Starting Comparing L2 Norm (Large, FP32)\n";
+    ReportThroughput(TestSpeed([] { CompareLargeL2(set1, largeSet); }, "CompareLargeL2 (FP32)"), sizeof(Descriptor), "FP32");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm (Large, FP16)\n";
+    ReportThroughput(TestSpeed([] { CompareLargeL2(fp16Set1, largeFp16Set); }, "CompareLargeL2 (FP16)"), sizeof(HalfDescriptor<HalfFormat::FP16>), "FP16");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm (Large, BF16)\n";
+    ReportThroughput(TestSpeed([] { CompareLargeL2(bf16Set1, largeBf16Set); }, "CompareLargeL2 (BF16)"), sizeof(HalfDescriptor<HalfFormat::BF16>), "BF16");
+
+    Cleanup();
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+
+    return time_ms;
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, std::string_view const message) noexcept -> void
+{
+    auto const mismatches = std::transform_reduce(lhs, lhs + NUM_OF_POINTS, rhs, 0UL, std::plus<>(), std::not_equal_to<>());
+    std::cout << std::format("Mismatches for {} : {} / {}\n", message, mismatches, static_cast<size_t>(NUM_OF_POINTS));
+}
+
+
+auto inline CompareL1() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL1Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL2() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL2Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline Convert() noexcept -> void
+{
+    for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+    {
+        fp16Set1[idx] = HalfDescriptor<HalfFormat::FP16>{set1[idx]};
+        fp16Set2[idx] = HalfDescriptor<HalfFormat::FP16>{set2[idx]};
+        bf16Set1[idx] = HalfDescriptor<HalfFormat::BF16>{set1[idx]};
+        bf16Set2[idx] = HalfDescriptor<HalfFormat::BF16>{set2[idx]};
+    }
+}
+
+template <typename Set>
+auto inline CompareHalfL1(Set const * const lhs, Set const * const rhs) noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Set::getL1Norm(lhs[idx1], rhs[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesHalfL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+template <typename Set>
+auto inline CompareHalfL2(Set const * const lhs, Set const * const rhs) noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Set::getL2Norm(lhs[idx1], rhs[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesHalfL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline LargeSetup() noexcept -> void
+{
+    largeSet = new(ALIGNED_NEW, std::nothrow) Descriptor[LARGE_NUM_OF_POINTS];
+    Check(largeSet, "large reference set (FP32)");
+
+    largeFp16Set = new(ALIGNED_NEW, std::nothrow) HalfDescriptor<HalfFormat::FP16>[LARGE_NUM_OF_POINTS];
+    Check(largeFp16Set, "large reference set (FP16)");
+
+    largeBf16Set = new(ALIGNED_NEW, std::nothrow) HalfDescriptor<HalfFormat::BF16>[LARGE_NUM_OF_POINTS];
+    Check(largeBf16Set, "large reference set (BF16)");
+
+    for (size_t idx = 0; idx < LARGE_NUM_OF_POINTS; ++idx)
+    {
+        largeFp16Set[idx] = HalfDescriptor<HalfFormat::FP16>{largeSet[idx]};
+        largeBf16Set[idx] = HalfDescriptor<HalfFormat::BF16>{largeSet[idx]};
+    }
+}
+
+/*
+ * One query at a time over the whole reference set, so every query streams it from memory again.
+ */
+template <typename Set>
+auto inline CompareLargeL2(Set const * const queries, Set const * const references) noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < LARGE_NUM_OF_QUERIES; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < LARGE_NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Set::getL2Norm(queries[idx1], references[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                largeIndices[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline ReportThroughput(long const time_ms, size_t const descriptorSize, std::string_view const message) noexcept -> void
+{
+    auto const seconds = static_cast<double>(std::max(time_ms, 1L)) / 1e3;
+    auto const pairs = static_cast<double>(LARGE_NUM_OF_QUERIES) * static_cast<double>(LARGE_NUM_OF_POINTS);
+    auto const bytes = pairs * static_cast<double>(descriptorSize);
+
+    std::cout << std::format("Throughput for {} : {:.2f} M pairs/s, {:.2f} GB/s\n", message, pairs / seconds / 1e6, bytes / seconds / 1e9);
+    std::cout << std::format("Checksum for Large L2 Norm ({}) : {:#x}\n", message, std::reduce(largeIndices, largeIndices + LARGE_NUM_OF_QUERIES, 0UL, std::bit_xor<>()));
+}
+
+auto inline Check(void const * const ptr, std::string_view const message) noexcept -> void
+{
+    if (ptr == nullptr)
+    {
+        std::cerr << "Failed to allocate memory for the " << message << ".\n";
+        Cleanup();
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+auto inline Cleanup() noexcept -> void
+{
+    delete[] largeSet;
+    largeSet = nullptr;
+    delete[] largeFp16Set;
+    largeFp16Set = nullptr;
+    delete[] largeBf16Set;
+    largeBf16Set = nullptr;
+}
+
+/*
+ * The L2 searches of the sets of a dataset, with FP16 and BF16 scored against its ground truth.
+ */
+auto inline RunDataset() -> void
+{
+    std::cout << "Starting Comparing L2 Norm\n";
+    TestSpeed(CompareL2, "CompareL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    Convert();
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm (FP16)\n";
+    auto const fp16_ms = TestSpeed([] { CompareHalfL2(fp16Set1, fp16Set2); }, "CompareHalfL2 (FP16)");
+
+    ComputeChecksum(indicesHalfL2, "L2 Norm (FP16)");
+    CountMismatches(indicesL2, indicesHalfL2, "L2 Norm (FP16)");
+
+    auto const fp16QueriesPerSecond = static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(fp16_ms, 1L)) / 1e3);
+    AppendRecall(groundTruth, "Half", "FP16", 1, GroundTruthRecall(groundTruth, indicesHalfL2, NUM_OF_POINTS), fp16QueriesPerSecond, 1, sizeof(fp16Set2));
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm (BF16)\n";
+    auto const bf16_ms = TestSpeed([] { CompareHalfL2(bf16Set1, bf16Set2); }, "CompareHalfL2 (BF16)");
+
+    ComputeChecksum(indicesHalfL2, "L2 Norm (BF16)");
+    CountMismatches(indicesL2, indicesHalfL2, "L2 Norm (BF16)");
+
+    auto const bf16QueriesPerSecond = static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(bf16_ms, 1L)) / 1e3);
+    AppendRecall(groundTruth, "Half", "BF16", 1, GroundTruthRecall(groundTruth, indicesHalfL2, NUM_OF_POINTS), bf16QueriesPerSecond, 1, sizeof(bf16Set2));
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
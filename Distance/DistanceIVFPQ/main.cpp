@@ -0,0 +1,796 @@
+/*
+## IVF-PQ Index
+
+An inverted file with product quantization for descriptor sets that do not fit in memory as floats. A k-means
+coarse quantizer splits set2 into NUM_OF_LISTS lists and every descriptor is stored as the product quantization
+of its residual to the list centroid: 16 bytes instead of 512, a 32x reduction of the payload.
+
+Two code layouts of the same size are built:
+    - 8-bit: 16 subspaces of 8 dimensions, 256 centroids each, scanned with a float lookup table per subspace.
+    - 4-bit: 32 subspaces of 4 dimensions, 16 centroids each, scanned with the fast-scan layout. The codes of
+      32 descriptors are interleaved so one _mm256_shuffle_epi8 looks up two subspaces (one per 128-bit lane)
+      for 16 descriptors. The table of each (query, list) pair is quantized to bytes, partial sums are kept in
+      16-bit lanes, and a vector compare against the current re-rank threshold skips most descriptors.
+
+A query ranks the coarse centroids, scans the nprobe closest lists with its asymmetric distance tables and keeps
+the RERANK_SIZE best approximate candidates, which are re-ranked with the exact L2 kernel. Recall@1 against the
+brute-force search and the checksum are reported for a range of nprobe values.
+
+Usage: DistanceIVFPQ [dataset]. Given the name of a DistanceDataset dataset, the sets are read from its .dset files
+and every point is scored against its cached .gt and appended to ../recall.csv.
+*/
+
+#include "Dataset.hpp"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <vector>
+#include <bit>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    NUM_OF_LISTS = 64,
+    KMEANS_ITERATIONS = 12,
+    RERANK_SIZE = 64,
+    CODE_SIZE = 16,
+    PQ8_SUBSPACES = 16,
+    PQ8_SUBSPACE_DIMS = 8,
+    PQ8_CENTROIDS = 256,
+    PQ4_SUBSPACES = 32,
+    PQ4_SUBSPACE_DIMS = 4,
+    PQ4_CENTROIDS = 16,
+    FAST_SCAN_BLOCK = 32,
+};
+
+static constexpr size_t NPROBE[]{1, 2, 4, 8, 16, 32, 64};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+enum class CodeSize : std::uint8_t
+{
+    PQ8,
+    PQ4,
+};
+
+struct Candidate
+{
+    float distance;
+    std::uint32_t index;
+
+    bool operator<(Candidate const & other) const noexcept
+    {
+        return distance < other.distance;
+    }
+};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesIVFPQ[NUM_OF_POINTS];
+
+alignas(ALIGN) float coarseCentroids[NUM_OF_LISTS][Descriptor::DIMENSIONS];
+alignas(ALIGN) std::uint32_t listOffsets[NUM_OF_LISTS + 1];
+alignas(ALIGN) std::uint32_t listIds[NUM_OF_POINTS];
+alignas(ALIGN) std::uint32_t blockOffsets[NUM_OF_LISTS + 1];
+
+alignas(ALIGN) float residuals[NUM_OF_POINTS][Descriptor::DIMENSIONS];
+
+alignas(ALIGN) float pq8Codebooks[PQ8_SUBSPACES][PQ8_CENTROIDS][PQ8_SUBSPACE_DIMS];
+alignas(ALIGN) float pq4Codebooks[PQ4_SUBSPACES][PQ4_CENTROIDS][PQ4_SUBSPACE_DIMS];
+
+alignas(ALIGN) std::uint8_t pq8Codes[NUM_OF_POINTS][CODE_SIZE];
+alignas(ALIGN) std::uint8_t pq4Unpacked[NUM_OF_POINTS][PQ4_SUBSPACES];
+
+static std::vector<std::uint8_t> pq4Packed;
+
+static GroundTruth groundTruth{};
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+
+auto inline CompareL1() noexcept -> void;
+auto inline CompareL2() noexcept -> void;
+
+auto inline KMeans(float const * const points, size_t const count, size_t const stride, size_t const dims, size_t const k, float * const centroids, std::mt19937 & engine) noexcept -> void;
+auto inline Nearest(float const * const point, float const * const centroids, size_t const dims, size_t const k) noexcept -> size_t;
+auto inline SquaredDistance(float const * const lhs, float const * const rhs, size_t const dims) noexcept -> float;
+
+auto inline TrainCoarse() noexcept -> void;
+auto inline TrainProductQuantizers() noexcept -> void;
+auto inline PackFastScan() -> void;
+
+template <CodeSize Codes>
+auto inline SearchIVFPQ(size_t const nprobe) noexcept -> void;
+auto inline ScanPQ8(float const * const residual, size_t const list, std::vector<Candidate> & heap) noexcept -> void;
+auto inline ScanPQ4(float const * const residual, size_t const list, std::vector<Candidate> & heap) noexcept -> void;
+auto inline PushCandidate(std::vector<Candidate> & heap, float const distance, std::uint32_t const index) noexcept -> void;
+
+template <CodeSize Codes>
+auto inline RecallCurve(std::string_view const message) -> void;
+auto inline ReportMemory() noexcept -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main(int const argc, char const * const argv[])
+{
+    try
+    {
+        if (argc > 2)
+        {
+            std::cerr << "Usage: DistanceIVFPQ [dataset]\n";
+            return EXIT_FAILURE;
+        }
+
+        if (argc == 2)
+        {
+            groundTruth = LoadDataset(argv[1], set1, set2, NUM_OF_POINTS);
+        }
+
+        std::cout << "Starting Comparing L1 Norm\n";
+        TestSpeed(CompareL1, "CompareL1");
+
+        ComputeChecksum(indicesL1, "L1 Norm");
+
+        Cooldown();
+
+        std::cout << "Starting Comparing L2 Norm\n";
+        TestSpeed(CompareL2, "CompareL2");
+
+        ComputeChecksum(indicesL2, "L2 Norm");
+
+        Cooldown();
+
+        std::cout << "Starting Training Coarse Quantizer\n";
+        TestSpeed(TrainCoarse, "TrainCoarse");
+
+        std::cout << "Starting Training Product Quantizers\n";
+        TestSpeed(TrainProductQuantizers, "TrainProductQuantizers");
+
+        PackFastScan();
+        ReportMemory();
+
+        Cooldown();
+
+        std::cout << "Starting Searching IVF-PQ (8-bit)\n";
+        RecallCurve<CodeSize::PQ8>("IVF-PQ 8-bit");
+
+        Cooldown();
+
+        std::cout << "Starting Searching IVF-PQ (4-bit Fast-Scan)\n";
+        RecallCurve<CodeSize::PQ4>("IVF-PQ 4-bit");
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+
+auto inline CompareL1() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL1Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL2() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL2Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline SquaredDistance(float const * const lhs, float const * const rhs, size_t const dims) noexcept -> float
+{
+    float sum{0.0};
+
+    for (size_t dim = 0; dim < dims; ++dim)
+    {
+        auto const diff = lhs[dim] - rhs[dim];
+        sum += diff * diff;
+    }
+
+    return sum;
+}
+
+auto inline Nearest(float const * const point, float const * const centroids, size_t const dims, size_t const k) noexcept -> size_t
+{
+    float minDistance = std::numeric_limits<float>::max();
+    size_t minIndex{0};
+
+    for (size_t centroid = 0; centroid < k; ++centroid)
+    {
+        auto const distance = SquaredDistance(point, centroids + centroid * dims, dims);
+
+        if (distance < minDistance)
+        {
+            minDistance = distance;
+            minIndex = centroid;
+        }
+    }
+
+    return minIndex;
+}
+
+/*
+ * Lloyd iterations over count points of dims floats placed stride floats apart. The centroids start on
+ * distinct random points and an emptied centroid is moved to a random point.
+ */
+auto inline KMeans(float const * const points, size_t const count, size_t const stride, size_t const dims, size_t const k, float * const centroids, std::mt19937 & engine) noexcept -> void
+{
+    std::vector<std::uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0U);
+    std::shuffle(order.begin(), order.end(), engine);
+
+    for (size_t centroid = 0; centroid < k; ++centroid)
+    {
+        std::copy_n(points + order[centroid] * stride, dims, centroids + centroid * dims);
+    }
+
+    std::vector<std::uint32_t> assignment(count);
+    std::vector<double> sums(k * dims);
+    std::vector<size_t> sizes(k);
+    std::uniform_int_distribution<size_t> pick{0, count - 1};
+
+    for (size_t iteration = 0; iteration < KMEANS_ITERATIONS; ++iteration)
+    {
+        for (size_t idx = 0; idx < count; ++idx)
+        {
+            assignment[idx] = static_cast<std::uint32_t>(Nearest(points + idx * stride, centroids, dims, k));
+        }
+
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(sizes.begin(), sizes.end(), 0UL);
+
+        for (size_t idx = 0; idx < count; ++idx)
+        {
+            auto const centroid = assignment[idx];
+            ++sizes[centroid];
+
+            for (size_t dim = 0; dim < dims; ++dim)
+            {
+                sums[centroid * dims + dim] += static_cast<double>(points[idx * stride + dim]);
+            }
+        }
+
+        for (size_t centroid = 0; centroid < k; ++centroid)
+        {
+            if (sizes[centroid] == 0)
+            {
+                std::copy_n(points + pick(engine) * stride, dims, centroids + centroid * dims);
+                continue;
+            }
+
+            for (size_t dim = 0; dim < dims; ++dim)
+            {
+                centroids[centroid * dims + dim] = static_cast<float>(sums[centroid * dims + dim] / static_cast<double>(sizes[centroid]));
+            }
+        }
+    }
+}
+
+/*
+ * Clusters set2, groups the ids by list (CSR) and stores the residual of every descriptor in list order.
+ */
+auto inline TrainCoarse() noexcept -> void
+{
+    std::mt19937 engine{SEED};
+
+    KMeans(&set2[0][0], NUM_OF_POINTS, sizeof(Descriptor) / sizeof(float), Descriptor::DIMENSIONS, NUM_OF_LISTS, &coarseCentroids[0][0], engine);
+
+    std::vector<std::uint32_t> assignment(NUM_OF_POINTS);
+    std::fill(listOffsets, listOffsets + NUM_OF_LISTS + 1, 0U);
+
+    for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+    {
+        assignment[idx] = static_cast<std::uint32_t>(Nearest(&set2[idx][0], &coarseCentroids[0][0], Descriptor::DIMENSIONS, NUM_OF_LISTS));
+        ++listOffsets[assignment[idx] + 1];
+    }
+
+    std::partial_sum(listOffsets, listOffsets + NUM_OF_LISTS + 1, listOffsets);
+
+    std::vector<std::uint32_t> cursor(listOffsets, listOffsets + NUM_OF_LISTS);
+
+    for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+    {
+        auto const position = cursor[assignment[idx]]++;
+        listIds[position] = static_cast<std::uint32_t>(idx);
+
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            residuals[position][dim] = set2[idx][dim] - coarseCentroids[assignment[idx]][dim];
+        }
+    }
+}
+
+auto inline TrainProductQuantizers() noexcept -> void
+{
+    std::mt19937 engine{SEED};
+    constexpr size_t stride = Descriptor::DIMENSIONS;
+
+    for (size_t subspace = 0; subspace < PQ8_SUBSPACES; ++subspace)
+    {
+        auto const * const points = &residuals[0][subspace * PQ8_SUBSPACE_DIMS];
+
+        KMeans(points, NUM_OF_POINTS, stride, PQ8_SUBSPACE_DIMS, PQ8_CENTROIDS, &pq8Codebooks[subspace][0][0], engine);
+
+        for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+        {
+            pq8Codes[idx][subspace] = static_cast<std::uint8_t>(Nearest(points + idx * stride, &pq8Codebooks[subspace][0][0], PQ8_SUBSPACE_DIMS, PQ8_CENTROIDS));
+        }
+    }
+
+    for (size_t subspace = 0; subspace < PQ4_SUBSPACES; ++subspace)
+    {
+        auto const * const points = &residuals[0][subspace * PQ4_SUBSPACE_DIMS];
+
+        KMeans(points, NUM_OF_POINTS, stride, PQ4_SUBSPACE_DIMS, PQ4_CENTROIDS, &pq4Codebooks[subspace][0][0], engine);
+
+        for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+        {
+            pq4Unpacked[idx][subspace] = static_cast<std::uint8_t>(Nearest(points + idx * stride, &pq4Codebooks[subspace][0][0], PQ4_SUBSPACE_DIMS, PQ4_CENTROIDS));
+        }
+    }
+}
+
+/*
+ * Fast-scan layout: every list is padded to blocks of 32 descriptors. For each pair of subspaces a block holds
+ * 32 bytes, the first 16 for the even subspace and the last 16 for the odd one. Byte j of a half holds the code
+ * of descriptor j in its low nibble and the code of descriptor j + 16 in its high nibble.
+ */
+auto inline PackFastScan() -> void
+{
+    blockOffsets[0] = 0;
+
+    for (size_t list = 0; list < NUM_OF_LISTS; ++list)
+    {
+        auto const size = listOffsets[list + 1] - listOffsets[list];
+        blockOffsets[list + 1] = blockOffsets[list] + static_cast<std::uint32_t>((size + FAST_SCAN_BLOCK - 1U) / FAST_SCAN_BLOCK);
+    }
+
+    pq4Packed.assign(static_cast<size_t>(blockOffsets[NUM_OF_LISTS]) * FAST_SCAN_BLOCK * CODE_SIZE, 0U);
+
+    for (size_t list = 0; list < NUM_OF_LISTS; ++list)
+    {
+        for (size_t position = listOffsets[list]; position < listOffsets[list + 1]; ++position)
+        {
+            auto const inList = position - listOffsets[list];
+            auto const block = blockOffsets[list] + inList / FAST_SCAN_BLOCK;
+            auto const lane = inList % FAST_SCAN_BLOCK;
+            auto const shift = lane < FAST_SCAN_BLOCK / 2 ? 0U : 4U;
+
+            for (size_t subspace = 0; subspace < PQ4_SUBSPACES; ++subspace)
+            {
+                auto const byte = block * FAST_SCAN_BLOCK * CODE_SIZE + (subspace / 2) * 32 + (subspace % 2) * 16 + lane % 16;
+                pq4Packed[byte] |= static_cast<std::uint8_t>(pq4Unpacked[position][subspace] << shift);
+            }
+        }
+    }
+}
+
+auto inline PushCandidate(std::vector<Candidate> & heap, float const distance, std::uint32_t const index) noexcept -> void
+{
+    if (heap.size() < RERANK_SIZE)
+    {
+        heap.push_back(Candidate{distance, index});
+        std::push_heap(heap.begin(), heap.end());
+    }
+    else if (distance < heap.front().distance)
+    {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = Candidate{distance, index};
+        std::push_heap(heap.begin(), heap.end());
+    }
+}
+
+auto inline ScanPQ8(float const * const residual, size_t const list, std::vector<Candidate> & heap) noexcept -> void
+{
+    alignas(ALIGN) float table[PQ8_SUBSPACES][PQ8_CENTROIDS];
+
+    for (size_t subspace = 0; subspace < PQ8_SUBSPACES; ++subspace)
+    {
+        for (size_t centroid = 0; centroid < PQ8_CENTROIDS; ++centroid)
+        {
+            table[subspace][centroid] = SquaredDistance(residual + subspace * PQ8_SUBSPACE_DIMS, pq8Codebooks[subspace][centroid], PQ8_SUBSPACE_DIMS);
+        }
+    }
+
+    for (size_t position = listOffsets[list]; position < listOffsets[list + 1]; ++position)
+    {
+        auto const * const code = pq8Codes[position];
+        float distance{0.0};
+
+#pragma GCC unroll 16
+        for (size_t subspace = 0; subspace < PQ8_SUBSPACES; ++subspace)
+        {
+            distance += table[subspace][code[subspace]];
+        }
+
+        PushCandidate(heap, distance, listIds[position]);
+    }
+}
+
+auto inline ScanPQ4(float const * const residual, size_t const list, std::vector<Candidate> & heap) noexcept -> void
+{
+    alignas(ALIGN) float table[PQ4_SUBSPACES][PQ4_CENTROIDS];
+    alignas(ALIGN) std::uint8_t quantized[PQ4_SUBSPACES / 2][32];
+
+    float bias{0.0};
+    float range{0.0};
+    float minimums[PQ4_SUBSPACES];
+
+    for (size_t subspace = 0; subspace < PQ4_SUBSPACES; ++subspace)
+    {
+        for (size_t centroid = 0; centroid < PQ4_CENTROIDS; ++centroid)
+        {
+            table[subspace][centroid] = SquaredDistance(residual + subspace * PQ4_SUBSPACE_DIMS, pq4Codebooks[subspace][centroid], PQ4_SUBSPACE_DIMS);
+        }
+
+        auto const [minimum, maximum] = std::minmax_element(table[subspace], table[subspace] + PQ4_CENTROIDS);
+        minimums[subspace] = *minimum;
+        bias += *minimum;
+        range = std::max(range, *maximum - *minimum);
+    }
+
+    /* One scale for all subspaces so the byte sums stay proportional to the float sums */
+    auto const scale = range > 0.0F ? 255.0F / range : 0.0F;
+    auto const inverseScale = scale > 0.0F ? 1.0F / scale : 0.0F;
+
+    for (size_t subspace = 0; subspace < PQ4_SUBSPACES; ++subspace)
+    {
+        for (size_t centroid = 0; centroid < PQ4_CENTROIDS; ++centroid)
+        {
+            auto const value = std::nearbyint((table[subspace][centroid] - minimums[subspace]) * scale);
+            quantized[subspace / 2][(subspace % 2) * 16 + centroid] = static_cast<std::uint8_t>(value);
+        }
+    }
+
+    auto const lowNibbles = _mm256_set1_epi8(0x0F);
+    auto const lowBytes = _mm256_set1_epi16(0x00FF);
+
+    auto const size = listOffsets[list + 1] - listOffsets[list];
+    auto const * codes = pq4Packed.data() + static_cast<size_t>(blockOffsets[list]) * FAST_SCAN_BLOCK * CODE_SIZE;
+
+    for (size_t block = 0; block < blockOffsets[list + 1] - blockOffsets[list]; ++block)
+    {
+        __m256i lowEven = _mm256_setzero_si256();
+        __m256i lowOdd = _mm256_setzero_si256();
+        __m256i highEven = _mm256_setzero_si256();
+        __m256i highOdd = _mm256_setzero_si256();
+
+        for (size_t pair = 0; pair < PQ4_SUBSPACES / 2; ++pair)
+        {
+            auto const packed = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(codes));                  /* Codes of two subspaces for 32 descriptors (std::vector storage, unaligned) */
+            auto const lookup = _mm256_load_si256(reinterpret_cast<__m256i const *>(quantized[pair]));          /* Byte tables of the same two subspaces */
+
+            auto const low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(packed, lowNibbles));                 /* Distances of descriptors 0 to 15 */
+            auto const high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(packed, 4), lowNibbles)); /* Distances of descriptors 16 to 31 */
+
+            lowEven = _mm256_add_epi16(lowEven, _mm256_and_si256(low, lowBytes));                               /* Even descriptors in 16-bit lanes */
+            lowOdd = _mm256_add_epi16(lowOdd, _mm256_srli_epi16(low, 8));                                       /* Odd descriptors in 16-bit lanes */
+            highEven = _mm256_add_epi16(highEven, _mm256_and_si256(high, lowBytes));
+            highOdd = _mm256_add_epi16(highOdd, _mm256_srli_epi16(high, 8));
+
+            codes += 32;
+        }
+
+        /* The two 128-bit lanes hold the even and odd subspaces of the same descriptors */
+        auto const fold = [](__m256i const vector) noexcept { return _mm_add_epi16(_mm256_castsi256_si128(vector), _mm256_extracti128_si256(vector, 1)); };
+
+        auto const lowSums = _mm256_set_m128i(_mm_unpackhi_epi16(fold(lowEven), fold(lowOdd)), _mm_unpacklo_epi16(fold(lowEven), fold(lowOdd)));
+        auto const highSums = _mm256_set_m128i(_mm_unpackhi_epi16(fold(highEven), fold(highOdd)), _mm_unpacklo_epi16(fold(highEven), fold(highOdd)));
+
+        auto const first = block * FAST_SCAN_BLOCK;
+        auto const valid = std::min<size_t>(FAST_SCAN_BLOCK, size - first);
+        auto const validMask = valid == FAST_SCAN_BLOCK ? 0xFFFF'FFFFU : (1U << valid) - 1U;
+
+        /* Descriptors whose quantized distance is below the current worst candidate, as one bit per descriptor */
+        auto const threshold = heap.size() < RERANK_SIZE ? 0x7FFF : static_cast<int>(std::clamp((heap.front().distance - bias) * scale + 1.0F, 0.0F, 32767.0F));
+        auto const limit = _mm256_set1_epi16(static_cast<short>(threshold));
+
+        auto const lowHits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi16(limit, lowSums)));
+        auto const highHits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi16(limit, highSums)));
+
+        auto hits = (_pext_u32(lowHits, 0x5555'5555U) | (_pext_u32(highHits, 0x5555'5555U) << 16U)) & validMask;
+
+        if (hits == 0)
+        {
+            continue;
+        }
+
+        alignas(ALIGN) std::uint16_t sums[FAST_SCAN_BLOCK];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(sums), lowSums);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(sums + 16), highSums);
+
+        while (hits != 0)
+        {
+            auto const lane = static_cast<size_t>(std::countr_zero(hits));
+            hits &= hits - 1;
+
+            auto const distance = bias + static_cast<float>(sums[lane]) * inverseScale;
+            PushCandidate(heap, distance, listIds[listOffsets[list] + first + lane]);
+        }
+    }
+}
+
+template <CodeSize Codes>
+auto inline SearchIVFPQ(size_t const nprobe) noexcept -> void
+{
+    std::vector<Candidate> heap;
+    heap.reserve(RERANK_SIZE);
+
+    Candidate lists[NUM_OF_LISTS];
+    alignas(ALIGN) float residual[Descriptor::DIMENSIONS];
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        auto const & query = set1[idx1];
+
+        for (size_t list = 0; list < NUM_OF_LISTS; ++list)
+        {
+            lists[list] = Candidate{SquaredDistance(&query[0], coarseCentroids[list], Descriptor::DIMENSIONS), static_cast<std::uint32_t>(list)};
+        }
+
+        std::partial_sort(lists, lists + nprobe, lists + NUM_OF_LISTS);
+
+        heap.clear();
+
+        for (size_t probe = 0; probe < nprobe; ++probe)
+        {
+            auto const list = lists[probe].index;
+
+            for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+            {
+                residual[dim] = query[dim] - coarseCentroids[list][dim];
+            }
+
+            if constexpr (Codes == CodeSize::PQ8)
+            {
+                ScanPQ8(residual, list, heap);
+            }
+            else
+            {
+                ScanPQ4(residual, list, heap);
+            }
+        }
+
+        /* Exact re-rank, ties go to the lower index like in the brute-force search */
+        float minDistance = std::numeric_limits<float>::max();
+        size_t minIndex{0};
+
+        for (auto const & candidate : heap)
+        {
+            auto const distance = Descriptor::getL2Norm(query, set2[candidate.index]);
+
+            if (distance < minDistance || (distance == minDistance && candidate.index < minIndex))
+            {
+                minDistance = distance;
+                minIndex = candidate.index;
+            }
+        }
+
+        indicesIVFPQ[idx1] = minIndex;
+    }
+}
+
+template <CodeSize Codes>
+auto inline RecallCurve(std::string_view const message) -> void
+{
+    for (auto const nprobe : NPROBE)
+    {
+        auto const start = std::chrono::high_resolution_clock::now();
+        SearchIVFPQ<Codes>(nprobe);
+        auto const stop = std::chrono::high_resolution_clock::now();
+
+        auto const time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
+
+        auto const hits = std::transform_reduce(indicesL2, indicesL2 + NUM_OF_POINTS, indicesIVFPQ, 0UL, std::plus<>(), std::equal_to<>());
+        auto const recall = static_cast<double>(hits) / static_cast<double>(NUM_OF_POINTS) * 100.0;
+        auto const checksum = std::reduce(indicesIVFPQ, indicesIVFPQ + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+
+        std::cout << std::format("nprobe {:>2} for {} : Recall@1 {:6.2f}%, {:>5} ms, checksum {:#x}\n", nprobe, message, recall, time_ms, checksum);
+
+        /* Like the codes, the floats of the re-ranked candidates could stay on disk */
+        auto const codeBytes = Codes == CodeSize::PQ8 ? sizeof(pq8Codes) + sizeof(pq8Codebooks) : pq4Packed.size() + sizeof(pq4Codebooks);
+        auto const queriesPerSecond = static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(time_ms, 1L)) / 1e3);
+
+        AppendRecall(groundTruth, message, std::format("nprobe={}", nprobe), 1, GroundTruthRecall(groundTruth, indicesIVFPQ, NUM_OF_POINTS), queriesPerSecond, 1, codeBytes + sizeof(listIds) + sizeof(coarseCentroids));
+    }
+}
+
+auto inline ReportMemory() noexcept -> void
+{
+    constexpr auto floatBytes = sizeof(Descriptor) * NUM_OF_POINTS;
+    constexpr auto codeBytes = static_cast<size_t>(CODE_SIZE) * NUM_OF_POINTS;
+    constexpr auto idBytes = sizeof(std::uint32_t) * NUM_OF_POINTS;
+
+    std::cout << std::format("Memory : {:.2f} MB as floats, {:.2f} MB of codes ({:.1f}x), {:.2f} MB with ids ({:.1f}x)\n", static_cast<double>(floatBytes) / 1e6,
+                             static_cast<double>(codeBytes) / 1e6, static_cast<double>(floatBytes) / static_cast<double>(codeBytes),
+                             static_cast<double>(codeBytes + idBytes) / 1e6, static_cast<double>(floatBytes) / static_cast<double>(codeBytes + idBytes));
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -0,0 +1,577 @@
+/*
+## Randomized KD-Forest
+
+An approximate index in the style of FLANN. Each tree splits on a dimension drawn at random from the few with
+the highest variance (estimated on a sample), at the mean of that dimension, until a node holds at most
+MAX_LEAF_SIZE descriptors. The trees are built in parallel, one per thread, each with its own seeded engine.
+
+The nodes of a tree live in one flat array and the two children of a node are allocated next to each other,
+so a descent touches consecutive cache lines. Leaves refer to a range of a per-tree permutation of the
+reference indices.
+
+A query descends every tree once and pushes each branch it skips onto a shared priority queue keyed by an
+approximate bound of its distance: the L1 bound adds |q[d] - t| and the L2 bound adds (q[d] - t)² per split
+crossed, as FLANN does. It is not a true lower bound once a path splits the same dimension more than once,
+since the gaps to nested thresholds along one dimension are added up where only the largest one applies.
+Branches are then popped in order until the checks budget (number of distance evaluations) is spent or the
+best bound exceeds the current best distance, so that cutoff is a heuristic as well. A visited bitmap keeps a
+reference seen by several trees from being evaluated twice. Queries run in parallel in batches of
+QUERY_BATCH_SIZE.
+
+The recall@1 against the brute-force search and the throughput are reported for a range of budgets.
+
+Usage: DistanceKDForest [dataset]. Given the name of a DistanceDataset dataset, the sets are read from its .dset
+files and the L2 points are scored against its cached .gt and appended to ../recall.csv.
+*/
+
+#include "Dataset.hpp"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <vector>
+#include <bitset>
+
+#include <immintrin.h>
+#include <omp.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    NUM_OF_TREES = 4,
+    MAX_LEAF_SIZE = 16,
+    NUM_OF_SPLIT_CANDIDATES = 5,
+    VARIANCE_SAMPLE_SIZE = 128,
+    MAX_NUM_OF_NODES = 2 * NUM_OF_POINTS,
+    QUERY_BATCH_SIZE = 64,
+};
+
+static constexpr std::uint32_t LEAF{std::numeric_limits<std::uint32_t>::max()};
+static constexpr size_t CHECKS[]{32, 64, 128, 256, 512, 1024, 2048, 4096};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+/*
+ * Inner nodes split on dimension at threshold and store the index of their left child (the right one follows
+ * it). Leaves are marked with dimension == LEAF and store the range [begin, begin + count) of the permutation.
+ */
+struct Node
+{
+    std::uint32_t dimension;
+    float threshold;
+    std::uint32_t child;
+    std::uint32_t count;
+};
+
+struct Tree
+{
+    alignas(ALIGN) Node nodes[MAX_NUM_OF_NODES];
+    alignas(ALIGN) std::uint32_t indices[NUM_OF_POINTS];
+    size_t numOfNodes;
+};
+
+struct Branch
+{
+    float bound;
+    std::uint32_t tree;
+    std::uint32_t node;
+
+    bool operator>(Branch const & other) const noexcept
+    {
+        return bound > other.bound;
+    }
+};
+
+enum class Norm : std::uint8_t
+{
+    L1,
+    L2,
+};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesForest[NUM_OF_POINTS];
+
+alignas(ALIGN) Tree forest[NUM_OF_TREES];
+
+static GroundTruth groundTruth{};
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+
+auto inline CompareL1() noexcept -> void;
+auto inline CompareL2() noexcept -> void;
+
+auto inline BuildForest() noexcept -> void;
+auto inline BuildNode(Tree & tree, std::uint32_t const node, std::uint32_t const begin, std::uint32_t const count, std::mt19937 & engine) noexcept -> void;
+
+template <Norm Metric>
+auto inline SearchForest(size_t const checks) noexcept -> void;
+template <Norm Metric>
+auto inline SearchQuery(Descriptor const & query, size_t const checks, std::vector<Branch> & heap, std::bitset<NUM_OF_POINTS> & visited) noexcept -> size_t;
+
+template <Norm Metric>
+auto inline RecallCurve(size_t const * const exact, long const bruteForce_ms, std::string_view const message) -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main(int const argc, char const * const argv[])
+{
+    try
+    {
+        if (argc > 2)
+        {
+            std::cerr << "Usage: DistanceKDForest [dataset]\n";
+            return EXIT_FAILURE;
+        }
+
+        if (argc == 2)
+        {
+            groundTruth = LoadDataset(argv[1], set1, set2, NUM_OF_POINTS);
+        }
+
+        std::cout << "Starting Comparing L1 Norm\n";
+        auto const bruteForceL1_ms = TestSpeed(CompareL1, "CompareL1");
+
+        ComputeChecksum(indicesL1, "L1 Norm");
+
+        Cooldown();
+
+        std::cout << "Starting Comparing L2 Norm\n";
+        auto const bruteForceL2_ms = TestSpeed(CompareL2, "CompareL2");
+
+        ComputeChecksum(indicesL2, "L2 Norm");
+
+        Cooldown();
+
+        std::cout << std::format("Starting Building Forest ({} trees, {} threads)\n", static_cast<size_t>(NUM_OF_TREES), omp_get_max_threads());
+        TestSpeed(BuildForest, "BuildForest");
+
+        Cooldown();
+
+        std::cout << "Starting Searching Forest L1 Norm\n";
+        RecallCurve<Norm::L1>(indicesL1, bruteForceL1_ms, "L1 Norm");
+
+        Cooldown();
+
+        std::cout << "Starting Searching Forest L2 Norm\n";
+        RecallCurve<Norm::L2>(indicesL2, bruteForceL2_ms, "L2 Norm");
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+
+    return time_ms;
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+
+auto inline CompareL1() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL1Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL2() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL2Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline BuildForest() noexcept -> void
+{
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t treeIdx = 0; treeIdx < NUM_OF_TREES; ++treeIdx)
+    {
+        auto & tree = forest[treeIdx];
+        std::mt19937 engine{static_cast<std::mt19937::result_type>(SEED + treeIdx)};
+
+        std::iota(tree.indices, tree.indices + NUM_OF_POINTS, 0U);
+        tree.numOfNodes = 1;
+
+        BuildNode(tree, 0, 0, NUM_OF_POINTS, engine);
+    }
+}
+
+auto inline BuildNode(Tree & tree, std::uint32_t const node, std::uint32_t const begin, std::uint32_t const count, std::mt19937 & engine) noexcept -> void
+{
+    auto * const first = tree.indices + begin;
+
+    if (count <= MAX_LEAF_SIZE)
+    {
+        tree.nodes[node] = Node{LEAF, 0.0F, begin, count};
+        return;
+    }
+
+    double mean[Descriptor::DIMENSIONS]{};
+    double variance[Descriptor::DIMENSIONS]{};
+
+    auto const sampleSize = std::min<std::uint32_t>(count, VARIANCE_SAMPLE_SIZE);
+
+    for (size_t idx = 0; idx < sampleSize; ++idx)
+    {
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            mean[dim] += static_cast<double>(set2[first[idx]][dim]);
+        }
+    }
+
+    for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+    {
+        mean[dim] /= sampleSize;
+    }
+
+    for (size_t idx = 0; idx < sampleSize; ++idx)
+    {
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            auto const diff = static_cast<double>(set2[first[idx]][dim]) - mean[dim];
+            variance[dim] += diff * diff;
+        }
+    }
+
+    std::uint32_t candidates[Descriptor::DIMENSIONS];
+    std::iota(candidates, candidates + Descriptor::DIMENSIONS, 0U);
+    std::partial_sort(candidates, candidates + NUM_OF_SPLIT_CANDIDATES, candidates + Descriptor::DIMENSIONS,
+                      [&variance](std::uint32_t const lhs, std::uint32_t const rhs) { return variance[lhs] > variance[rhs]; });
+
+    std::uniform_int_distribution<std::uint32_t> pick{0, NUM_OF_SPLIT_CANDIDATES - 1};
+
+    auto const dimension = candidates[pick(engine)];
+    auto threshold = static_cast<float>(mean[dimension]);
+
+    auto * middle = std::partition(first, first + count, [dimension, threshold](std::uint32_t const idx) { return set2[idx][dimension] < threshold; });
+
+    if (middle == first || middle == first + count)
+    {
+        /* The sample mean missed the spread of the node, split at the median instead */
+        middle = first + count / 2;
+        std::nth_element(first, middle, first + count, [dimension](std::uint32_t const lhs, std::uint32_t const rhs) { return set2[lhs][dimension] < set2[rhs][dimension]; });
+        threshold = set2[*middle][dimension];
+    }
+
+    auto const child = static_cast<std::uint32_t>(tree.numOfNodes);
+    tree.numOfNodes += 2;
+
+    tree.nodes[node] = Node{dimension, threshold, child, count};
+
+    auto const leftCount = static_cast<std::uint32_t>(middle - first);
+
+    BuildNode(tree, child, begin, leftCount, engine);
+    BuildNode(tree, child + 1, begin + leftCount, count - leftCount, engine);
+}
+
+template <Norm Metric>
+auto inline SearchForest(size_t const checks) noexcept -> void
+{
+#pragma omp parallel
+    {
+        std::vector<Branch> heap;
+        heap.reserve(NUM_OF_TREES * MAX_NUM_OF_NODES / MAX_LEAF_SIZE);
+
+        std::bitset<NUM_OF_POINTS> visited;
+
+#pragma omp for schedule(dynamic, QUERY_BATCH_SIZE)
+        for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+        {
+            indicesForest[idx1] = SearchQuery<Metric>(set1[idx1], checks, heap, visited);
+        }
+    }
+}
+
+template <Norm Metric>
+auto inline SearchQuery(Descriptor const & query, size_t const checks, std::vector<Branch> & heap, std::bitset<NUM_OF_POINTS> & visited) noexcept -> size_t
+{
+    float minDistance = std::numeric_limits<float>::max();
+    float currentDistance{0.0};
+    size_t minIndex{0};
+    size_t performed{0};
+
+    heap.clear();
+    visited.reset();
+
+    /* Branch bounds are kept in the squared space for L2, so the current best is compared squared as well */
+    auto const comparable = [](float const distance) noexcept -> float { return Metric == Norm::L2 ? distance * distance : distance; };
+
+    auto const descend = [&](std::uint32_t const treeIdx, std::uint32_t nodeIdx, float const bound) noexcept -> void
+    {
+        auto const & tree = forest[treeIdx];
+
+        while (tree.nodes[nodeIdx].dimension != LEAF)
+        {
+            auto const & node = tree.nodes[nodeIdx];
+
+            auto const diff = query[node.dimension] - node.threshold;
+            auto const near = diff < 0.0F ? node.child : node.child + 1;
+            auto const far = diff < 0.0F ? node.child + 1 : node.child;
+
+            auto const farBound = bound + (Metric == Norm::L2 ? diff * diff : std::abs(diff));
+
+            if (farBound < comparable(minDistance))
+            {
+                heap.push_back(Branch{farBound, treeIdx, far});
+                std::push_heap(heap.begin(), heap.end(), std::greater<>());
+            }
+
+            nodeIdx = near;
+        }
+
+        auto const & leaf = tree.nodes[nodeIdx];
+
+        for (size_t idx = leaf.child; idx < leaf.child + leaf.count; ++idx)
+        {
+            auto const idx2 = tree.indices[idx];
+
+            if (visited.test(idx2))
+            {
+                continue;
+            }
+
+            visited.set(idx2);
+            ++performed;
+
+            currentDistance = Metric == Norm::L2 ? Descriptor::getL2Norm(query, set2[idx2]) : Descriptor::getL1Norm(query, set2[idx2]);
+
+            if (currentDistance < minDistance || (currentDistance == minDistance && idx2 < minIndex))
+            {
+                minDistance = currentDistance;
+                minIndex = idx2;
+            }
+        }
+    };
+
+    for (std::uint32_t treeIdx = 0; treeIdx < NUM_OF_TREES; ++treeIdx)
+    {
+        descend(treeIdx, 0, 0.0F);
+    }
+
+    while (!heap.empty() && performed < checks)
+    {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+        auto const branch = heap.back();
+        heap.pop_back();
+
+        if (branch.bound >= comparable(minDistance))
+        {
+            break;
+        }
+
+        descend(branch.tree, branch.node, branch.bound);
+    }
+
+    return minIndex;
+}
+
+template <Norm Metric>
+auto inline RecallCurve(size_t const * const exact, long const bruteForce_ms, std::string_view const message) -> void
+{
+    auto const bruteForceQps = static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(bruteForce_ms, 1L)) / 1e3);
+
+    std::cout << std::format("Brute force for {} : {:.0f} queries/s\n", message, bruteForceQps);
+
+    for (auto const checks : CHECKS)
+    {
+        auto const start = std::chrono::high_resolution_clock::now();
+        SearchForest<Metric>(checks);
+        auto const stop = std::chrono::high_resolution_clock::now();
+
+        auto const seconds = std::chrono::duration<double>(stop - start).count();
+        auto const qps = static_cast<double>(NUM_OF_POINTS) / seconds;
+
+        auto const hits = std::transform_reduce(exact, exact + NUM_OF_POINTS, indicesForest, 0UL, std::plus<>(), std::equal_to<>());
+        auto const recall = static_cast<double>(hits) / static_cast<double>(NUM_OF_POINTS) * 100.0;
+
+        std::cout << std::format("Checks {:>5} for {} : Recall@1 {:6.2f}%, {:>9.0f} queries/s ({:5.2f}x)\n", checks, message, recall, qps, qps / bruteForceQps);
+
+        /* The trees index the float descriptors, which are scanned at the leaves */
+        if constexpr (Metric == Norm::L2)
+        {
+            AppendRecall(groundTruth, "KD-Forest", std::format("checks={}", checks), 1, GroundTruthRecall(groundTruth, indicesForest, NUM_OF_POINTS), qps, omp_get_max_threads(), sizeof(forest) + sizeof(set2));
+        }
+    }
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
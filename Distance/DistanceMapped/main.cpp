@@ -0,0 +1,732 @@
+/*
+## Memory-Mapped Datasets
+
+The descriptor sets live in a binary container instead of static arrays filled at startup:
+
+    offset  0 : magic "DSET", version, dimensions, dtype (0 = float32, 1 = uint8)
+    offset 16 : count, alignment, payload offset, record stride (all 64-bit)
+    offset 48 : reserved, zero
+    offset 64 : payload, count records of stride bytes, each starting on an alignment boundary
+
+With 64-byte alignment a float record is exactly one Descriptor and a uint8 record exactly one ByteDescriptor,
+so the file is mapped read-only and the kernels run directly on the mapping without a copy. The records are the
+ones of .fvecs/.bvecs without the leading 32-bit dimension, and files in either format are converted into the
+container before mapping, one record at a time so a dump larger than memory converts as well. Byte descriptors
+are searched with exact integer kernels (SAD for L1, 16-bit multiply-add for L2); both sets must share a type.
+
+Mapping is lazy by default. MAP_POPULATE asks the kernel to fault the whole file in during mmap, while the
+prefault mode advises MADV_WILLNEED (and MADV_HUGEPAGE) and touches one byte per page from all OpenMP threads.
+
+Usage: DistanceMapped [set1 set2], where each set is a .dset, .fvecs or .bvecs file. Without arguments the
+seeded sets are generated once, written as .fvecs, converted, and then mapped like real data.
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <fstream>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <exception>
+
+#include <immintrin.h>
+#include <omp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    BYTE_VECTOR_SIZE = 32,
+    PAYLOAD_ALIGNMENT = 64,
+    PREFAULT_STRIDE = 4'096,
+};
+
+static constexpr std::uint32_t DATASET_MAGIC{0x54455344U}; /* "DSET" */
+static constexpr std::uint32_t DATASET_VERSION{1U};
+
+static constexpr std::string_view DEFAULT_SET1{"../set1.fvecs"};
+static constexpr std::string_view DEFAULT_SET2{"../set2.fvecs"};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+/*
+ * A uint8 record of a .bvecs dump (such as SIFT1B). Only ever viewed on a mapping, never constructed.
+ */
+class ByteDescriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    ByteDescriptor() = delete;
+
+    static float getL1Norm(ByteDescriptor const & lhs, ByteDescriptor const & rhs) noexcept
+    {
+        auto const * const left = reinterpret_cast<__m256i const *>(lhs.features);
+        auto const * const right = reinterpret_cast<__m256i const *>(rhs.features);
+
+        __m256i const sum0 = _mm256_add_epi64(_mm256_sad_epu8(_mm256_load_si256(left + 0), _mm256_load_si256(right + 0)),
+                                              _mm256_sad_epu8(_mm256_load_si256(left + 1), _mm256_load_si256(right + 1)));
+        __m256i const sum1 = _mm256_add_epi64(_mm256_sad_epu8(_mm256_load_si256(left + 2), _mm256_load_si256(right + 2)),
+                                              _mm256_sad_epu8(_mm256_load_si256(left + 3), _mm256_load_si256(right + 3)));
+
+        __m256i const sum = _mm256_add_epi64(sum0, sum1);
+        __m128i const sum128 = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+
+        return static_cast<float>(_mm_cvtsi128_si64(_mm_add_epi64(sum128, _mm_unpackhi_epi64(sum128, sum128))));
+    }
+
+    static float getL2Norm(ByteDescriptor const & lhs, ByteDescriptor const & rhs) noexcept
+    {
+        auto const * const left = reinterpret_cast<__m256i const *>(lhs.features);
+        auto const * const right = reinterpret_cast<__m256i const *>(rhs.features);
+
+        __m256i const zero = _mm256_setzero_si256();
+        __m256i sum = _mm256_setzero_si256();
+
+        for (size_t idx = 0; idx < DIMENSIONS / BYTE_VECTOR_SIZE; ++idx)
+        {
+            __m256i const a = _mm256_load_si256(left + idx);
+            __m256i const b = _mm256_load_si256(right + idx);
+            __m256i const diff = _mm256_sub_epi8(_mm256_max_epu8(a, b), _mm256_min_epu8(a, b)); /* |a - b| as unsigned bytes */
+            __m256i const low = _mm256_unpacklo_epi8(diff, zero);                                /* Widen to 16-bit lanes */
+            __m256i const high = _mm256_unpackhi_epi8(diff, zero);
+
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(low, low));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(high, high));
+        }
+
+        __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        return std::sqrt(static_cast<float>(_mm_cvtsi128_si32(sum128)));
+    }
+
+private:
+    alignas(ALIGN) std::uint8_t features[DIMENSIONS];
+};
+
+
+enum class DataType : std::uint32_t
+{
+    FLOAT32 = 0,
+    UINT8 = 1,
+};
+
+enum class MapMode : std::uint8_t
+{
+    LAZY,
+    POPULATE,
+    PREFAULT,
+};
+
+struct DatasetHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t dimensions;
+    DataType dtype;
+    std::uint64_t count;
+    std::uint64_t alignment;
+    std::uint64_t payloadOffset;
+    std::uint64_t stride;
+    std::uint8_t reserved[16];
+};
+
+static_assert(sizeof(DatasetHeader) == PAYLOAD_ALIGNMENT, "The payload must start on the first aligned boundary");
+static_assert(sizeof(Descriptor) == Descriptor::DIMENSIONS * sizeof(float), "A float record must be exactly one Descriptor");
+static_assert(sizeof(ByteDescriptor) == ByteDescriptor::DIMENSIONS, "A uint8 record must be exactly one ByteDescriptor");
+
+
+/*
+ * Read-only mapping of a dataset file, unmapped on destruction.
+ */
+class MappedDataset
+{
+public:
+    MappedDataset(std::string_view const fileName, MapMode const mode)
+    {
+        auto const descriptor = open(fileName.data(), O_RDONLY);
+
+        if (descriptor < 0)
+        {
+            throw std::runtime_error{std::format("Failed to open dataset {}: {}", fileName, std::strerror(errno))};
+        }
+
+        struct stat status{};
+
+        if (fstat(descriptor, &status) != 0)
+        {
+            close(descriptor);
+            throw std::runtime_error{std::format("Failed to stat dataset {}: {}", fileName, std::strerror(errno))};
+        }
+
+        size = static_cast<size_t>(status.st_size);
+
+        auto const flags = MAP_PRIVATE | (mode == MapMode::POPULATE ? MAP_POPULATE : 0);
+        auto * const mapping = mmap(nullptr, size, PROT_READ, flags, descriptor, 0);
+
+        close(descriptor);
+
+        if (mapping == MAP_FAILED)
+        {
+            throw std::runtime_error{std::format("Failed to map dataset {}: {}", fileName, std::strerror(errno))};
+        }
+
+        base = static_cast<std::byte const *>(mapping);
+
+        if (size < sizeof(DatasetHeader))
+        {
+            Unmap();
+            throw std::runtime_error{std::format("Dataset {} is smaller than its header", fileName)};
+        }
+
+        std::memcpy(&header, base, sizeof(header));
+
+        if (header.magic != DATASET_MAGIC || header.version != DATASET_VERSION || header.alignment == 0 || header.payloadOffset % header.alignment != 0 ||
+            header.stride == 0 || header.stride % header.alignment != 0 || header.payloadOffset < sizeof(DatasetHeader) || header.payloadOffset > size ||
+            header.count > (size - header.payloadOffset) / header.stride)
+        {
+            Unmap();
+            throw std::runtime_error{std::format("Dataset {} has an invalid header", fileName)};
+        }
+
+        if (mode == MapMode::PREFAULT)
+        {
+            madvise(const_cast<std::byte *>(base), size, MADV_WILLNEED);
+            madvise(const_cast<std::byte *>(base), size, MADV_HUGEPAGE);
+            Prefault();
+        }
+    }
+
+    MappedDataset(MappedDataset const &) = delete;
+    MappedDataset & operator=(MappedDataset const &) = delete;
+
+    ~MappedDataset()
+    {
+        Unmap();
+    }
+
+    /*
+     * The records viewed as Record (Descriptor or ByteDescriptor), only valid for datasets of that type and of
+     * matching dimensions.
+     */
+    template <typename Record>
+    Record const * Records(DataType const dtype) const
+    {
+        if (header.dtype != dtype || header.dimensions != Record::DIMENSIONS || header.stride != sizeof(Record))
+        {
+            throw std::runtime_error{std::format("Dataset is not a set of {}-D {} descriptors", Record::DIMENSIONS, dtype == DataType::FLOAT32 ? "float" : "uint8")};
+        }
+
+        return reinterpret_cast<Record const *>(base + header.payloadOffset);
+    }
+
+    DataType Type() const noexcept
+    {
+        return header.dtype;
+    }
+
+    size_t Count() const noexcept
+    {
+        return header.count;
+    }
+
+    size_t Size() const noexcept
+    {
+        return size;
+    }
+
+private:
+    /*
+     * Every thread reads one byte of each page in its share of the mapping, so the page faults are taken in
+     * parallel instead of on the first pass of the search.
+     */
+    void Prefault() const noexcept
+    {
+        auto const pages = (size + PREFAULT_STRIDE - 1) / PREFAULT_STRIDE;
+        std::uint64_t sink{0};
+
+#pragma omp parallel for schedule(static) reduction(+ : sink)
+        for (size_t page = 0; page < pages; ++page)
+        {
+            sink += static_cast<std::uint64_t>(*reinterpret_cast<volatile std::uint8_t const *>(base + page * PREFAULT_STRIDE));
+        }
+
+        static_cast<void>(sink);
+    }
+
+    void Unmap() noexcept
+    {
+        if (base != nullptr)
+        {
+            munmap(const_cast<std::byte *>(base), size);
+            base = nullptr;
+        }
+    }
+
+    std::byte const * base{nullptr};
+    size_t size{0};
+    DatasetHeader header{};
+};
+
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void;
+auto inline ComputeChecksum(std::vector<size_t> const & indices, std::string_view const message) noexcept -> void;
+
+auto inline CompareL1(MappedDataset const & lhs, MappedDataset const & rhs, std::vector<size_t> & indices) -> void;
+auto inline CompareL2(MappedDataset const & lhs, MappedDataset const & rhs, std::vector<size_t> & indices) -> void;
+
+template <typename Record, typename Distance>
+auto inline Compare(Record const * const set1, Record const * const set2, size_t const count1, size_t const count2, Distance const & distance,
+                    std::vector<size_t> & indices) noexcept -> void;
+
+auto inline MakeHeader(size_t const count, std::uint32_t const dimensions, DataType const dtype) noexcept -> DatasetHeader;
+auto inline WriteDataset(std::string_view const fileName, void const * const records, size_t const count, std::uint32_t const dimensions, DataType const dtype) -> void;
+auto inline WriteVecs(std::string_view const fileName, void const * const records, size_t const count, std::uint32_t const dimensions, DataType const dtype) -> void;
+auto inline ConvertVecs(std::string_view const fileName) -> std::string;
+auto inline ResolveDataset(std::string_view const fileName) -> std::string;
+auto inline GenerateSeeded() -> void;
+
+auto inline ElementSize(DataType const dtype) noexcept -> size_t;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main(int const argc, char const * const argv[])
+{
+    try
+    {
+        if (argc != 1 && argc != 3)
+        {
+            std::cerr << "Usage: DistanceMapped [set1 set2]\n";
+            return EXIT_FAILURE;
+        }
+
+        if (argc == 1)
+        {
+            std::cout << "Starting Generating Seeded Sets\n";
+            TestSpeed(GenerateSeeded, "GenerateSeeded");
+        }
+
+        std::string const set1File = ResolveDataset(argc == 3 ? argv[1] : DEFAULT_SET1);
+        std::string const set2File = ResolveDataset(argc == 3 ? argv[2] : DEFAULT_SET2);
+
+        for (auto const & [mode, name] : {std::pair{MapMode::LAZY, "Lazy"}, std::pair{MapMode::POPULATE, "MAP_POPULATE"}, std::pair{MapMode::PREFAULT, "Prefault"}})
+        {
+            std::unique_ptr<MappedDataset> set1;
+            std::unique_ptr<MappedDataset> set2;
+
+            std::cout << std::format("Starting Mapping ({})\n", name);
+            std::exception_ptr error;
+
+            TestSpeed([&] {
+                try
+                {
+                    set1 = std::make_unique<MappedDataset>(set1File, mode);
+                    set2 = std::make_unique<MappedDataset>(set2File, mode);
+                }
+                catch (...)
+                {
+                    error = std::current_exception(); /* TestSpeed is noexcept, so an invalid header is rethrown after it */
+                }
+            }, std::format("Map ({})", name));
+
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+
+            if (set1->Type() != set2->Type())
+            {
+                throw std::runtime_error{std::format("Sets {} and {} hold different element types", set1File, set2File)};
+            }
+
+            std::vector<size_t> indices(set1->Count());
+
+            std::cout << std::format("Starting Comparing L1 Norm ({}, {} x {})\n", name, set1->Count(), set2->Count());
+            TestSpeed([&] { CompareL1(*set1, *set2, indices); }, "CompareL1");
+
+            ComputeChecksum(indices, "L1 Norm");
+
+            Cooldown();
+
+            std::cout << std::format("Starting Comparing L2 Norm ({}, {} x {})\n", name, set1->Count(), set2->Count());
+            TestSpeed([&] { CompareL2(*set1, *set2, indices); }, "CompareL2");
+
+            ComputeChecksum(indices, "L2 Norm");
+
+            Cooldown();
+        }
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_us = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    auto const time_ms = static_cast<double>(difference_us.count()) / 1e3;
+
+    std::cout << std::format("Time taken for {} : {:.3f} ms\n", message, time_ms);
+}
+
+auto inline ComputeChecksum(std::vector<size_t> const & indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices.begin(), indices.end(), 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+auto inline CompareL1(MappedDataset const & lhs, MappedDataset const & rhs, std::vector<size_t> & indices) -> void
+{
+    if (lhs.Type() == DataType::UINT8)
+    {
+        Compare(lhs.Records<ByteDescriptor>(DataType::UINT8), rhs.Records<ByteDescriptor>(DataType::UINT8), lhs.Count(), rhs.Count(), ByteDescriptor::getL1Norm, indices);
+    }
+    else
+    {
+        Compare(lhs.Records<Descriptor>(DataType::FLOAT32), rhs.Records<Descriptor>(DataType::FLOAT32), lhs.Count(), rhs.Count(), Descriptor::getL1Norm, indices);
+    }
+}
+
+auto inline CompareL2(MappedDataset const & lhs, MappedDataset const & rhs, std::vector<size_t> & indices) -> void
+{
+    if (lhs.Type() == DataType::UINT8)
+    {
+        Compare(lhs.Records<ByteDescriptor>(DataType::UINT8), rhs.Records<ByteDescriptor>(DataType::UINT8), lhs.Count(), rhs.Count(), ByteDescriptor::getL2Norm, indices);
+    }
+    else
+    {
+        Compare(lhs.Records<Descriptor>(DataType::FLOAT32), rhs.Records<Descriptor>(DataType::FLOAT32), lhs.Count(), rhs.Count(), Descriptor::getL2Norm, indices);
+    }
+}
+
+template <typename Record, typename Distance>
+auto inline Compare(Record const * const set1, Record const * const set2, size_t const count1, size_t const count2, Distance const & distance,
+                    std::vector<size_t> & indices) noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < count1; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < count2; ++idx2)
+        {
+            currentDistance = distance(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indices[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline ElementSize(DataType const dtype) noexcept -> size_t
+{
+    return dtype == DataType::FLOAT32 ? sizeof(float) : sizeof(std::uint8_t);
+}
+
+/*
+ * Header of a dataset whose records are padded to the next PAYLOAD_ALIGNMENT boundary.
+ */
+auto inline MakeHeader(size_t const count, std::uint32_t const dimensions, DataType const dtype) noexcept -> DatasetHeader
+{
+    auto const recordSize = dimensions * ElementSize(dtype);
+    auto const stride = (recordSize + PAYLOAD_ALIGNMENT - 1) / PAYLOAD_ALIGNMENT * PAYLOAD_ALIGNMENT;
+
+    return DatasetHeader{DATASET_MAGIC, DATASET_VERSION, dimensions, dtype, count, PAYLOAD_ALIGNMENT, sizeof(DatasetHeader), stride, {}};
+}
+
+/*
+ * Records are packed (dimensions elements each) in memory and padded to the stride in the file.
+ */
+auto inline WriteDataset(std::string_view const fileName, void const * const records, size_t const count, std::uint32_t const dimensions, DataType const dtype) -> void
+{
+    std::ofstream file{fileName.data(), std::ios::binary};
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error{std::format("Failed to open output file: {}", fileName)};
+    }
+
+    auto const header = MakeHeader(count, dimensions, dtype);
+    auto const recordSize = dimensions * ElementSize(dtype);
+    auto const stride = header.stride;
+
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+
+    std::vector<char> record(stride, 0);
+    auto const * const bytes = static_cast<char const *>(records);
+
+    for (size_t idx = 0; idx < count; ++idx)
+    {
+        std::copy_n(bytes + idx * recordSize, recordSize, record.data());
+        file.write(record.data(), static_cast<std::streamsize>(stride));
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error{std::format("Failed to write dataset: {}", fileName)};
+    }
+}
+
+auto inline WriteVecs(std::string_view const fileName, void const * const records, size_t const count, std::uint32_t const dimensions, DataType const dtype) -> void
+{
+    std::ofstream file{fileName.data(), std::ios::binary};
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error{std::format("Failed to open output file: {}", fileName)};
+    }
+
+    auto const recordSize = dimensions * ElementSize(dtype);
+    auto const * const bytes = static_cast<char const *>(records);
+
+    for (size_t idx = 0; idx < count; ++idx)
+    {
+        file.write(reinterpret_cast<char const *>(&dimensions), sizeof(dimensions));
+        file.write(bytes + idx * recordSize, static_cast<std::streamsize>(recordSize));
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error{std::format("Failed to write vectors: {}", fileName)};
+    }
+}
+
+/*
+ * Converts a .fvecs/.bvecs file to a .dset file next to it and returns the new name. All records must share
+ * the dimension of the first one. Records are streamed through one padded buffer and the count is patched into
+ * the header at the end, so the memory used does not depend on the size of the dump.
+ */
+auto inline ConvertVecs(std::string_view const fileName) -> std::string
+{
+    auto const dtype = fileName.ends_with(".bvecs") ? DataType::UINT8 : DataType::FLOAT32;
+
+    std::ifstream file{fileName.data(), std::ios::binary};
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error{std::format("Failed to open input file: {}", fileName)};
+    }
+
+    std::uint32_t dimensions{0};
+
+    if (!file.read(reinterpret_cast<char *>(&dimensions), sizeof(dimensions)) || dimensions == 0)
+    {
+        throw std::runtime_error{std::format("No records in {}", fileName)};
+    }
+
+    auto const output = std::filesystem::path{fileName}.replace_extension(".dset").string();
+    std::ofstream outputFile{output, std::ios::binary};
+
+    if (!outputFile.is_open())
+    {
+        throw std::runtime_error{std::format("Failed to open output file: {}", output)};
+    }
+
+    auto header = MakeHeader(0, dimensions, dtype);
+    auto const recordSize = dimensions * ElementSize(dtype);
+
+    outputFile.write(reinterpret_cast<char const *>(&header), sizeof(header));
+
+    std::vector<char> record(header.stride, 0);
+    std::uint32_t current{dimensions};
+
+    do
+    {
+        if (current != dimensions)
+        {
+            throw std::runtime_error{std::format("Inconsistent dimensions in {}: {} and {}", fileName, dimensions, current)};
+        }
+
+        if (!file.read(record.data(), static_cast<std::streamsize>(recordSize)))
+        {
+            throw std::runtime_error{std::format("Truncated record in {}", fileName)};
+        }
+
+        outputFile.write(record.data(), static_cast<std::streamsize>(header.stride));
+        ++header.count;
+    }
+    while (file.read(reinterpret_cast<char *>(&current), sizeof(current)));
+
+    outputFile.seekp(0);
+    outputFile.write(reinterpret_cast<char const *>(&header), sizeof(header));
+
+    if (!outputFile)
+    {
+        throw std::runtime_error{std::format("Failed to write dataset: {}", output)};
+    }
+
+    return output;
+}
+
+auto inline ResolveDataset(std::string_view const fileName) -> std::string
+{
+    if (fileName.ends_with(".fvecs") || fileName.ends_with(".bvecs"))
+    {
+        std::cout << std::format("Converting {}\n", fileName);
+        return ConvertVecs(fileName);
+    }
+
+    return std::string{fileName};
+}
+
+/*
+ * The same seeded sets as the other Distance programs, written once as .fvecs.
+ */
+auto inline GenerateSeeded() -> void
+{
+    std::vector<Descriptor> set(NUM_OF_POINTS);
+
+    WriteVecs(DEFAULT_SET1, set.data(), set.size(), Descriptor::DIMENSIONS, DataType::FLOAT32);
+
+    std::generate(set.begin(), set.end(), [] { return Descriptor{}; });
+
+    WriteVecs(DEFAULT_SET2, set.data(), set.size(), Descriptor::DIMENSIONS, DataType::FLOAT32);
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -0,0 +1,467 @@
+/*
+## Top-k Matching with Ratio Test and Cross-Check
+
+Feature matching needs more than the single best index: Lowe's ratio test compares the best and second best
+distances of each query, and the mutual cross-check keeps a match only if the query is also the best match of
+its reference. Both are fused into the one all-pairs sweep.
+
+Every query keeps a fixed-size sorted list of its NUM_OF_NEIGHBOURS best candidates. A candidate that beats
+the current worst entry (the only branch, rarely taken once the list has settled) is inserted with a
+branchless pass that shifts larger entries one slot down through conditional selects. The same distance also
+updates the running best query of its reference, so after the sweep the ratio test and the cross-check are
+both O(1) per query and the surviving matches are written to a compact list.
+
+The first neighbour of every query is identical to the single-best search, so the checksums are unchanged. On
+the uniform sets almost nothing survives the ratio test, as expected for unstructured data, so a noisy and
+shuffled copy of set1 is matched as well, where the true correspondence is known.
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    NUM_OF_NEIGHBOURS = 4,
+    SHUFFLE_STRIDE = 7'919UL,
+};
+
+static constexpr float RATIO_THRESHOLD{0.8F};
+static constexpr float NOISE_DEVIATION{0.05F};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+template <size_t K>
+class TopK
+{
+public:
+    static_assert(K >= 2, "The ratio test needs at least two neighbours");
+
+    void Reset() noexcept
+    {
+        std::fill(distances, distances + K, std::numeric_limits<float>::max());
+        std::fill(indices, indices + K, 0U);
+    }
+
+    /*
+     * Sorted insert without data-dependent branches. A slot takes its upper neighbour when the candidate sorts
+     * before that neighbour, the candidate when it sorts between the two, and keeps its value otherwise. Ties
+     * keep the earlier index in front.
+     */
+    void Insert(float const distance, std::uint32_t const index) noexcept
+    {
+        if (distance >= distances[K - 1])
+        {
+            return;
+        }
+
+#pragma GCC unroll 8
+        for (size_t slot = K - 1; slot > 0; --slot)
+        {
+            bool const shift = distance < distances[slot - 1];
+            bool const place = distance < distances[slot];
+
+            distances[slot] = shift ? distances[slot - 1] : (place ? distance : distances[slot]);
+            indices[slot] = shift ? indices[slot - 1] : (place ? index : indices[slot]);
+        }
+
+        bool const first = distance < distances[0];
+
+        distances[0] = first ? distance : distances[0];
+        indices[0] = first ? index : indices[0];
+    }
+
+    float Distance(size_t const rank) const noexcept
+    {
+        return distances[rank];
+    }
+
+    std::uint32_t Index(size_t const rank) const noexcept
+    {
+        return indices[rank];
+    }
+
+private:
+    float distances[K];
+    std::uint32_t indices[K];
+};
+
+
+struct Match
+{
+    std::uint32_t query;
+    std::uint32_t train;
+    float distance;
+};
+
+struct MatchList
+{
+    Match matches[NUM_OF_POINTS];
+    size_t count;
+
+    size_t passedRatio;
+    size_t passedCrossCheck;
+};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) Descriptor noisySet[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+alignas(ALIGN) TopK<NUM_OF_NEIGHBOURS> neighbours[NUM_OF_POINTS];
+
+alignas(ALIGN) float reverseDistances[NUM_OF_POINTS];
+alignas(ALIGN) std::uint32_t reverseIndices[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesTopL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesTopL2[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesNoisy[NUM_OF_POINTS];
+
+alignas(ALIGN) MatchList matchesL1;
+alignas(ALIGN) MatchList matchesL2;
+alignas(ALIGN) MatchList matchesNoisy;
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+
+auto inline CompareL1() noexcept -> void;
+auto inline CompareL2() noexcept -> void;
+
+template <typename Norm>
+auto inline MatchSets(Descriptor const * const lhs, Descriptor const * const rhs, Norm const & norm, size_t * const indices, MatchList & list) noexcept -> void;
+auto inline ReportMatches(MatchList const & list, std::string_view const message) noexcept -> void;
+
+auto inline GenerateNoisyCopy() noexcept -> void;
+auto inline CountCorrectMatches(MatchList const & list) noexcept -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    std::cout << "Starting Comparing L1 Norm\n";
+    TestSpeed(CompareL1, "CompareL1");
+
+    ComputeChecksum(indicesL1, "L1 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm\n";
+    TestSpeed(CompareL2, "CompareL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Matching L1 Norm\n";
+    TestSpeed([] { MatchSets(set1, set2, Descriptor::getL1Norm, indicesTopL1, matchesL1); }, "MatchSetsL1");
+
+    ComputeChecksum(indicesTopL1, "L1 Norm (Top-k)");
+    ReportMatches(matchesL1, "L1 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Matching L2 Norm\n";
+    TestSpeed([] { MatchSets(set1, set2, Descriptor::getL2Norm, indicesTopL2, matchesL2); }, "MatchSetsL2");
+
+    ComputeChecksum(indicesTopL2, "L2 Norm (Top-k)");
+    ReportMatches(matchesL2, "L2 Norm");
+
+    Cooldown();
+
+    GenerateNoisyCopy();
+
+    std::cout << "Starting Matching L2 Norm (Noisy Copy)\n";
+    TestSpeed([] { MatchSets(set1, noisySet, Descriptor::getL2Norm, indicesNoisy, matchesNoisy); }, "MatchSetsL2 (Noisy Copy)");
+
+    ReportMatches(matchesNoisy, "L2 Norm (Noisy Copy)");
+    CountCorrectMatches(matchesNoisy);
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+
+auto inline CompareL1() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL1Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL2() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL2Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+/*
+ * One sweep over all pairs fills the top-k list of every query and the best query of every reference. The
+ * filters then only read those summaries.
+ */
+template <typename Norm>
+auto inline MatchSets(Descriptor const * const lhs, Descriptor const * const rhs, Norm const & norm, size_t * const indices, MatchList & list) noexcept -> void
+{
+    float currentDistance{0.0};
+
+    std::fill(reverseDistances, reverseDistances + NUM_OF_POINTS, std::numeric_limits<float>::max());
+    std::fill(reverseIndices, reverseIndices + NUM_OF_POINTS, 0U);
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        auto & top = neighbours[idx1];
+        top.Reset();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = norm(lhs[idx1], rhs[idx2]);
+
+            top.Insert(currentDistance, static_cast<std::uint32_t>(idx2));
+
+            bool const closer = currentDistance < reverseDistances[idx2];
+
+            reverseDistances[idx2] = closer ? currentDistance : reverseDistances[idx2];
+            reverseIndices[idx2] = closer ? static_cast<std::uint32_t>(idx1) : reverseIndices[idx2];
+        }
+    }
+
+    list.count = 0;
+    list.passedRatio = 0;
+    list.passedCrossCheck = 0;
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        auto const & top = neighbours[idx1];
+        auto const best = top.Index(0);
+
+        indices[idx1] = best;
+
+        bool const ratio = top.Distance(0) < RATIO_THRESHOLD * top.Distance(1);
+        bool const mutual = reverseIndices[best] == idx1;
+
+        list.passedRatio += ratio;
+        list.passedCrossCheck += mutual;
+
+        list.matches[list.count] = Match{static_cast<std::uint32_t>(idx1), best, top.Distance(0)};
+        list.count += ratio && mutual;
+    }
+}
+
+auto inline ReportMatches(MatchList const & list, std::string_view const message) noexcept -> void
+{
+    auto const total = std::transform_reduce(list.matches, list.matches + list.count, 0.0, std::plus<>(),
+                                             [](Match const & match) { return static_cast<double>(match.distance); });
+    auto const mean = list.count == 0 ? 0.0 : total / static_cast<double>(list.count);
+
+    std::cout << std::format("Passed ratio test for {} : {} / {}\n", message, list.passedRatio, static_cast<size_t>(NUM_OF_POINTS));
+    std::cout << std::format("Passed cross-check for {} : {} / {}\n", message, list.passedCrossCheck, static_cast<size_t>(NUM_OF_POINTS));
+    std::cout << std::format("Matches for {} : {} (mean distance {:.4f})\n", message, list.count, mean);
+}
+
+/*
+ * Query idx lands at position (idx * SHUFFLE_STRIDE) % NUM_OF_POINTS, a permutation since the stride is prime.
+ */
+auto inline GenerateNoisyCopy() noexcept -> void
+{
+    std::mt19937 engine{SEED};
+    std::normal_distribution<float> noise{0.0F, NOISE_DEVIATION};
+
+    for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+    {
+        auto & copy = noisySet[(idx * SHUFFLE_STRIDE) % NUM_OF_POINTS];
+
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            copy[dim] = set1[idx][dim] + noise(engine);
+        }
+    }
+}
+
+auto inline CountCorrectMatches(MatchList const & list) noexcept -> void
+{
+    auto const correct = std::count_if(list.matches, list.matches + list.count,
+                                       [](Match const & match) { return match.train == (match.query * SHUFFLE_STRIDE) % NUM_OF_POINTS; });
+
+    std::cout << std::format("Correct matches : {} / {}\n", correct, list.count);
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -0,0 +1,748 @@
+/*
+## Metric Policies
+
+The search engines only need three things from a metric: how one vector of features adds to the running sums
+(accumulate), how the sums turn into one number that is smaller for closer descriptors (reduce), and how that
+number turns into the reported distance (finalize). Each metric is a policy struct that provides them, and the
+kernels of every instruction set are written once over the policy:
+
+- L1 and L2: the usual norms. The square root of L2 is monotone, so it is only taken for the best match.
+- Cosine: the descriptors are L2-normalized once when they are prepared, so the inner loop is a dot product and
+  1 - dot is computed for the best match only.
+- Inner product: maximum inner product search, accumulated negated so the closest match is still the minimum.
+- Chi-squared: (x - y)^2 / (x + y) per feature, for histogram descriptors. The 1/2 factor is applied last.
+- Hellinger: the descriptors are L1-normalized and square-rooted once (RootSIFT), so the inner loop is again a dot
+  product (the Bhattacharyya coefficient) and sqrt(1 - BC) is computed for the best match only.
+
+Every metric runs through the brute-force and the tiled engine with the widest kernels the host supports. The
+first NUM_OF_CHECKS queries are checked against a scalar double-precision search written from the same policy,
+and the tiled results against the brute-force ones.
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <utility>
+#include <cmath>
+#include <limits>
+#include <new>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    DIMENSIONS = 128,
+    NUM_OF_ACCUMULATORS = 4,
+    QUERY_TILE = 16,
+    REFERENCE_TILE = 512,
+    NUM_OF_CHECKS = 100,
+};
+
+enum class InstructionSet : std::uint8_t
+{
+    SSE,
+    AVX2,
+    AVX512,
+};
+
+
+/*
+ * Metric policies. Accumulate is declared here for every vector width and defined inside the target region of
+ * the matching instruction set below. Prepare runs once per descriptor, Term is the scalar contribution of one
+ * feature (for the reference search) and Finalize maps the reduced value of the best match to its distance.
+ */
+
+struct L1Metric
+{
+    static constexpr std::string_view NAME{"L1"};
+    static constexpr bool PREPARE{false};
+
+    static __m128 Accumulate(__m128 sum, __m128 lhs, __m128 rhs) noexcept;
+    static __m256 Accumulate(__m256 sum, __m256 lhs, __m256 rhs) noexcept;
+    static __m512 Accumulate(__m512 sum, __m512 lhs, __m512 rhs) noexcept;
+
+    template <size_t Dims>
+    static void Prepare(float *) noexcept {}
+
+    static double Term(double const lhs, double const rhs) noexcept
+    {
+        return std::abs(lhs - rhs);
+    }
+
+    static float Finalize(float const reduced) noexcept
+    {
+        return reduced;
+    }
+};
+
+struct L2Metric
+{
+    static constexpr std::string_view NAME{"L2"};
+    static constexpr bool PREPARE{false};
+
+    static __m128 Accumulate(__m128 sum, __m128 lhs, __m128 rhs) noexcept;
+    static __m256 Accumulate(__m256 sum, __m256 lhs, __m256 rhs) noexcept;
+    static __m512 Accumulate(__m512 sum, __m512 lhs, __m512 rhs) noexcept;
+
+    template <size_t Dims>
+    static void Prepare(float *) noexcept {}
+
+    static double Term(double const lhs, double const rhs) noexcept
+    {
+        return (lhs - rhs) * (lhs - rhs);
+    }
+
+    static float Finalize(float const reduced) noexcept
+    {
+        return std::sqrt(reduced);
+    }
+};
+
+/*
+ * Negated dot product, shared by the metrics that reduce to one after preparation.
+ */
+struct NegatedDot
+{
+    static __m128 Accumulate(__m128 sum, __m128 lhs, __m128 rhs) noexcept;
+    static __m256 Accumulate(__m256 sum, __m256 lhs, __m256 rhs) noexcept;
+    static __m512 Accumulate(__m512 sum, __m512 lhs, __m512 rhs) noexcept;
+
+    static double Term(double const lhs, double const rhs) noexcept
+    {
+        return -lhs * rhs;
+    }
+};
+
+struct CosineMetric : NegatedDot
+{
+    static constexpr std::string_view NAME{"Cosine"};
+    static constexpr bool PREPARE{true};
+
+    template <size_t Dims>
+    static void Prepare(float * const features) noexcept
+    {
+        auto const norm = std::sqrt(std::inner_product(features, features + Dims, features, 0.0F));
+
+        if (norm == 0.0F)
+        {
+            return; /* An empty descriptor stays zero instead of turning into NaN */
+        }
+
+        std::transform(features, features + Dims, features, [norm](float const value) { return value / norm; });
+    }
+
+    static float Finalize(float const reduced) noexcept
+    {
+        return 1.0F + reduced;
+    }
+};
+
+struct InnerProductMetric : NegatedDot
+{
+    static constexpr std::string_view NAME{"Inner Product"};
+    static constexpr bool PREPARE{false};
+
+    template <size_t Dims>
+    static void Prepare(float *) noexcept {}
+
+    static float Finalize(float const reduced) noexcept
+    {
+        return -reduced;
+    }
+};
+
+struct ChiSquaredMetric
+{
+    static constexpr std::string_view NAME{"Chi-Squared"};
+    static constexpr bool PREPARE{false};
+
+    static __m128 Accumulate(__m128 sum, __m128 lhs, __m128 rhs) noexcept;
+    static __m256 Accumulate(__m256 sum, __m256 lhs, __m256 rhs) noexcept;
+    static __m512 Accumulate(__m512 sum, __m512 lhs, __m512 rhs) noexcept;
+
+    template <size_t Dims>
+    static void Prepare(float *) noexcept {}
+
+    static double Term(double const lhs, double const rhs) noexcept
+    {
+        return lhs + rhs > 0.0 ? (lhs - rhs) * (lhs - rhs) / (lhs + rhs) : 0.0;
+    }
+
+    static float Finalize(float const reduced) noexcept
+    {
+        return 0.5F * reduced;
+    }
+};
+
+struct HellingerMetric : NegatedDot
+{
+    static constexpr std::string_view NAME{"Hellinger"};
+    static constexpr bool PREPARE{true};
+
+    template <size_t Dims>
+    static void Prepare(float * const features) noexcept
+    {
+        auto const sum = std::reduce(features, features + Dims, 0.0F);
+
+        if (sum == 0.0F)
+        {
+            return; /* An empty histogram stays zero instead of turning into NaN */
+        }
+
+        std::transform(features, features + Dims, features, [sum](float const value) { return std::sqrt(value / sum); });
+    }
+
+    static float Finalize(float const reduced) noexcept
+    {
+        return std::sqrt(std::max(0.0F, 1.0F + reduced));
+    }
+};
+
+
+/*
+ * Distance kernels, one set per instruction set, each in its own target region so it can be dispatched to at
+ * runtime. Distance unrolls Metric::Accumulate over NUM_OF_ACCUMULATORS independent sums and loads the remainder
+ * zero-padded, which adds nothing for any of the metrics. GCC only inlines a target-specific function into a
+ * caller of the same target, so every set also has a Run() that compiles the search for that target.
+ */
+
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+
+inline __m128 L1Metric::Accumulate(__m128 const sum, __m128 const lhs, __m128 const rhs) noexcept
+{
+    return _mm_add_ps(sum, _mm_andnot_ps(_mm_set1_ps(-0.0F), _mm_sub_ps(lhs, rhs)));
+}
+
+inline __m128 L2Metric::Accumulate(__m128 const sum, __m128 const lhs, __m128 const rhs) noexcept
+{
+    __m128 const diff = _mm_sub_ps(lhs, rhs);
+    return _mm_add_ps(sum, _mm_mul_ps(diff, diff));
+}
+
+inline __m128 NegatedDot::Accumulate(__m128 const sum, __m128 const lhs, __m128 const rhs) noexcept
+{
+    return _mm_sub_ps(sum, _mm_mul_ps(lhs, rhs));
+}
+
+inline __m128 ChiSquaredMetric::Accumulate(__m128 const sum, __m128 const lhs, __m128 const rhs) noexcept
+{
+    __m128 const diff = _mm_sub_ps(lhs, rhs);
+    __m128 const total = _mm_max_ps(_mm_add_ps(lhs, rhs), _mm_set1_ps(std::numeric_limits<float>::min())); /* Empty bins add 0 / min */
+    return _mm_add_ps(sum, _mm_div_ps(_mm_mul_ps(diff, diff), total));
+}
+
+struct SSEKernels
+{
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::SSE};
+    static constexpr size_t WIDTH{4};
+
+    template <size_t Dims, typename Metric>
+    static float Distance(float const * const lhs, float const * const rhs) noexcept
+    {
+        __m128 sum[NUM_OF_ACCUMULATORS] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+
+        [&]<size_t... IDX>(std::index_sequence<IDX...>) -> void
+        {
+            ((sum[IDX % NUM_OF_ACCUMULATORS] = Metric::Accumulate(sum[IDX % NUM_OF_ACCUMULATORS], _mm_load_ps(lhs + IDX * WIDTH), _mm_load_ps(rhs + IDX * WIDTH))), ...);
+        }(std::make_index_sequence<Dims / WIDTH>{});
+
+        if constexpr (Dims % WIDTH != 0)
+        {
+            alignas(16) float lhsTail[WIDTH]{};
+            alignas(16) float rhsTail[WIDTH]{};
+
+            std::copy_n(lhs + Dims / WIDTH * WIDTH, Dims % WIDTH, lhsTail);
+            std::copy_n(rhs + Dims / WIDTH * WIDTH, Dims % WIDTH, rhsTail);
+
+            sum[0] = Metric::Accumulate(sum[0], _mm_load_ps(lhsTail), _mm_load_ps(rhsTail));
+        }
+
+        return Reduce(sum);
+    }
+
+    template <typename Function>
+    __attribute__((flatten)) static void Run(Function const & function) noexcept
+    {
+        function.template operator()<SSEKernels>();
+    }
+
+private:
+    static float Reduce(__m128 const * const sum) noexcept
+    {
+        __m128 const sum128 = _mm_add_ps(_mm_add_ps(sum[0], sum[1]), _mm_add_ps(sum[2], sum[3])); /* Combine the accumulators */
+        __m128 const hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));        /* Swap the 64-bit halves */
+        __m128 const sum64 = _mm_add_ps(hi64, sum128);                                          /* Add the two 64-bit halves */
+        __m128 const hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));          /* Swap the 32-bit halves */
+        return _mm_cvtss_f32(_mm_add_ps(sum64, hi32));                                          /* Add the two 32-bit halves */
+    }
+};
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+
+inline __m256 L1Metric::Accumulate(__m256 const sum, __m256 const lhs, __m256 const rhs) noexcept
+{
+    return _mm256_add_ps(sum, _mm256_andnot_ps(_mm256_set1_ps(-0.0F), _mm256_sub_ps(lhs, rhs)));
+}
+
+inline __m256 L2Metric::Accumulate(__m256 const sum, __m256 const lhs, __m256 const rhs) noexcept
+{
+    __m256 const diff = _mm256_sub_ps(lhs, rhs);
+    return _mm256_fmadd_ps(diff, diff, sum);
+}
+
+inline __m256 NegatedDot::Accumulate(__m256 const sum, __m256 const lhs, __m256 const rhs) noexcept
+{
+    return _mm256_fnmadd_ps(lhs, rhs, sum);
+}
+
+inline __m256 ChiSquaredMetric::Accumulate(__m256 const sum, __m256 const lhs, __m256 const rhs) noexcept
+{
+    __m256 const diff = _mm256_sub_ps(lhs, rhs);
+    __m256 const total = _mm256_max_ps(_mm256_add_ps(lhs, rhs), _mm256_set1_ps(std::numeric_limits<float>::min())); /* Empty bins add 0 / min */
+    return _mm256_add_ps(sum, _mm256_div_ps(_mm256_mul_ps(diff, diff), total));
+}
+
+struct AVX2Kernels
+{
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::AVX2};
+    static constexpr size_t WIDTH{8};
+
+    template <size_t Dims, typename Metric>
+    static float Distance(float const * const lhs, float const * const rhs) noexcept
+    {
+        __m256 sum[NUM_OF_ACCUMULATORS] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+
+        [&]<size_t... IDX>(std::index_sequence<IDX...>) -> void
+        {
+            ((sum[IDX % NUM_OF_ACCUMULATORS] = Metric::Accumulate(sum[IDX % NUM_OF_ACCUMULATORS], _mm256_load_ps(lhs + IDX * WIDTH), _mm256_load_ps(rhs + IDX * WIDTH))), ...);
+        }(std::make_index_sequence<Dims / WIDTH>{});
+
+        if constexpr (Dims % WIDTH != 0)
+        {
+            __m256i const mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(Dims % WIDTH), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            sum[0] = Metric::Accumulate(sum[0], _mm256_maskload_ps(lhs + Dims / WIDTH * WIDTH, mask), _mm256_maskload_ps(rhs + Dims / WIDTH * WIDTH, mask));
+        }
+
+        return Reduce(sum);
+    }
+
+    template <typename Function>
+    __attribute__((flatten)) static void Run(Function const & function) noexcept
+    {
+        function.template operator()<AVX2Kernels>();
+    }
+
+private:
+    static float Reduce(__m256 const * const sum) noexcept
+    {
+        __m256 const sum256 = _mm256_add_ps(_mm256_add_ps(sum[0], sum[1]), _mm256_add_ps(sum[2], sum[3]));     /* Combine the accumulators */
+        __m128 const sum128 = _mm_add_ps(_mm256_castps256_ps128(sum256), _mm256_extractf128_ps(sum256, 1)); /* Add the lower and upper halves */
+        __m128 const hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves */
+        __m128 const sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves */
+        __m128 const hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves */
+        return _mm_cvtss_f32(_mm_add_ps(sum64, hi32));                                                      /* Add the two 32-bit halves */
+    }
+};
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+inline __m512 L1Metric::Accumulate(__m512 const sum, __m512 const lhs, __m512 const rhs) noexcept
+{
+    return _mm512_add_ps(sum, _mm512_abs_ps(_mm512_sub_ps(lhs, rhs)));
+}
+
+inline __m512 L2Metric::Accumulate(__m512 const sum, __m512 const lhs, __m512 const rhs) noexcept
+{
+    __m512 const diff = _mm512_sub_ps(lhs, rhs);
+    return _mm512_fmadd_ps(diff, diff, sum);
+}
+
+inline __m512 NegatedDot::Accumulate(__m512 const sum, __m512 const lhs, __m512 const rhs) noexcept
+{
+    return _mm512_fnmadd_ps(lhs, rhs, sum);
+}
+
+inline __m512 ChiSquaredMetric::Accumulate(__m512 const sum, __m512 const lhs, __m512 const rhs) noexcept
+{
+    __m512 const diff = _mm512_sub_ps(lhs, rhs);
+    __m512 const total = _mm512_max_ps(_mm512_add_ps(lhs, rhs), _mm512_set1_ps(std::numeric_limits<float>::min())); /* Empty bins add 0 / min */
+    return _mm512_add_ps(sum, _mm512_div_ps(_mm512_mul_ps(diff, diff), total));
+}
+
+struct AVX512Kernels
+{
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::AVX512};
+    static constexpr size_t WIDTH{16};
+
+    template <size_t Dims, typename Metric>
+    static float Distance(float const * const lhs, float const * const rhs) noexcept
+    {
+        __m512 sum[NUM_OF_ACCUMULATORS] = {_mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps()};
+
+        [&]<size_t... IDX>(std::index_sequence<IDX...>) -> void
+        {
+            ((sum[IDX % NUM_OF_ACCUMULATORS] = Metric::Accumulate(sum[IDX % NUM_OF_ACCUMULATORS], _mm512_load_ps(lhs + IDX * WIDTH), _mm512_load_ps(rhs + IDX * WIDTH))), ...);
+        }(std::make_index_sequence<Dims / WIDTH>{});
+
+        if constexpr (Dims % WIDTH != 0)
+        {
+            __mmask16 constexpr mask = (1U << (Dims % WIDTH)) - 1U;
+            sum[0] = Metric::Accumulate(sum[0], _mm512_maskz_loadu_ps(mask, lhs + Dims / WIDTH * WIDTH), _mm512_maskz_loadu_ps(mask, rhs + Dims / WIDTH * WIDTH));
+        }
+
+        return Reduce(sum);
+    }
+
+    template <typename Function>
+    __attribute__((flatten)) static void Run(Function const & function) noexcept
+    {
+        function.template operator()<AVX512Kernels>();
+    }
+
+private:
+    static float Reduce(__m512 const * const sum) noexcept
+    {
+        __m512 sum512 = _mm512_add_ps(_mm512_add_ps(sum[0], sum[1]), _mm512_add_ps(sum[2], sum[3]));     /* Combine the accumulators */
+        sum512 = _mm512_add_ps(sum512, _mm512_shuffle_f32x4(sum512, sum512, _MM_SHUFFLE(1U, 0U, 3U, 2U))); /* Add the 256-bit halves */
+        sum512 = _mm512_add_ps(sum512, _mm512_shuffle_f32x4(sum512, sum512, _MM_SHUFFLE(2U, 3U, 0U, 1U))); /* Add the 128-bit quarters */
+        __m128 const sum128 = _mm512_castps512_ps128(sum512);                                             /* Keep the lowest 128 bits */
+        __m128 const hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                  /* Swap the 64-bit halves */
+        __m128 const sum64 = _mm_add_ps(hi64, sum128);                                                    /* Add the two 64-bit halves */
+        __m128 const hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                    /* Swap the 32-bit halves */
+        return _mm_cvtss_f32(_mm_add_ps(sum64, hi32));                                                    /* Add the two 32-bit halves */
+    }
+};
+
+#pragma GCC pop_options
+
+
+class DescriptorGenerator
+{
+protected:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+};
+
+std::mt19937 DescriptorGenerator::randomEngine{SEED};
+std::uniform_real_distribution<float> DescriptorGenerator::randomDistribution{0.0, 1.0};
+std::function<float()> DescriptorGenerator::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+template <size_t Dims>
+class Descriptor : private DescriptorGenerator
+{
+public:
+    static constexpr size_t DIMENSIONS = Dims;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    template <typename Metric>
+    void Prepare() noexcept
+    {
+        Metric::template Prepare<Dims>(features);
+    }
+
+    /*
+     * The reduced value of the metric: smaller is closer, but it is not yet the distance (see Metric::Finalize).
+     */
+    template <typename Kernels, typename Metric>
+    static float getReduced(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        return Kernels::template Distance<Dims, Metric>(lhs.features, rhs.features);
+    }
+
+    template <typename Metric>
+    static double getReference(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        return std::transform_reduce(lhs.features, lhs.features + Dims, rhs.features, 0.0, std::plus<>(),
+                                     [](float const left, float const right) { return Metric::Term(left, right); });
+    }
+
+private:
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+
+alignas(ALIGN) Descriptor<DIMENSIONS> set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor<DIMENSIONS> set2[NUM_OF_POINTS];
+
+alignas(ALIGN) Descriptor<DIMENSIONS> prepared1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor<DIMENSIONS> prepared2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indices[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesTiled[NUM_OF_POINTS];
+alignas(ALIGN) float distances[NUM_OF_POINTS];
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, size_t const count) noexcept -> size_t;
+
+auto inline GetInstructionSet() noexcept -> InstructionSet;
+auto inline GetInstructionSetName(InstructionSet const instructionSet) noexcept -> std::string_view;
+
+template <typename Function>
+auto inline Dispatch(Function const & function) noexcept -> void;
+
+template <typename Kernels, typename Metric>
+auto inline CompareBruteForce(Descriptor<DIMENSIONS> const * const lhs, Descriptor<DIMENSIONS> const * const rhs) noexcept -> void;
+template <typename Kernels, typename Metric>
+auto inline CompareTiled(Descriptor<DIMENSIONS> const * const lhs, Descriptor<DIMENSIONS> const * const rhs) noexcept -> void;
+template <typename Metric>
+auto inline CountReferenceMismatches(Descriptor<DIMENSIONS> const * const lhs, Descriptor<DIMENSIONS> const * const rhs) noexcept -> size_t;
+
+template <typename Metric>
+auto inline TestMetric() noexcept -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    std::cout << std::format("Instruction Set : {}\n", GetInstructionSetName(GetInstructionSet()));
+
+    TestMetric<L1Metric>();
+    TestMetric<L2Metric>();
+    TestMetric<CosineMetric>();
+    TestMetric<InnerProductMetric>();
+    TestMetric<ChiSquaredMetric>();
+    TestMetric<HellingerMetric>();
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, size_t const count) noexcept -> size_t
+{
+    return std::inner_product(lhs, lhs + count, rhs, 0UL, std::plus<>(), std::not_equal_to<>());
+}
+
+auto inline GetInstructionSet() noexcept -> InstructionSet
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return InstructionSet::AVX512;
+    }
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return InstructionSet::AVX2;
+    }
+
+    return InstructionSet::SSE;
+}
+
+auto inline GetInstructionSetName(InstructionSet const instructionSet) noexcept -> std::string_view
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::AVX512 :
+            return "AVX-512";
+        case InstructionSet::AVX2 :
+            return "AVX2";
+        case InstructionSet::SSE :
+            return "SSE";
+        default :
+            return "Unknown";
+    }
+}
+
+/*
+ * Runs the search once with the widest kernels the host supports. Dispatching around the whole loop through
+ * Kernels::Run() (instead of per distance) compiles the loop for the same target, so the kernels inline into it.
+ */
+template <typename Function>
+auto inline Dispatch(Function const & function) noexcept -> void
+{
+    static InstructionSet const instructionSet = GetInstructionSet();
+
+    switch (instructionSet)
+    {
+        case InstructionSet::AVX512 :
+            AVX512Kernels::Run(function);
+            break;
+        case InstructionSet::AVX2 :
+            AVX2Kernels::Run(function);
+            break;
+        case InstructionSet::SSE :
+            SSEKernels::Run(function);
+            break;
+        default :
+            break;
+    }
+}
+
+/*
+ * Only the reduced value is compared in the inner loop; the distance of the best match is finalized once.
+ */
+template <typename Kernels, typename Metric>
+auto inline CompareBruteForce(Descriptor<DIMENSIONS> const * const lhs, Descriptor<DIMENSIONS> const * const rhs) noexcept -> void
+{
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        float minReduced = std::numeric_limits<float>::max();
+        size_t minIndex = 0;
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            float const currentReduced = Descriptor<DIMENSIONS>::getReduced<Kernels, Metric>(lhs[idx1], rhs[idx2]);
+
+            if (currentReduced < minReduced)
+            {
+                minReduced = currentReduced;
+                minIndex = idx2;
+            }
+        }
+
+        indices[idx1] = minIndex;
+        distances[idx1] = Metric::Finalize(minReduced);
+    }
+}
+
+/*
+ * The same search over QUERY_TILE x REFERENCE_TILE tiles, so the reference tile is reused from L1/L2 by all the
+ * queries of the tile. Reference tiles are visited in order and compared strictly, which keeps the results equal
+ * to the brute-force ones.
+ */
+template <typename Kernels, typename Metric>
+auto inline CompareTiled(Descriptor<DIMENSIONS> const * const lhs, Descriptor<DIMENSIONS> const * const rhs) noexcept -> void
+{
+    for (size_t queryTile = 0; queryTile < NUM_OF_POINTS; queryTile += QUERY_TILE)
+    {
+        auto const queryEnd = std::min<size_t>(queryTile + QUERY_TILE, NUM_OF_POINTS);
+
+        float minReduced[QUERY_TILE];
+        std::fill(minReduced, minReduced + QUERY_TILE, std::numeric_limits<float>::max());
+
+        for (size_t referenceTile = 0; referenceTile < NUM_OF_POINTS; referenceTile += REFERENCE_TILE)
+        {
+            auto const referenceEnd = std::min<size_t>(referenceTile + REFERENCE_TILE, NUM_OF_POINTS);
+
+            for (size_t idx1 = queryTile; idx1 < queryEnd; ++idx1)
+            {
+                for (size_t idx2 = referenceTile; idx2 < referenceEnd; ++idx2)
+                {
+                    float const currentReduced = Descriptor<DIMENSIONS>::getReduced<Kernels, Metric>(lhs[idx1], rhs[idx2]);
+
+                    if (currentReduced < minReduced[idx1 - queryTile])
+                    {
+                        minReduced[idx1 - queryTile] = currentReduced;
+                        indicesTiled[idx1] = idx2;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Scalar double-precision search of the first NUM_OF_CHECKS queries, built from Metric::Term alone.
+ */
+template <typename Metric>
+auto inline CountReferenceMismatches(Descriptor<DIMENSIONS> const * const lhs, Descriptor<DIMENSIONS> const * const rhs) noexcept -> size_t
+{
+    size_t mismatches{0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_CHECKS; ++idx1)
+    {
+        double minReduced = std::numeric_limits<double>::max();
+        size_t minIndex = 0;
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            double const currentReduced = Descriptor<DIMENSIONS>::getReference<Metric>(lhs[idx1], rhs[idx2]);
+
+            if (currentReduced < minReduced)
+            {
+                minReduced = currentReduced;
+                minIndex = idx2;
+            }
+        }
+
+        mismatches += minIndex != indices[idx1] ? 1 : 0;
+    }
+
+    return mismatches;
+}
+
+/*
+ * Prepares copies of both sets if the metric needs it and runs both engines with it.
+ */
+template <typename Metric>
+auto inline TestMetric() noexcept -> void
+{
+    auto const * lhs = set1;
+    auto const * rhs = set2;
+
+    if constexpr (Metric::PREPARE)
+    {
+        std::copy(set1, set1 + NUM_OF_POINTS, prepared1);
+        std::copy(set2, set2 + NUM_OF_POINTS, prepared2);
+
+        std::for_each(prepared1, prepared1 + NUM_OF_POINTS, [](auto & descriptor) { descriptor.template Prepare<Metric>(); });
+        std::for_each(prepared2, prepared2 + NUM_OF_POINTS, [](auto & descriptor) { descriptor.template Prepare<Metric>(); });
+
+        lhs = prepared1;
+        rhs = prepared2;
+    }
+
+    std::cout << std::format("Starting Comparing {}\n", Metric::NAME);
+    TestSpeed([&] { Dispatch([&]<typename Kernels> { CompareBruteForce<Kernels, Metric>(lhs, rhs); }); }, std::format("Compare {}", Metric::NAME));
+
+    ComputeChecksum(indices, Metric::NAME);
+    std::cout << std::format("Mean distance for {} : {:.4f}\n", Metric::NAME, std::reduce(distances, distances + NUM_OF_POINTS, 0.0) / static_cast<double>(NUM_OF_POINTS));
+    std::cout << std::format("Mismatches against the scalar reference : {} / {}\n", CountReferenceMismatches<Metric>(lhs, rhs), static_cast<size_t>(NUM_OF_CHECKS));
+
+    Cooldown();
+
+    std::cout << std::format("Starting Comparing {} (Tiled)\n", Metric::NAME);
+    TestSpeed([&] { Dispatch([&]<typename Kernels> { CompareTiled<Kernels, Metric>(lhs, rhs); }); }, std::format("Compare {} (Tiled)", Metric::NAME));
+
+    std::cout << std::format("Mismatches against brute force : {}\n", CountMismatches(indicesTiled, indices, NUM_OF_POINTS));
+
+    Cooldown();
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
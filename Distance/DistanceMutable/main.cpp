@@ -0,0 +1,980 @@
+/*
+## Mutable Reference Set
+
+The references live in a MutableStore instead of a static array. The store is an IVF index: a coarse quantizer
+of NUM_OF_LISTS centroids is trained once on set2, and every inverted list is its own list of segments of
+SEGMENT_CAPACITY descriptors. A search ranks the centroids and scans the nprobe closest lists, and probing all of
+them is the exact search. Per list:
+
+- Inserts append to the last segment of the list of their nearest centroid and publish the new size with a
+  release store. A full segment is sealed and a new list with a fresh segment is published.
+- Deletes set a tombstone bit, which searches skip.
+- A background thread compacts the sealed segments that are at least 1/COMPACTION_RATIO dead. It packs their live
+  descriptors into new segments and publishes a list without the old ones.
+
+A segment list is never modified in place. Readers load the current lists and search them, while writers and the
+compactor only publish new lists. Old lists and segments are reclaimed by epochs: a reader announces the global
+epoch while it searches, and memory retired in an epoch is freed only once every active reader announced a later
+one. Readers never take a lock or wait; inserts, deletes and compaction serialize among themselves on one mutex.
+
+The store is first filled with set2 and searched exactly with set1 to check the checksums, followed by the recall
+and time of the IVF search for a range of nprobe values. After churn it is checked against a brute-force search of
+the live descriptors, exactly and with MIXED_NPROBE lists. The update throughput is measured with the compactor
+running. Finally, the latency of IVF queries is compared between a read-only and a mixed workload with a paced
+writer. The centroids are not retrained while the store changes, so recall drifts if the inserted data does not
+follow the training distribution.
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <cstring>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    SEGMENT_CAPACITY = 1'024,
+    COMPACTION_RATIO = 4,
+    MAX_READERS = 8,
+    NUM_OF_READERS = 2,
+    NUM_OF_UPDATES = 200'000,
+    UPDATES_PER_MILLISECOND = 10,
+    NUM_OF_CHECKS = 200,
+    NUM_OF_LISTS = 16,
+    KMEANS_ITERATIONS = 12,
+    MIXED_NPROBE = 4,
+};
+
+static constexpr size_t NPROBE[]{1, 2, 4, 8};
+
+static constexpr std::chrono::milliseconds COMPACTION_INTERVAL{2};
+static constexpr std::chrono::seconds MIXED_DURATION{3};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+enum class Norm : std::uint8_t
+{
+    L1,
+    L2,
+};
+
+
+/*
+ * Epoch-based reclamation. Readers announce the epoch they entered in their own slot and clear it on leaving.
+ * Retired memory is tagged with the epoch it was retired in and freed once no active reader entered at or before
+ * that epoch.
+ */
+class EpochManager
+{
+public:
+    class Guard
+    {
+    public:
+        explicit Guard(std::atomic<std::uint64_t> & slot) noexcept : slot{slot}
+        {
+        }
+
+        Guard(Guard const &) = delete;
+        Guard & operator=(Guard const &) = delete;
+
+        ~Guard()
+        {
+            slot.store(IDLE, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<std::uint64_t> & slot;
+    };
+
+    ~EpochManager()
+    {
+        for (auto & retired : retiredList)
+        {
+            retired.free();
+        }
+    }
+
+    [[nodiscard]] Guard Enter(size_t const reader) noexcept
+    {
+        auto & slot = slots[reader].epoch;
+        slot.store(globalEpoch.load());
+
+        return Guard{slot};
+    }
+
+    void Retire(std::function<void()> free)
+    {
+        std::lock_guard const lock{mutex};
+        retiredList.push_back(Retired{globalEpoch.fetch_add(1), std::move(free)});
+    }
+
+    /*
+     * Frees what no reader can still see and returns how many items it freed.
+     */
+    size_t Reclaim()
+    {
+        auto oldest = IDLE;
+
+        for (auto const & slot : slots)
+        {
+            oldest = std::min(oldest, slot.epoch.load());
+        }
+
+        std::lock_guard const lock{mutex};
+
+        auto const reclaimable = std::stable_partition(retiredList.begin(), retiredList.end(), [oldest](auto const & retired) { return retired.epoch >= oldest; });
+        auto const count = static_cast<size_t>(retiredList.end() - reclaimable);
+
+        std::for_each(reclaimable, retiredList.end(), [](auto & retired) { retired.free(); });
+        retiredList.erase(reclaimable, retiredList.end());
+
+        return count;
+    }
+
+private:
+    static constexpr std::uint64_t IDLE{std::numeric_limits<std::uint64_t>::max()};
+
+    struct alignas(ALIGN) Slot
+    {
+        std::atomic<std::uint64_t> epoch{IDLE};
+    };
+
+    struct Retired
+    {
+        std::uint64_t epoch;
+        std::function<void()> free;
+    };
+
+    std::atomic<std::uint64_t> globalEpoch{1};
+    Slot slots[MAX_READERS];
+
+    std::mutex mutex;
+    std::vector<Retired> retiredList;
+};
+
+
+/*
+ * Fixed-capacity block of descriptors. The slots below size are immutable except for their tombstone bit. The
+ * descriptors are kept as raw bytes, since constructing a Descriptor draws from the generator.
+ */
+struct Segment
+{
+    static constexpr size_t WORDS = SEGMENT_CAPACITY / 64;
+
+    Descriptor const & At(size_t const slot) const noexcept
+    {
+        return reinterpret_cast<Descriptor const *>(storage)[slot];
+    }
+
+    alignas(ALIGN) std::byte storage[SEGMENT_CAPACITY * sizeof(Descriptor)];
+    std::uint32_t ids[SEGMENT_CAPACITY];
+    std::atomic<std::uint64_t> tombstones[WORDS]{};
+    std::atomic<std::uint32_t> size{0};
+    std::uint32_t deleted{0};
+};
+
+struct SegmentList
+{
+    std::vector<Segment *> segments;
+};
+
+struct StoreStatistics
+{
+    size_t segments;
+    size_t live;
+    size_t compacted;
+    size_t reclaimed;
+};
+
+
+/*
+ * IVF coarse quantizer: NUM_OF_LISTS centroids trained once by Lloyd iterations on the initial descriptors. The
+ * centroids stay fixed afterwards, so an insert only has to append to the list of its nearest centroid. Like the
+ * segments, the centroids are kept as raw bytes and viewed as Descriptor.
+ */
+class CoarseQuantizer
+{
+public:
+    CoarseQuantizer(Descriptor const * const points, size_t const count)
+    {
+        std::mt19937 engine{SEED};
+
+        std::vector<std::uint32_t> order(count);
+        std::iota(order.begin(), order.end(), 0U);
+        std::shuffle(order.begin(), order.end(), engine);
+
+        for (size_t list = 0; list < NUM_OF_LISTS; ++list)
+        {
+            std::memcpy(storage + list * sizeof(Descriptor), &points[order[list % count]], sizeof(Descriptor));
+        }
+
+        std::vector<double> sums(NUM_OF_LISTS * Descriptor::DIMENSIONS);
+        std::vector<size_t> sizes(NUM_OF_LISTS);
+        std::uniform_int_distribution<size_t> pick{0, count - 1};
+
+        for (size_t iteration = 0; iteration < KMEANS_ITERATIONS; ++iteration)
+        {
+            std::fill(sums.begin(), sums.end(), 0.0);
+            std::fill(sizes.begin(), sizes.end(), 0UL);
+
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                auto const list = Nearest(points[idx]);
+                ++sizes[list];
+
+                for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+                {
+                    sums[list * Descriptor::DIMENSIONS + dim] += static_cast<double>(points[idx][dim]);
+                }
+            }
+
+            for (size_t list = 0; list < NUM_OF_LISTS; ++list)
+            {
+                auto * const centroid = reinterpret_cast<float *>(storage + list * sizeof(Descriptor));
+
+                if (sizes[list] == 0)
+                {
+                    /* An emptied centroid is moved to a random point */
+                    std::memcpy(centroid, &points[pick(engine)], sizeof(Descriptor));
+                    continue;
+                }
+
+                for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+                {
+                    centroid[dim] = static_cast<float>(sums[list * Descriptor::DIMENSIONS + dim] / static_cast<double>(sizes[list]));
+                }
+            }
+        }
+    }
+
+    CoarseQuantizer(CoarseQuantizer const &) = delete;
+    CoarseQuantizer & operator=(CoarseQuantizer const &) = delete;
+
+    size_t Nearest(Descriptor const & point) const noexcept
+    {
+        float minDistance = std::numeric_limits<float>::max();
+        size_t minList{0};
+
+        for (size_t list = 0; list < NUM_OF_LISTS; ++list)
+        {
+            float const currentDistance = Descriptor::getL2Norm(point, Centroid(list));
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                minList = list;
+            }
+        }
+
+        return minList;
+    }
+
+    /*
+     * Writes the nprobe lists closest to the query to probes, closest first.
+     */
+    void Rank(Descriptor const & query, size_t const nprobe, std::uint32_t * const probes) const noexcept
+    {
+        std::pair<float, std::uint32_t> ranked[NUM_OF_LISTS];
+
+        for (size_t list = 0; list < NUM_OF_LISTS; ++list)
+        {
+            ranked[list] = {Descriptor::getL2Norm(query, Centroid(list)), static_cast<std::uint32_t>(list)};
+        }
+
+        std::partial_sort(ranked, ranked + nprobe, ranked + NUM_OF_LISTS);
+        std::transform(ranked, ranked + nprobe, probes, [](auto const & entry) { return entry.second; });
+    }
+
+private:
+    Descriptor const & Centroid(size_t const list) const noexcept
+    {
+        return reinterpret_cast<Descriptor const *>(storage)[list];
+    }
+
+    alignas(ALIGN) std::byte storage[NUM_OF_LISTS * sizeof(Descriptor)];
+};
+
+
+/*
+ * An IVF index on segments: every inverted list is its own segment list, published and compacted independently.
+ * Deletes only set the tombstone, so they never touch the quantizer or the other lists.
+ */
+class MutableStore
+{
+public:
+    explicit MutableStore(Descriptor const * const sample, size_t const count) : quantizer{sample, count}
+    {
+        for (auto & list : lists)
+        {
+            list.store(new SegmentList{{new Segment{}}});
+        }
+
+        /* Started last, once every list exists */
+        compactor = std::jthread{[this](std::stop_token const & stop) { RunCompactor(stop); }};
+    }
+
+    MutableStore(MutableStore const &) = delete;
+    MutableStore & operator=(MutableStore const &) = delete;
+
+    ~MutableStore()
+    {
+        compactor.request_stop();
+        compactor.join();
+
+        for (auto & current : lists)
+        {
+            auto * const list = current.load();
+
+            for (auto * const segment : list->segments)
+            {
+                delete segment;
+            }
+
+            delete list;
+        }
+    }
+
+    void Insert(Descriptor const & descriptor, std::uint32_t const id)
+    {
+        auto const index = quantizer.Nearest(descriptor);
+
+        std::lock_guard const lock{mutex};
+
+        auto * list = lists[index].load();
+        auto * segment = list->segments.back();
+        auto slot = segment->size.load(std::memory_order_relaxed);
+
+        if (slot == SEGMENT_CAPACITY)
+        {
+            /* Seal the full segment behind a new list that ends with an empty one */
+            segment = new Segment{};
+            slot = 0;
+
+            auto * const grown = new SegmentList{*list};
+            grown->segments.push_back(segment);
+
+            Publish(index, grown, list, {});
+            list = grown;
+        }
+
+        std::memcpy(segment->storage + slot * sizeof(Descriptor), &descriptor, sizeof(Descriptor));
+        segment->ids[slot] = id;
+        segment->size.store(slot + 1, std::memory_order_release);
+
+        locations[id] = Location{segment, slot};
+        ++live;
+    }
+
+    bool Delete(std::uint32_t const id)
+    {
+        std::lock_guard const lock{mutex};
+
+        auto const location = locations.find(id);
+
+        if (location == locations.end())
+        {
+            return false;
+        }
+
+        auto const [segment, slot] = location->second;
+
+        segment->tombstones[slot / 64].fetch_or(1UL << (slot % 64), std::memory_order_relaxed);
+        ++segment->deleted;
+
+        locations.erase(location);
+        --live;
+
+        return true;
+    }
+
+    /*
+     * Id of the nearest live descriptor in the nprobe lists closest to the query, ties resolved to the lowest id.
+     * With all NUM_OF_LISTS lists probed the search is exact. Wait-free for the reader.
+     */
+    template <Norm Metric>
+    std::uint32_t Nearest(Descriptor const & query, size_t const reader, size_t const nprobe = NUM_OF_LISTS) const noexcept
+    {
+        std::uint32_t probes[NUM_OF_LISTS];
+
+        if (nprobe < NUM_OF_LISTS)
+        {
+            quantizer.Rank(query, nprobe, probes);
+        }
+        else
+        {
+            std::iota(probes, probes + NUM_OF_LISTS, 0U);
+        }
+
+        auto const guard = epochs.Enter(reader);
+
+        float minDistance = std::numeric_limits<float>::max();
+        std::uint32_t minId = std::numeric_limits<std::uint32_t>::max();
+
+        for (size_t probe = 0; probe < std::min<size_t>(nprobe, NUM_OF_LISTS); ++probe)
+        {
+            for (auto const * const segment : lists[probes[probe]].load()->segments)
+            {
+                Scan<Metric>(query, *segment, minDistance, minId);
+            }
+        }
+
+        return minId;
+    }
+
+    /*
+     * Packs the live descriptors of the sealed segments that are at least 1/COMPACTION_RATIO dead into new
+     * segments, placed before the active one of their list. Returns how many segments were replaced.
+     */
+    size_t Compact()
+    {
+        std::lock_guard const lock{mutex};
+
+        size_t count{0};
+
+        for (size_t index = 0; index < NUM_OF_LISTS; ++index)
+        {
+            count += CompactList(index);
+        }
+
+        compacted += count;
+
+        return count;
+    }
+
+    StoreStatistics Statistics()
+    {
+        std::lock_guard const lock{mutex};
+
+        size_t segments{0};
+
+        for (auto const & current : lists)
+        {
+            segments += current.load()->segments.size();
+        }
+
+        return StoreStatistics{segments, live, compacted, reclaimed.load()};
+    }
+
+private:
+    struct Location
+    {
+        Segment * segment;
+        std::uint32_t slot;
+    };
+
+    template <Norm Metric>
+    static void Scan(Descriptor const & query, Segment const & segment, float & minDistance, std::uint32_t & minId) noexcept
+    {
+        auto const size = segment.size.load(std::memory_order_acquire);
+
+        for (size_t word = 0; word * 64 < size; ++word)
+        {
+            auto const dead = segment.tombstones[word].load(std::memory_order_relaxed);
+            auto const end = std::min<size_t>((word + 1) * 64, size);
+
+            for (size_t slot = word * 64; slot < end; ++slot)
+            {
+                if ((dead >> (slot % 64) & 1U) != 0)
+                {
+                    continue;
+                }
+
+                float const currentDistance = Metric == Norm::L2 ? Descriptor::getL2Norm(query, segment.At(slot)) : Descriptor::getL1Norm(query, segment.At(slot));
+                auto const id = segment.ids[slot];
+
+                if (currentDistance < minDistance || (currentDistance == minDistance && id < minId))
+                {
+                    minDistance = currentDistance;
+                    minId = id;
+                }
+            }
+        }
+    }
+
+    size_t CompactList(size_t const index)
+    {
+        auto * const list = lists[index].load();
+        auto const sealed = list->segments.end() - 1;
+
+        std::vector<Segment *> kept;
+        std::vector<Segment *> victims;
+
+        for (auto segment = list->segments.begin(); segment != sealed; ++segment)
+        {
+            ((*segment)->deleted * COMPACTION_RATIO >= SEGMENT_CAPACITY ? victims : kept).push_back(*segment);
+        }
+
+        if (victims.empty())
+        {
+            return 0;
+        }
+
+        Segment * packed = nullptr;
+
+        for (auto const * const victim : victims)
+        {
+            for (size_t slot = 0; slot < SEGMENT_CAPACITY; ++slot)
+            {
+                if ((victim->tombstones[slot / 64].load(std::memory_order_relaxed) >> (slot % 64) & 1U) != 0)
+                {
+                    continue;
+                }
+
+                if (packed == nullptr || packed->size.load(std::memory_order_relaxed) == SEGMENT_CAPACITY)
+                {
+                    packed = new Segment{};
+                    kept.push_back(packed);
+                }
+
+                auto const target = packed->size.load(std::memory_order_relaxed);
+
+                std::memcpy(packed->storage + target * sizeof(Descriptor), &victim->At(slot), sizeof(Descriptor));
+                packed->ids[target] = victim->ids[slot];
+                packed->size.store(target + 1, std::memory_order_relaxed);
+
+                locations[victim->ids[slot]] = Location{packed, target};
+            }
+        }
+
+        auto const count = victims.size();
+
+        kept.push_back(list->segments.back());
+
+        Publish(index, new SegmentList{std::move(kept)}, list, std::move(victims));
+
+        return count;
+    }
+
+    /*
+     * Swaps in the new version of a list and retires the old one together with the segments that are no longer
+     * in it.
+     */
+    void Publish(size_t const index, SegmentList * const list, SegmentList * const old, std::vector<Segment *> dropped)
+    {
+        lists[index].store(list);
+
+        epochs.Retire([old, dropped = std::move(dropped)]
+        {
+            for (auto * const segment : dropped)
+            {
+                delete segment;
+            }
+
+            delete old;
+        });
+    }
+
+    void RunCompactor(std::stop_token const & stop)
+    {
+        while (!stop.stop_requested())
+        {
+            Compact();
+            reclaimed += epochs.Reclaim();
+
+            std::this_thread::sleep_for(COMPACTION_INTERVAL);
+        }
+    }
+
+    CoarseQuantizer const quantizer;
+
+    mutable EpochManager epochs;
+    std::atomic<SegmentList *> lists[NUM_OF_LISTS] = {};
+
+    std::mutex mutex;
+    std::unordered_map<std::uint32_t, Location> locations;
+    size_t live{0};
+    size_t compacted{0};
+    std::atomic<size_t> reclaimed{0};
+
+    std::jthread compactor;
+};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesIVF[NUM_OF_POINTS];
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> double;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+
+auto inline GetSource(std::uint32_t const id) noexcept -> Descriptor const &;
+auto inline Churn(MutableStore & store, std::vector<std::uint32_t> & liveIds, std::uint32_t & nextId, std::mt19937 & engine) -> void;
+auto inline CountMismatches(MutableStore & store, std::vector<std::uint32_t> const & liveIds, size_t const nprobe = NUM_OF_LISTS) -> size_t;
+auto inline RunMixed(MutableStore & store, std::vector<std::uint32_t> & liveIds, std::uint32_t & nextId, bool const withWriter) -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    std::unique_ptr<MutableStore> owner;
+
+    std::cout << "Starting Training Coarse Quantizer\n";
+    TestSpeed([&] { owner = std::make_unique<MutableStore>(set2, NUM_OF_POINTS); }, "Train");
+
+    auto & store = *owner;
+
+    std::vector<std::uint32_t> liveIds(NUM_OF_POINTS);
+    std::iota(liveIds.begin(), liveIds.end(), 0U);
+
+    std::uint32_t nextId{NUM_OF_POINTS};
+    std::mt19937 engine{SEED};
+
+    std::cout << "Starting Inserting Reference Set\n";
+    TestSpeed([&] { std::for_each(liveIds.begin(), liveIds.end(), [&store](auto const id) { store.Insert(set2[id], id); }); }, "Insert");
+
+    std::cout << "Starting Comparing L1 Norm\n";
+    TestSpeed([&] { std::transform(set1, set1 + NUM_OF_POINTS, indicesL1, [&store](auto const & query) { return store.Nearest<Norm::L1>(query, 0); }); }, "CompareL1");
+
+    ComputeChecksum(indicesL1, "L1 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm\n";
+    TestSpeed([&] { std::transform(set1, set1 + NUM_OF_POINTS, indicesL2, [&store](auto const & query) { return store.Nearest<Norm::L2>(query, 0); }); }, "CompareL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    for (auto const nprobe : NPROBE)
+    {
+        Cooldown();
+
+        std::cout << std::format("Starting Searching IVF L2 Norm (nprobe {})\n", nprobe);
+        TestSpeed([&] { std::transform(set1, set1 + NUM_OF_POINTS, indicesIVF, [&store, nprobe](auto const & query) { return store.Nearest<Norm::L2>(query, 0, nprobe); }); }, std::format("SearchIVF (nprobe {})", nprobe));
+
+        auto const hits = std::inner_product(indicesIVF, indicesIVF + NUM_OF_POINTS, indicesL2, 0UL, std::plus<>(), std::equal_to<>());
+        std::cout << std::format("Recall@1 for nprobe {} : {:.2f}%\n", nprobe, 100.0 * static_cast<double>(hits) / static_cast<double>(NUM_OF_POINTS));
+    }
+
+    Cooldown();
+
+    std::cout << std::format("Starting Updating ({} inserts and deletes)\n", static_cast<size_t>(NUM_OF_UPDATES));
+    auto const seconds = TestSpeed([&] { Churn(store, liveIds, nextId, engine); }, "Update");
+
+    auto const statistics = store.Statistics();
+
+    std::cout << std::format("Update throughput : {:.0f} updates/s\n", static_cast<double>(NUM_OF_UPDATES) / seconds);
+    std::cout << std::format("Segments : {}, live : {}, compacted : {}, reclaimed : {}\n", statistics.segments, statistics.live, statistics.compacted, statistics.reclaimed);
+    std::cout << std::format("Mismatches against brute force : {} / {}\n", CountMismatches(store, liveIds), static_cast<size_t>(NUM_OF_CHECKS));
+    std::cout << std::format("Misses with nprobe {} : {} / {}\n", static_cast<size_t>(MIXED_NPROBE), CountMismatches(store, liveIds, MIXED_NPROBE), static_cast<size_t>(NUM_OF_CHECKS));
+
+    Cooldown();
+
+    RunMixed(store, liveIds, nextId, false);
+
+    Cooldown();
+
+    RunMixed(store, liveIds, nextId, true);
+
+    std::cout << std::format("Mismatches against brute force : {} / {}\n", CountMismatches(store, liveIds), static_cast<size_t>(NUM_OF_CHECKS));
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> double
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+/*
+ * The original ids are the descriptors of set2, and later ids reuse set1 in order.
+ */
+auto inline GetSource(std::uint32_t const id) noexcept -> Descriptor const &
+{
+    return id < NUM_OF_POINTS ? set2[id] : set1[(id - NUM_OF_POINTS) % NUM_OF_POINTS];
+}
+
+/*
+ * NUM_OF_UPDATES updates, alternating an insert of a new id and a delete of a random live one, so the live size
+ * stays the same while the store keeps growing and being compacted.
+ */
+auto inline Churn(MutableStore & store, std::vector<std::uint32_t> & liveIds, std::uint32_t & nextId, std::mt19937 & engine) -> void
+{
+    for (size_t update = 0; update < NUM_OF_UPDATES; update += 2)
+    {
+        store.Insert(GetSource(nextId), nextId);
+        liveIds.push_back(nextId++);
+
+        auto const victim = std::uniform_int_distribution<size_t>{0, liveIds.size() - 1}(engine);
+
+        store.Delete(liveIds[victim]);
+        liveIds[victim] = liveIds.back();
+        liveIds.pop_back();
+    }
+}
+
+/*
+ * Nearest live id of the first NUM_OF_CHECKS queries with nprobe lists, against a brute-force search of the live
+ * descriptors.
+ */
+auto inline CountMismatches(MutableStore & store, std::vector<std::uint32_t> const & liveIds, size_t const nprobe) -> size_t
+{
+    size_t mismatches{0};
+
+    for (size_t query = 0; query < NUM_OF_CHECKS; ++query)
+    {
+        float minDistance = std::numeric_limits<float>::max();
+        std::uint32_t minId = std::numeric_limits<std::uint32_t>::max();
+
+        for (auto const id : liveIds)
+        {
+            float const currentDistance = Descriptor::getL2Norm(set1[query], GetSource(id));
+
+            if (currentDistance < minDistance || (currentDistance == minDistance && id < minId))
+            {
+                minDistance = currentDistance;
+                minId = id;
+            }
+        }
+
+        mismatches += store.Nearest<Norm::L2>(set1[query], 0, nprobe) != minId ? 1 : 0;
+    }
+
+    return mismatches;
+}
+
+/*
+ * NUM_OF_READERS threads query the store with MIXED_NPROBE lists for MIXED_DURATION, optionally with a writer doing
+ * UPDATES_PER_MILLISECOND updates every millisecond, and the query latencies are reported.
+ */
+auto inline RunMixed(MutableStore & store, std::vector<std::uint32_t> & liveIds, std::uint32_t & nextId, bool const withWriter) -> void
+{
+    std::vector<std::vector<double>> latencies(NUM_OF_READERS);
+    std::atomic<bool> running{true};
+    std::atomic<std::uint32_t> answers{0};
+    size_t updates{0};
+
+    std::cout << std::format("Starting {} Workload ({} readers, nprobe {})\n", withWriter ? "Mixed" : "Read-Only", static_cast<size_t>(NUM_OF_READERS), static_cast<size_t>(MIXED_NPROBE));
+
+    auto const start = std::chrono::steady_clock::now();
+
+    {
+        std::vector<std::jthread> threads;
+
+        for (size_t reader = 0; reader < NUM_OF_READERS; ++reader)
+        {
+            threads.emplace_back([&store, &latencies, &running, &answers, reader]
+            {
+                for (size_t query = reader; running.load(std::memory_order_relaxed); query = (query + NUM_OF_READERS) % NUM_OF_POINTS)
+                {
+                    auto const begin = std::chrono::steady_clock::now();
+                    answers.fetch_xor(store.Nearest<Norm::L2>(set1[query], reader + 1, MIXED_NPROBE), std::memory_order_relaxed);
+                    latencies[reader].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+                }
+            });
+        }
+
+        if (withWriter)
+        {
+            std::mt19937 engine{SEED};
+            auto next = start;
+
+            while (std::chrono::steady_clock::now() - start < MIXED_DURATION)
+            {
+                for (size_t update = 0; update < UPDATES_PER_MILLISECOND; update += 2)
+                {
+                    store.Insert(GetSource(nextId), nextId);
+                    liveIds.push_back(nextId++);
+
+                    auto const victim = std::uniform_int_distribution<size_t>{0, liveIds.size() - 1}(engine);
+
+                    store.Delete(liveIds[victim]);
+                    liveIds[victim] = liveIds.back();
+                    liveIds.pop_back();
+                }
+
+                updates += UPDATES_PER_MILLISECOND;
+                next += std::chrono::milliseconds{1};
+                std::this_thread::sleep_until(next);
+            }
+        }
+        else
+        {
+            std::this_thread::sleep_for(MIXED_DURATION);
+        }
+
+        running = false;
+    }
+
+    auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+
+    for (auto const & reader : latencies)
+    {
+        all.insert(all.end(), reader.begin(), reader.end());
+    }
+
+    auto const percentile = [&all](double const fraction) -> double
+    {
+        if (all.empty())
+        {
+            return std::numeric_limits<double>::quiet_NaN(); /* No query was answered, so there is no latency to rank */
+        }
+
+        auto const rank = all.begin() + static_cast<std::ptrdiff_t>(fraction * static_cast<double>(all.size() - 1));
+        std::nth_element(all.begin(), rank, all.end());
+        return *rank;
+    };
+
+    std::cout << std::format("Queries : {:.0f} queries/s, p50 {:.0f} us, p99 {:.0f} us\n", static_cast<double>(all.size()) / elapsed, percentile(0.50), percentile(0.99));
+
+    if (withWriter)
+    {
+        auto const statistics = store.Statistics();
+
+        std::cout << std::format("Updates : {:.0f} updates/s\n", static_cast<double>(updates) / elapsed);
+        std::cout << std::format("Segments : {}, live : {}, compacted : {}, reclaimed : {}\n", statistics.segments, statistics.live, statistics.compacted, statistics.reclaimed);
+    }
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
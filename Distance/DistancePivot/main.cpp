@@ -0,0 +1,536 @@
+/*
+## Pivot Pruning
+
+L1 and L2 are metrics, so for any pivot p the triangle inequality gives |d(q, p) - d(r, p)| <= d(q, r). A few
+pivots are picked from set2 by farthest-first traversal and the distance of every reference to every pivot is
+stored once, pivot-major, so 8 consecutive references are one aligned load per pivot. The lower bound of a
+reference is the largest of these differences over all pivots.
+
+A query first computes its distances to the pivots, which are references too and so give the initial best
+match for free. The references are then scanned in blocks of 8: the bounds of the block are computed with
+vector subtract/abs/max and compared against the current best with one movemask, and only the lanes whose
+bound does not exceed it get the exact kernel.
+
+The bound is lowered by a small relative tolerance (PIVOT_TOLERANCE times the two pivot distances) that covers
+the rounding of the float distances, so a reference is only skipped when it truly cannot beat or tie the best.
+Ties keep the lower index as in the brute-force loop, hence the checksums are bit-identical. The pruning rate is
+reported for the seeded uniform sets and for a clustered Gaussian mixture.
+
+Usage: DistancePivot [dataset]. Given the name of a DistanceDataset dataset, only its .dset files are searched and
+the L2 pivot search is scored against its cached .gt and appended to ../recall.csv.
+*/
+
+#include "Dataset.hpp"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <bit>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    NUM_OF_PIVOTS = 16,
+    NUM_OF_BLOCKS = NUM_OF_POINTS / FLOAT_VECTOR_SIZE,
+    NUM_OF_CLUSTERS = 64,
+};
+
+/*
+ * Relative error allowed on each pivot distance, far above the rounding error of a 128-term float sum.
+ */
+static constexpr float PIVOT_TOLERANCE{1e-4F};
+
+static_assert(NUM_OF_POINTS % FLOAT_VECTOR_SIZE == 0, "The references are scanned in full blocks of 8");
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+enum class Norm : std::uint8_t
+{
+    L1,
+    L2,
+};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesPivotL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesPivotL2[NUM_OF_POINTS];
+
+alignas(ALIGN) std::uint32_t pivots[NUM_OF_PIVOTS];
+alignas(ALIGN) bool isPivot[NUM_OF_POINTS];
+alignas(ALIGN) float pivotDistances[NUM_OF_PIVOTS][NUM_OF_POINTS];
+
+static size_t evaluatedPairs{0};
+
+static GroundTruth groundTruth{};
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, std::string_view const message) noexcept -> void;
+auto inline ReportPruning(std::string_view const message) noexcept -> void;
+
+auto inline CompareL1() noexcept -> void;
+auto inline CompareL2() noexcept -> void;
+
+template <Norm Metric>
+auto inline Distance(Descriptor const & lhs, Descriptor const & rhs) noexcept -> float;
+template <Norm Metric>
+auto inline SelectPivots() noexcept -> void;
+template <Norm Metric>
+auto inline ComparePivot(size_t * const indices) noexcept -> void;
+
+auto inline GenerateClustered() noexcept -> void;
+auto inline RunBenchmarks(std::string_view const dataset) -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main(int const argc, char const * const argv[])
+{
+    try
+    {
+        if (argc > 2)
+        {
+            std::cerr << "Usage: DistancePivot [dataset]\n";
+            return EXIT_FAILURE;
+        }
+
+        if (argc == 2)
+        {
+            groundTruth = LoadDataset(argv[1], set1, set2, NUM_OF_POINTS);
+            RunBenchmarks(argv[1]);
+
+            return 0;
+        }
+
+        RunBenchmarks("Uniform");
+
+        Cooldown();
+
+        GenerateClustered();
+        RunBenchmarks("Clustered");
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline RunBenchmarks(std::string_view const dataset) -> void
+{
+    std::cout << std::format("Starting Comparing L1 Norm ({})\n", dataset);
+    TestSpeed(CompareL1, "CompareL1");
+
+    ComputeChecksum(indicesL1, "L1 Norm");
+
+    Cooldown();
+
+    std::cout << std::format("Starting Comparing L1 Norm ({}, Pivots)\n", dataset);
+    TestSpeed(SelectPivots<Norm::L1>, "SelectPivotsL1");
+    TestSpeed([] { ComparePivot<Norm::L1>(indicesPivotL1); }, "CompareL1Pivot");
+
+    ComputeChecksum(indicesPivotL1, "L1 Norm (Pivots)");
+    CountMismatches(indicesL1, indicesPivotL1, "L1 Norm (Pivots)");
+    ReportPruning("L1 Norm (Pivots)");
+
+    Cooldown();
+
+    std::cout << std::format("Starting Comparing L2 Norm ({})\n", dataset);
+    TestSpeed(CompareL2, "CompareL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    Cooldown();
+
+    std::cout << std::format("Starting Comparing L2 Norm ({}, Pivots)\n", dataset);
+    TestSpeed(SelectPivots<Norm::L2>, "SelectPivotsL2");
+    auto const pivot_ms = TestSpeed([] { ComparePivot<Norm::L2>(indicesPivotL2); }, "CompareL2Pivot");
+
+    ComputeChecksum(indicesPivotL2, "L2 Norm (Pivots)");
+    CountMismatches(indicesL2, indicesPivotL2, "L2 Norm (Pivots)");
+    ReportPruning("L2 Norm (Pivots)");
+
+    auto const queriesPerSecond = static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(pivot_ms, 1L)) / 1e3);
+    AppendRecall(groundTruth, "Pivot", std::format("pivots={}", static_cast<size_t>(NUM_OF_PIVOTS)), 1, GroundTruthRecall(groundTruth, indicesPivotL2, NUM_OF_POINTS), queriesPerSecond, 1, sizeof(pivotDistances) + sizeof(set2));
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+
+    return time_ms;
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, std::string_view const message) noexcept -> void
+{
+    auto const mismatches = std::transform_reduce(lhs, lhs + NUM_OF_POINTS, rhs, 0UL, std::plus<>(), std::not_equal_to<>());
+    std::cout << std::format("Mismatches for {} : {} / {}\n", message, mismatches, static_cast<size_t>(NUM_OF_POINTS));
+}
+
+auto inline ReportPruning(std::string_view const message) noexcept -> void
+{
+    auto constexpr total = static_cast<size_t>(NUM_OF_POINTS) * static_cast<size_t>(NUM_OF_POINTS);
+    auto const pruned = 100.0 * static_cast<double>(total - evaluatedPairs) / static_cast<double>(total);
+    std::cout << std::format("Pairs pruned for {} : {:.2f} %\n", message, pruned);
+}
+
+
+auto inline CompareL1() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL1Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL2() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL2Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+template <Norm Metric>
+auto inline Distance(Descriptor const & lhs, Descriptor const & rhs) noexcept -> float
+{
+    return Metric == Norm::L2 ? Descriptor::getL2Norm(lhs, rhs) : Descriptor::getL1Norm(lhs, rhs);
+}
+
+/*
+ * Farthest-first traversal: every new pivot is the reference farthest from all pivots chosen so far, which
+ * spreads them over the set and makes their bounds complementary.
+ */
+template <Norm Metric>
+auto inline SelectPivots() noexcept -> void
+{
+    std::mt19937 randomEngine{SEED};
+    std::uniform_int_distribution<std::uint32_t> pick{0, NUM_OF_POINTS - 1};
+
+    alignas(ALIGN) static float closestPivot[NUM_OF_POINTS];
+    std::fill(closestPivot, closestPivot + NUM_OF_POINTS, std::numeric_limits<float>::max());
+
+    std::fill(isPivot, isPivot + NUM_OF_POINTS, false);
+
+    auto next = pick(randomEngine);
+
+    for (size_t pivot = 0; pivot < NUM_OF_PIVOTS; ++pivot)
+    {
+        pivots[pivot] = next;
+        isPivot[next] = true;
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            pivotDistances[pivot][idx2] = Distance<Metric>(set2[next], set2[idx2]);
+            closestPivot[idx2] = std::min(closestPivot[idx2], pivotDistances[pivot][idx2]);
+        }
+
+        next = static_cast<std::uint32_t>(std::max_element(closestPivot, closestPivot + NUM_OF_POINTS) - closestPivot);
+    }
+}
+
+template <Norm Metric>
+auto inline ComparePivot(size_t * const indices) noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+    size_t minIndex{0};
+    size_t evaluated{0};
+
+    __m256 queryPivot[NUM_OF_PIVOTS];
+    __m256 queryTolerance[NUM_OF_PIVOTS];
+
+    auto const signMask = _mm256_set1_ps(-0.0F);
+    auto const tolerance = _mm256_set1_ps(PIVOT_TOLERANCE);
+
+    alignas(ALIGN) float bounds[FLOAT_VECTOR_SIZE];
+
+    auto const update = [&](float const distance, size_t const idx2) noexcept -> void
+    {
+        if (distance < minDistance || (distance == minDistance && idx2 < minIndex))
+        {
+            minDistance = distance;
+            minIndex = idx2;
+        }
+    };
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+        minIndex = 0;
+
+        for (size_t pivot = 0; pivot < NUM_OF_PIVOTS; ++pivot)
+        {
+            currentDistance = Distance<Metric>(set1[idx1], set2[pivots[pivot]]);
+            update(currentDistance, pivots[pivot]);
+
+            queryPivot[pivot] = _mm256_set1_ps(currentDistance);
+            queryTolerance[pivot] = _mm256_set1_ps(PIVOT_TOLERANCE * currentDistance);
+        }
+
+        evaluated += NUM_OF_PIVOTS;
+
+        for (size_t block = 0; block < NUM_OF_BLOCKS; ++block)
+        {
+            auto bound = _mm256_setzero_ps();
+
+#pragma GCC unroll 16
+            for (size_t pivot = 0; pivot < NUM_OF_PIVOTS; ++pivot)
+            {
+                auto const reference = _mm256_load_ps(pivotDistances[pivot] + block * FLOAT_VECTOR_SIZE);          /* Distances of 8 references to the pivot */
+                auto const difference = _mm256_andnot_ps(signMask, _mm256_sub_ps(queryPivot[pivot], reference));    /* |d(q, p) - d(r, p)| */
+                auto const slack = _mm256_fmadd_ps(tolerance, reference, queryTolerance[pivot]);                    /* Rounding allowance */
+                bound = _mm256_max_ps(bound, _mm256_sub_ps(difference, slack));                                     /* Keep the tightest bound */
+            }
+
+            auto survivors = static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(bound, _mm256_set1_ps(minDistance), _CMP_LE_OQ)));
+
+            if (survivors == 0)
+            {
+                continue;
+            }
+
+            _mm256_store_ps(bounds, bound);
+
+            while (survivors != 0)
+            {
+                auto const lane = static_cast<size_t>(std::countr_zero(survivors));
+                survivors &= survivors - 1;
+
+                auto const idx2 = block * FLOAT_VECTOR_SIZE + lane;
+
+                /* The best may have improved earlier in this block, and the pivots were already evaluated */
+                if (bounds[lane] > minDistance || isPivot[idx2])
+                {
+                    continue;
+                }
+
+                currentDistance = Distance<Metric>(set1[idx1], set2[idx2]);
+                update(currentDistance, idx2);
+
+                ++evaluated;
+            }
+        }
+
+        indices[idx1] = minIndex;
+    }
+
+    evaluatedPairs = evaluated;
+}
+
+auto inline GenerateClustered() noexcept -> void
+{
+    std::mt19937 randomEngine{SEED};
+    std::uniform_real_distribution<float> uniformDistribution{0.0, 1.0};
+    std::uniform_int_distribution<size_t> clusterDistribution{0, NUM_OF_CLUSTERS - 1};
+    std::normal_distribution<float> normalDistribution{0.0, 1.0};
+
+    alignas(ALIGN) float amplitude[Descriptor::DIMENSIONS];
+    alignas(ALIGN) float spread[Descriptor::DIMENSIONS];
+    alignas(ALIGN) float centers[NUM_OF_CLUSTERS][Descriptor::DIMENSIONS];
+
+    /* Heterogeneous dimensions: a few carry most of the variance, like real gradient histograms */
+    for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+    {
+        float const weight = uniformDistribution(randomEngine);
+        amplitude[dim] = weight * weight * weight;
+        spread[dim] = 0.01F + 0.05F * weight;
+    }
+
+    for (auto & center: centers)
+    {
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            center[dim] = 0.5F + amplitude[dim] * (uniformDistribution(randomEngine) - 0.5F);
+        }
+    }
+
+    for (auto * const set: {set1, set2})
+    {
+        for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+        {
+            auto const & center = centers[clusterDistribution(randomEngine)];
+
+            for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+            {
+                set[idx][dim] = std::clamp(center[dim] + spread[dim] * normalDistribution(randomEngine), 0.0F, 1.0F);
+            }
+        }
+    }
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -0,0 +1,795 @@
+/*
+## Two-Stage Search with Reduced Descriptors
+
+A projection to REDUCED dimensions is learned once from set2 and applied to both sets. Two projections are
+compared, each with orthonormal rows:
+
+    - Random: Gaussian rows made orthonormal with Gram-Schmidt.
+    - PCA: the REDUCED leading eigenvectors of the covariance of set2, found with cyclic Jacobi rotations, and
+      applied to the descriptors minus the mean of set2.
+
+The reduced vectors are stored contiguously and scanned with an FMA kernel that is fully unrolled for the
+reduced size. That scan is 128 / REDUCED times cheaper than the full one.
+
+Shortlist mode keeps the SHORTLIST closest references in the reduced space and re-ranks them exactly with
+getL1Norm/getL2Norm. The same L2 shortlist is used for both norms. Recall@1 against the brute-force search and
+the checksum are reported for a range of shortlist sizes.
+
+Exact mode is L2 only and uses the projection as a lower bound. A matrix with orthonormal rows never lengthens a
+vector, so the reduced distance of a pair is at most its full distance. The SEED_CANDIDATES best references in
+the reduced space are evaluated exactly first. The scan then skips every reference whose lower bound is above the
+best exact distance so far. A relative slack of BOUND_SLACK absorbs rounding, so the result always equals the
+brute-force one. The share of references that still needed the full kernel is reported.
+
+The bound only prunes when the data has structure: on the i.i.d. uniform sets a projection keeps just its share
+of the variance. Usage: DistanceProjection [dataset]. Given the name of a DistanceDataset dataset such as
+clustered, the sets are read from its .dset files and the L2 points are scored against its cached .gt and
+appended to ../recall.csv.
+*/
+
+#include "Dataset.hpp"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <vector>
+#include <array>
+#include <memory>
+#include <utility>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    JACOBI_SWEEPS = 32,
+    SEED_CANDIDATES = 8,
+};
+
+static constexpr std::array<size_t, 6> SHORTLIST{1, 4, 16, 64, 256, 1024};
+
+static constexpr float BOUND_SLACK{1e-3F};
+static constexpr double JACOBI_TOLERANCE{1e-12};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+enum class Norm : std::uint8_t
+{
+    L1,
+    L2,
+};
+
+enum class Method : std::uint8_t
+{
+    RANDOM,
+    PCA,
+};
+
+struct Candidate
+{
+    float distance;
+    std::uint32_t index;
+
+    bool operator<(Candidate const & other) const noexcept
+    {
+        return distance < other.distance;
+    }
+};
+
+template <size_t Reduced>
+struct alignas(ALIGN) ReducedDescriptor
+{
+    static_assert(Reduced % FLOAT_VECTOR_SIZE == 0, "The reduced size must fill whole vectors");
+
+    alignas(ALIGN) float features[Reduced];
+};
+
+/*
+ * Orthonormal rows and the offset subtracted before projecting (zero for the random projection).
+ */
+template <size_t Reduced>
+struct Projection
+{
+    alignas(ALIGN) float matrix[Reduced][Descriptor::DIMENSIONS];
+    alignas(ALIGN) float mean[Descriptor::DIMENSIONS];
+    double explained;
+};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesTwoStage[NUM_OF_POINTS];
+
+static GroundTruth groundTruth{};
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+
+auto inline CompareL1() noexcept -> void;
+auto inline CompareL2() noexcept -> void;
+
+auto inline Covariance(std::vector<double> & covariance, float * const mean) noexcept -> void;
+auto inline Jacobi(std::vector<double> & matrix, std::vector<double> & vectors) noexcept -> void;
+
+template <size_t Reduced>
+auto inline LearnRandom(Projection<Reduced> & projection) noexcept -> void;
+template <size_t Reduced>
+auto inline LearnPCA(Projection<Reduced> & projection) noexcept -> void;
+template <size_t Reduced>
+auto inline Project(Projection<Reduced> const & projection, Descriptor const * const descriptors, std::vector<ReducedDescriptor<Reduced>> & reduced) noexcept -> void;
+template <size_t Reduced>
+auto inline ReducedDistance(ReducedDescriptor<Reduced> const & lhs, ReducedDescriptor<Reduced> const & rhs) noexcept -> float;
+
+auto inline PushCandidate(std::vector<Candidate> & heap, size_t const size, float const distance, std::uint32_t const index) noexcept -> void;
+
+template <size_t Reduced, Norm Metric>
+auto inline SearchShortlist(std::vector<ReducedDescriptor<Reduced>> const & queries, std::vector<ReducedDescriptor<Reduced>> const & references, size_t const shortlist) noexcept -> void;
+template <size_t Reduced>
+auto inline SearchExact(std::vector<ReducedDescriptor<Reduced>> const & queries, std::vector<ReducedDescriptor<Reduced>> const & references) noexcept -> size_t;
+
+template <size_t Reduced>
+auto inline RunProjection(Method const method) -> void;
+template <Norm Metric>
+auto inline Evaluate(std::function<void()> const & search, std::string_view const message) noexcept -> double;
+
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main(int const argc, char const * const argv[])
+{
+    try
+    {
+        if (argc > 2)
+        {
+            std::cerr << "Usage: DistanceProjection [dataset]\n";
+            return EXIT_FAILURE;
+        }
+
+        if (argc == 2)
+        {
+            groundTruth = LoadDataset(argv[1], set1, set2, NUM_OF_POINTS);
+        }
+
+        std::cout << "Starting Comparing L1 Norm\n";
+        TestSpeed(CompareL1, "CompareL1");
+
+        ComputeChecksum(indicesL1, "L1 Norm");
+
+        Cooldown();
+
+        std::cout << "Starting Comparing L2 Norm\n";
+        TestSpeed(CompareL2, "CompareL2");
+
+        ComputeChecksum(indicesL2, "L2 Norm");
+
+        Cooldown();
+
+        RunProjection<16>(Method::RANDOM);
+        RunProjection<16>(Method::PCA);
+        RunProjection<32>(Method::RANDOM);
+        RunProjection<32>(Method::PCA);
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+
+auto inline CompareL1() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL1Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL2() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL2Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL2[idx1] = idx2;
+            }
+        }
+    }
+}
+/*
+ * Mean and covariance of set2, accumulated in double.
+ */
+auto inline Covariance(std::vector<double> & covariance, float * const mean) noexcept -> void
+{
+    constexpr auto dims = Descriptor::DIMENSIONS;
+
+    std::vector<double> sums(dims, 0.0);
+
+    for (auto const & descriptor : set2)
+    {
+        for (size_t dim = 0; dim < dims; ++dim)
+        {
+            sums[dim] += static_cast<double>(descriptor[dim]);
+        }
+    }
+
+    std::transform(sums.begin(), sums.end(), sums.begin(), [](auto const sum) { return sum / static_cast<double>(NUM_OF_POINTS); });
+    std::transform(sums.begin(), sums.end(), mean, [](auto const sum) { return static_cast<float>(sum); });
+
+    covariance.assign(dims * dims, 0.0);
+    std::vector<double> centered(dims);
+
+    for (auto const & descriptor : set2)
+    {
+        for (size_t dim = 0; dim < dims; ++dim)
+        {
+            centered[dim] = static_cast<double>(descriptor[dim]) - sums[dim];
+        }
+
+        for (size_t row = 0; row < dims; ++row)
+        {
+            for (size_t column = row; column < dims; ++column)
+            {
+                covariance[row * dims + column] += centered[row] * centered[column];
+            }
+        }
+    }
+
+    for (size_t row = 0; row < dims; ++row)
+    {
+        for (size_t column = row; column < dims; ++column)
+        {
+            covariance[row * dims + column] /= static_cast<double>(NUM_OF_POINTS - 1);
+            covariance[column * dims + row] = covariance[row * dims + column];
+        }
+    }
+}
+
+/*
+ * Cyclic Jacobi eigenvalue algorithm for a symmetric matrix. On return the diagonal holds the eigenvalues and
+ * the columns of vectors the matching eigenvectors.
+ */
+auto inline Jacobi(std::vector<double> & matrix, std::vector<double> & vectors) noexcept -> void
+{
+    constexpr auto dims = Descriptor::DIMENSIONS;
+
+    vectors.assign(dims * dims, 0.0);
+
+    for (size_t dim = 0; dim < dims; ++dim)
+    {
+        vectors[dim * dims + dim] = 1.0;
+    }
+
+    for (size_t sweep = 0; sweep < JACOBI_SWEEPS; ++sweep)
+    {
+        double offDiagonal{0.0};
+
+        for (size_t row = 0; row < dims; ++row)
+        {
+            for (size_t column = row + 1; column < dims; ++column)
+            {
+                offDiagonal += matrix[row * dims + column] * matrix[row * dims + column];
+            }
+        }
+
+        if (offDiagonal < JACOBI_TOLERANCE)
+        {
+            break;
+        }
+
+        for (size_t p = 0; p < dims; ++p)
+        {
+            for (size_t q = p + 1; q < dims; ++q)
+            {
+                auto const apq = matrix[p * dims + q];
+
+                if (std::abs(apq) < std::numeric_limits<double>::min())
+                {
+                    continue;
+                }
+
+                /* Rotation that zeroes matrix[p][q] */
+                auto const theta = (matrix[q * dims + q] - matrix[p * dims + p]) / (2.0 * apq);
+                auto const t = std::copysign(1.0, theta) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                auto const c = 1.0 / std::sqrt(t * t + 1.0);
+                auto const s = t * c;
+
+                for (size_t k = 0; k < dims; ++k)
+                {
+                    auto const akp = matrix[k * dims + p];
+                    auto const akq = matrix[k * dims + q];
+
+                    matrix[k * dims + p] = c * akp - s * akq;
+                    matrix[k * dims + q] = s * akp + c * akq;
+                }
+
+                for (size_t k = 0; k < dims; ++k)
+                {
+                    auto const apk = matrix[p * dims + k];
+                    auto const aqk = matrix[q * dims + k];
+
+                    matrix[p * dims + k] = c * apk - s * aqk;
+                    matrix[q * dims + k] = s * apk + c * aqk;
+                }
+
+                for (size_t k = 0; k < dims; ++k)
+                {
+                    auto const vkp = vectors[k * dims + p];
+                    auto const vkq = vectors[k * dims + q];
+
+                    vectors[k * dims + p] = c * vkp - s * vkq;
+                    vectors[k * dims + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+template <size_t Reduced>
+auto inline LearnRandom(Projection<Reduced> & projection) noexcept -> void
+{
+    std::mt19937 engine{SEED};
+    std::normal_distribution<double> normal{0.0, 1.0};
+
+    std::vector<double> rows(Reduced * Descriptor::DIMENSIONS);
+
+    for (size_t row = 0; row < Reduced; ++row)
+    {
+        auto * const vector = rows.data() + row * Descriptor::DIMENSIONS;
+        std::generate(vector, vector + Descriptor::DIMENSIONS, [&] { return normal(engine); });
+
+        for (size_t previous = 0; previous < row; ++previous)
+        {
+            auto const * const other = rows.data() + previous * Descriptor::DIMENSIONS;
+            auto const dot = std::inner_product(vector, vector + Descriptor::DIMENSIONS, other, 0.0);
+
+            std::transform(vector, vector + Descriptor::DIMENSIONS, other, vector, [dot](auto const lhs, auto const rhs) { return lhs - dot * rhs; });
+        }
+
+        auto const norm = std::sqrt(std::inner_product(vector, vector + Descriptor::DIMENSIONS, vector, 0.0));
+
+        std::transform(vector, vector + Descriptor::DIMENSIONS, vector, [norm](auto const value) { return value / norm; });
+        std::transform(vector, vector + Descriptor::DIMENSIONS, projection.matrix[row], [](auto const value) { return static_cast<float>(value); });
+    }
+
+    std::fill(projection.mean, projection.mean + Descriptor::DIMENSIONS, 0.0F);
+    projection.explained = static_cast<double>(Reduced) / static_cast<double>(Descriptor::DIMENSIONS);
+}
+
+template <size_t Reduced>
+auto inline LearnPCA(Projection<Reduced> & projection) noexcept -> void
+{
+    constexpr auto dims = Descriptor::DIMENSIONS;
+
+    std::vector<double> covariance;
+    std::vector<double> vectors;
+
+    Covariance(covariance, projection.mean);
+    Jacobi(covariance, vectors);
+
+    std::vector<size_t> order(dims);
+    std::iota(order.begin(), order.end(), 0UL);
+    std::sort(order.begin(), order.end(), [&covariance](auto const lhs, auto const rhs) { return covariance[lhs * dims + lhs] > covariance[rhs * dims + rhs]; });
+
+    double total{0.0};
+    double kept{0.0};
+
+    for (size_t rank = 0; rank < dims; ++rank)
+    {
+        auto const eigenvalue = covariance[order[rank] * dims + order[rank]];
+
+        total += eigenvalue;
+        kept += rank < Reduced ? eigenvalue : 0.0;
+    }
+
+    for (size_t row = 0; row < Reduced; ++row)
+    {
+        for (size_t dim = 0; dim < dims; ++dim)
+        {
+            projection.matrix[row][dim] = static_cast<float>(vectors[dim * dims + order[row]]);
+        }
+    }
+
+    projection.explained = kept / total;
+}
+
+template <size_t Reduced>
+auto inline Project(Projection<Reduced> const & projection, Descriptor const * const descriptors, std::vector<ReducedDescriptor<Reduced>> & reduced) noexcept -> void
+{
+    reduced.resize(NUM_OF_POINTS);
+
+    for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+    {
+        alignas(ALIGN) float centered[Descriptor::DIMENSIONS];
+
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            centered[dim] = descriptors[idx][dim] - projection.mean[dim];
+        }
+
+        for (size_t row = 0; row < Reduced; ++row)
+        {
+            reduced[idx].features[row] = std::inner_product(centered, centered + Descriptor::DIMENSIONS, projection.matrix[row], 0.0F);
+        }
+    }
+}
+
+/*
+ * Squared L2 distance of two reduced descriptors, one FMA per 8 dimensions.
+ */
+template <size_t Reduced>
+auto inline ReducedDistance(ReducedDescriptor<Reduced> const & lhs, ReducedDescriptor<Reduced> const & rhs) noexcept -> float
+{
+    __m128 sum128, hi64, sum64, hi32, sum32;
+
+    __m256 sum = _mm256_setzero_ps();
+
+    [&]<size_t... Vector>(std::index_sequence<Vector...>)
+    {
+        ((sum = _mm256_fmadd_ps(_mm256_sub_ps(_mm256_load_ps(lhs.features + Vector * FLOAT_VECTOR_SIZE), _mm256_load_ps(rhs.features + Vector * FLOAT_VECTOR_SIZE)),
+                                _mm256_sub_ps(_mm256_load_ps(lhs.features + Vector * FLOAT_VECTOR_SIZE), _mm256_load_ps(rhs.features + Vector * FLOAT_VECTOR_SIZE)), sum)), ...);
+    }(std::make_index_sequence<Reduced / FLOAT_VECTOR_SIZE>{});
+
+    float result{0.0};
+    REDUCE_SUM(result, sum);
+
+    return result;
+}
+
+auto inline PushCandidate(std::vector<Candidate> & heap, size_t const size, float const distance, std::uint32_t const index) noexcept -> void
+{
+    if (heap.size() < size)
+    {
+        heap.push_back(Candidate{distance, index});
+        std::push_heap(heap.begin(), heap.end());
+    }
+    else if (distance < heap.front().distance)
+    {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = Candidate{distance, index};
+        std::push_heap(heap.begin(), heap.end());
+    }
+}
+
+/*
+ * Keeps the shortlist closest references in the reduced space and returns the exact nearest among them. The
+ * shortlist is re-ranked in index order, so ties resolve like the brute-force search.
+ */
+template <size_t Reduced, Norm Metric>
+auto inline SearchShortlist(std::vector<ReducedDescriptor<Reduced>> const & queries, std::vector<ReducedDescriptor<Reduced>> const & references, size_t const shortlist) noexcept -> void
+{
+    std::vector<Candidate> heap;
+    heap.reserve(shortlist);
+
+    for (size_t query = 0; query < NUM_OF_POINTS; ++query)
+    {
+        for (size_t reference = 0; reference < NUM_OF_POINTS; ++reference)
+        {
+            PushCandidate(heap, shortlist, ReducedDistance(queries[query], references[reference]), static_cast<std::uint32_t>(reference));
+        }
+
+        std::sort(heap.begin(), heap.end(), [](auto const & lhs, auto const & rhs) { return lhs.index < rhs.index; });
+
+        float minDistance = std::numeric_limits<float>::max();
+
+        for (auto const & candidate : heap)
+        {
+            float const currentDistance = Metric == Norm::L2 ? Descriptor::getL2Norm(set1[query], set2[candidate.index]) : Descriptor::getL1Norm(set1[query], set2[candidate.index]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesTwoStage[query] = candidate.index;
+            }
+        }
+
+        heap.clear();
+    }
+}
+
+/*
+ * Exact L2 search pruned by the reduced lower bound. Returns how many full distances were computed.
+ */
+template <size_t Reduced>
+auto inline SearchExact(std::vector<ReducedDescriptor<Reduced>> const & queries, std::vector<ReducedDescriptor<Reduced>> const & references) noexcept -> size_t
+{
+    std::vector<float> bounds(NUM_OF_POINTS);
+    std::vector<Candidate> heap;
+    heap.reserve(SEED_CANDIDATES);
+
+    size_t evaluated{0};
+
+    for (size_t query = 0; query < NUM_OF_POINTS; ++query)
+    {
+        for (size_t reference = 0; reference < NUM_OF_POINTS; ++reference)
+        {
+            bounds[reference] = ReducedDistance(queries[query], references[reference]);
+            PushCandidate(heap, SEED_CANDIDATES, bounds[reference], static_cast<std::uint32_t>(reference));
+        }
+
+        float minDistance = std::numeric_limits<float>::max();
+        size_t minIndex{0};
+
+        for (auto const & candidate : heap)
+        {
+            float const currentDistance = Descriptor::getL2Norm(set1[query], set2[candidate.index]);
+
+            if (currentDistance < minDistance || (currentDistance == minDistance && candidate.index < minIndex))
+            {
+                minDistance = currentDistance;
+                minIndex = candidate.index;
+            }
+
+            /* Marks the seed as done, no bound is ever negative */
+            bounds[candidate.index] = -1.0F;
+        }
+
+        evaluated += heap.size();
+        heap.clear();
+
+        /* The bounds are squared, the threshold is compared squared with the slack */
+        for (size_t reference = 0; reference < NUM_OF_POINTS; ++reference)
+        {
+            auto const threshold = minDistance * minDistance * (1.0F + BOUND_SLACK);
+
+            if (bounds[reference] < 0.0F || bounds[reference] > threshold)
+            {
+                continue;
+            }
+
+            float const currentDistance = Descriptor::getL2Norm(set1[query], set2[reference]);
+            ++evaluated;
+
+            if (currentDistance < minDistance || (currentDistance == minDistance && reference < minIndex))
+            {
+                minDistance = currentDistance;
+                minIndex = reference;
+            }
+        }
+
+        indicesTwoStage[query] = minIndex;
+    }
+
+    return evaluated;
+}
+
+template <size_t Reduced>
+auto inline RunProjection(Method const method) -> void
+{
+    auto const name = std::format("{} {}-D", method == Method::PCA ? "PCA" : "Random", Reduced);
+    auto const projection = std::make_unique<Projection<Reduced>>();
+
+    std::vector<ReducedDescriptor<Reduced>> queries;
+    std::vector<ReducedDescriptor<Reduced>> references;
+
+    std::cout << std::format("Starting Learning {} Projection\n", name);
+
+    TestSpeed([&]
+    {
+        method == Method::PCA ? LearnPCA(*projection) : LearnRandom(*projection);
+
+        Project(*projection, set1, queries);
+        Project(*projection, set2, references);
+    }, "Learn and Project");
+
+    std::cout << std::format("Variance kept by {} : {:.2f}%\n", name, projection->explained * 100.0);
+
+    /* The shortlist only touches the floats it re-ranks, the exact mode may need all of them */
+    auto const reducedBytes = references.size() * sizeof(ReducedDescriptor<Reduced>) + sizeof(Projection<Reduced>);
+    auto const engine = std::format("Projection {}", name);
+
+    for (auto const shortlist : SHORTLIST)
+    {
+        Evaluate<Norm::L1>([&] { SearchShortlist<Reduced, Norm::L1>(queries, references, shortlist); }, std::format("{} L1 shortlist {:>4}", name, shortlist));
+        auto const queriesPerSecond = Evaluate<Norm::L2>([&] { SearchShortlist<Reduced, Norm::L2>(queries, references, shortlist); }, std::format("{} L2 shortlist {:>4}", name, shortlist));
+
+        AppendRecall(groundTruth, engine, std::format("shortlist={}", shortlist), 1, GroundTruthRecall(groundTruth, indicesTwoStage, NUM_OF_POINTS), queriesPerSecond, 1, reducedBytes);
+    }
+
+    size_t evaluated{0};
+    auto const queriesPerSecond = Evaluate<Norm::L2>([&] { evaluated = SearchExact(queries, references); }, std::format("{} L2 exact        ", name));
+
+    AppendRecall(groundTruth, engine, "exact", 1, GroundTruthRecall(groundTruth, indicesTwoStage, NUM_OF_POINTS), queriesPerSecond, 1, reducedBytes + sizeof(set2));
+
+    auto const pairs = static_cast<double>(NUM_OF_POINTS) * static_cast<double>(NUM_OF_POINTS);
+    std::cout << std::format("Full distances computed by {} exact : {:.2f}%\n", name, static_cast<double>(evaluated) / pairs * 100.0);
+
+    Cooldown();
+}
+
+/*
+ * Runs one search over all queries, reports it against the brute-force result and returns its queries per second.
+ */
+template <Norm Metric>
+auto inline Evaluate(std::function<void()> const & search, std::string_view const message) noexcept -> double
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    search();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
+
+    auto const * const reference = Metric == Norm::L2 ? indicesL2 : indicesL1;
+    auto const hits = std::transform_reduce(reference, reference + NUM_OF_POINTS, indicesTwoStage, 0UL, std::plus<>(), std::equal_to<>());
+    auto const recall = static_cast<double>(hits) / static_cast<double>(NUM_OF_POINTS) * 100.0;
+    auto const checksum = std::reduce(indicesTwoStage, indicesTwoStage + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+
+    std::cout << std::format("{} : Recall@1 {:6.2f}%, {:>5} ms, checksum {:#x}\n", message, recall, time_ms, checksum);
+
+    return static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(time_ms, 1L)) / 1e3);
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -0,0 +1,577 @@
+/*
+## Quantized Descriptors
+
+The float descriptors are quantized once to 8 bits with a single per-dataset scale (255 / largest feature
+over both sets, or 1 when every feature is 0), so integer distances stay comparable across descriptors. A
+quantized descriptor is 128 B instead of 512 B.
+
+L1 uses _mm256_sad_epu8, which sums the absolute differences of 8 bytes into a 64-bit lane in one
+instruction. For L2 the absolute difference |a - b| is formed in 8 bits (max - min) and squared in 16-bit
+lanes; pmaddubsw/vpdpbusd would need one operand to be a signed byte, which |a - b| up to 255 does not fit,
+so the 16-bit pair products use _mm256_madd_epi16 on AVX2 and the fused VNNI _mm256_dpwssd_epi32 when
+AVX-512 VNNI is available (selected at runtime). All integer distances are exact, so the only deviation from
+the float search comes from the quantization itself, which is reported as recall@1.
+
+Usage: DistanceQuantized [dataset]. Given the name of a DistanceDataset dataset, the sets are read from its .dset
+files and the quantized L2 search is scored against its cached .gt and appended to ../recall.csv.
+*/
+
+#include "Dataset.hpp"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <new>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    BYTE_VECTOR_SIZE = 32,
+    QUANTIZATION_LEVELS = 255,
+};
+
+enum class InstructionSet : std::uint8_t
+{
+    AVX2,
+    VNNI,
+};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+class QuantizedDescriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = Descriptor::DIMENSIONS;
+
+    QuantizedDescriptor() noexcept = default;
+
+    QuantizedDescriptor(Descriptor const & descriptor, float const scale) noexcept
+    {
+        for (size_t dim = 0; dim < DIMENSIONS; ++dim)
+        {
+            auto const level = std::clamp(std::nearbyint(descriptor[dim] * scale), 0.0F, static_cast<float>(QUANTIZATION_LEVELS));
+            features[dim] = static_cast<std::uint8_t>(level);
+        }
+    }
+
+    std::uint8_t const * data() const noexcept
+    {
+        return features;
+    }
+
+private:
+    alignas(ALIGN) std::uint8_t features[DIMENSIONS]{};
+};
+
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+struct AVX2Kernels
+{
+    static std::uint32_t L1(QuantizedDescriptor const & lhs, QuantizedDescriptor const & rhs) noexcept
+    {
+        auto const * const left = reinterpret_cast<__m256i const *>(lhs.data());
+        auto const * const right = reinterpret_cast<__m256i const *>(rhs.data());
+
+        __m256i const sum0 = _mm256_add_epi64(_mm256_sad_epu8(_mm256_load_si256(left + 0), _mm256_load_si256(right + 0)),
+                                              _mm256_sad_epu8(_mm256_load_si256(left + 1), _mm256_load_si256(right + 1)));
+        __m256i const sum1 = _mm256_add_epi64(_mm256_sad_epu8(_mm256_load_si256(left + 2), _mm256_load_si256(right + 2)),
+                                              _mm256_sad_epu8(_mm256_load_si256(left + 3), _mm256_load_si256(right + 3)));
+
+        return ReduceEpi64(_mm256_add_epi64(sum0, sum1));
+    }
+
+    static std::uint32_t L2(QuantizedDescriptor const & lhs, QuantizedDescriptor const & rhs) noexcept
+    {
+        auto const * const left = reinterpret_cast<__m256i const *>(lhs.data());
+        auto const * const right = reinterpret_cast<__m256i const *>(rhs.data());
+
+        __m256i const zero = _mm256_setzero_si256();
+        __m256i sum = _mm256_setzero_si256();
+
+        for (size_t idx = 0; idx < QuantizedDescriptor::DIMENSIONS / BYTE_VECTOR_SIZE; ++idx)
+        {
+            __m256i const a = _mm256_load_si256(left + idx);
+            __m256i const b = _mm256_load_si256(right + idx);
+            __m256i const diff = _mm256_sub_epi8(_mm256_max_epu8(a, b), _mm256_min_epu8(a, b)); /* |a - b| as unsigned bytes */
+            __m256i const low = _mm256_unpacklo_epi8(diff, zero);                                /* Widen to 16-bit lanes */
+            __m256i const high = _mm256_unpackhi_epi8(diff, zero);
+
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(low, low));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(high, high));
+        }
+
+        return ReduceEpi32(sum);
+    }
+
+    template <typename Function>
+    __attribute__((flatten)) static void Run(Function const & function) noexcept
+    {
+        function.template operator()<AVX2Kernels>();
+    }
+
+    static std::uint32_t ReduceEpi64(__m256i const sum) noexcept
+    {
+        __m128i const sum128 = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        return static_cast<std::uint32_t>(_mm_cvtsi128_si64(_mm_add_epi64(sum128, _mm_unpackhi_epi64(sum128, sum128))));
+    }
+
+    static std::uint32_t ReduceEpi32(__m256i const sum) noexcept
+    {
+        __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<std::uint32_t>(_mm_cvtsi128_si32(sum128));
+    }
+};
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,avx512vl,avx512vnni")
+
+struct VNNIKernels
+{
+    static std::uint32_t L1(QuantizedDescriptor const & lhs, QuantizedDescriptor const & rhs) noexcept
+    {
+        return AVX2Kernels::L1(lhs, rhs);
+    }
+
+    static std::uint32_t L2(QuantizedDescriptor const & lhs, QuantizedDescriptor const & rhs) noexcept
+    {
+        auto const * const left = reinterpret_cast<__m256i const *>(lhs.data());
+        auto const * const right = reinterpret_cast<__m256i const *>(rhs.data());
+
+        __m256i const zero = _mm256_setzero_si256();
+        __m256i sum0 = _mm256_setzero_si256();
+        __m256i sum1 = _mm256_setzero_si256();
+
+        for (size_t idx = 0; idx < QuantizedDescriptor::DIMENSIONS / BYTE_VECTOR_SIZE; ++idx)
+        {
+            __m256i const a = _mm256_load_si256(left + idx);
+            __m256i const b = _mm256_load_si256(right + idx);
+            __m256i const diff = _mm256_sub_epi8(_mm256_max_epu8(a, b), _mm256_min_epu8(a, b)); /* |a - b| as unsigned bytes */
+            __m256i const low = _mm256_unpacklo_epi8(diff, zero);                                /* Widen to 16-bit lanes */
+            __m256i const high = _mm256_unpackhi_epi8(diff, zero);
+
+            sum0 = _mm256_dpwssd_epi32(sum0, low, low);   /* Fused 16-bit multiply and 32-bit accumulate */
+            sum1 = _mm256_dpwssd_epi32(sum1, high, high);
+        }
+
+        return AVX2Kernels::ReduceEpi32(_mm256_add_epi32(sum0, sum1));
+    }
+
+    template <typename Function>
+    __attribute__((flatten)) static void Run(Function const & function) noexcept
+    {
+        function.template operator()<VNNIKernels>();
+    }
+};
+
+#pragma GCC pop_options
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) QuantizedDescriptor quantized1[NUM_OF_POINTS];
+alignas(ALIGN) QuantizedDescriptor quantized2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesQuantizedL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesQuantizedL2[NUM_OF_POINTS];
+
+static GroundTruth groundTruth{};
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+auto inline ComputeRecall(size_t const * const expected, size_t const * const actual, std::string_view const message) noexcept -> void;
+
+auto inline CompareL1() noexcept -> void;
+auto inline CompareL2() noexcept -> void;
+
+auto inline Quantize() noexcept -> void;
+
+auto inline GetInstructionSet() noexcept -> InstructionSet;
+
+template <typename Function>
+auto inline Dispatch(Function const & function) noexcept -> void;
+
+template <typename Kernels>
+auto inline CompareQuantizedL1() noexcept -> void;
+template <typename Kernels>
+auto inline CompareQuantizedL2() noexcept -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main(int const argc, char const * const argv[])
+{
+    try
+    {
+        if (argc > 2)
+        {
+            std::cerr << "Usage: DistanceQuantized [dataset]\n";
+            return EXIT_FAILURE;
+        }
+
+        if (argc == 2)
+        {
+            groundTruth = LoadDataset(argv[1], set1, set2, NUM_OF_POINTS);
+        }
+
+        std::cout << std::format("Instruction Set : {}\n", GetInstructionSet() == InstructionSet::VNNI ? "AVX-512 VNNI" : "AVX2");
+        std::cout << std::format("Memory per Set : {} KiB (float) / {} KiB (quantized)\n", sizeof(set2) / 1024, sizeof(quantized2) / 1024);
+
+        std::cout << "Starting Comparing L1 Norm\n";
+        TestSpeed(CompareL1, "CompareL1");
+
+        ComputeChecksum(indicesL1, "L1 Norm");
+
+        Cooldown();
+
+        std::cout << "Starting Comparing L2 Norm\n";
+        TestSpeed(CompareL2, "CompareL2");
+
+        ComputeChecksum(indicesL2, "L2 Norm");
+
+        Cooldown();
+
+        std::cout << "Starting Quantizing Descriptors\n";
+        TestSpeed(Quantize, "Quantize");
+
+        Cooldown();
+
+        std::cout << "Starting Comparing L1 Norm (Quantized)\n";
+        TestSpeed([] { Dispatch([]<typename Kernels> { CompareQuantizedL1<Kernels>(); }); }, "CompareQuantizedL1");
+
+        ComputeChecksum(indicesQuantizedL1, "L1 Norm (Quantized)");
+        ComputeRecall(indicesL1, indicesQuantizedL1, "L1 Norm (Quantized)");
+
+        Cooldown();
+
+        std::cout << "Starting Comparing L2 Norm (Quantized)\n";
+        auto const quantizedL2_ms = TestSpeed([] { Dispatch([]<typename Kernels> { CompareQuantizedL2<Kernels>(); }); }, "CompareQuantizedL2");
+
+        ComputeChecksum(indicesQuantizedL2, "L2 Norm (Quantized)");
+        ComputeRecall(indicesL2, indicesQuantizedL2, "L2 Norm (Quantized)");
+
+        /* The quantized sets replace the floats, nothing is re-ranked */
+        auto const queriesPerSecond = static_cast<double>(NUM_OF_POINTS) / (static_cast<double>(std::max(quantizedL2_ms, 1L)) / 1e3);
+        AppendRecall(groundTruth, "Quantized", GetInstructionSet() == InstructionSet::VNNI ? "VNNI" : "AVX2", 1, GroundTruthRecall(groundTruth, indicesQuantizedL2, NUM_OF_POINTS), queriesPerSecond, 1, sizeof(quantized2));
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> long
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+
+    return time_ms;
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+
+auto inline CompareL1() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL1Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL2() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL2Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline ComputeRecall(size_t const * const expected, size_t const * const actual, std::string_view const message) noexcept -> void
+{
+    auto const matches = std::transform_reduce(expected, expected + NUM_OF_POINTS, actual, 0UL, std::plus<>(), std::equal_to<>());
+    std::cout << std::format("Recall@1 for {} : {:.2f} %\n", message, 100.0 * static_cast<double>(matches) / static_cast<double>(NUM_OF_POINTS));
+}
+
+auto inline Quantize() noexcept -> void
+{
+    float maximum{0.0};
+
+    for (auto const * const set: {set1, set2})
+    {
+        for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+        {
+            for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+            {
+                maximum = std::max(maximum, set[idx][dim]);
+            }
+        }
+    }
+
+    /* Sets without a positive feature quantize to all-zero codes instead of dividing by zero */
+    float const scale = maximum > 0.0F ? static_cast<float>(QUANTIZATION_LEVELS) / maximum : 1.0F;
+
+    for (size_t idx = 0; idx < NUM_OF_POINTS; ++idx)
+    {
+        quantized1[idx] = QuantizedDescriptor{set1[idx], scale};
+        quantized2[idx] = QuantizedDescriptor{set2[idx], scale};
+    }
+}
+
+auto inline GetInstructionSet() noexcept -> InstructionSet
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512vl"))
+    {
+        return InstructionSet::VNNI;
+    }
+
+    return InstructionSet::AVX2;
+}
+
+/*
+ * Runs the search once with the widest kernels the host supports. Dispatching around the whole loop through
+ * Kernels::Run() (instead of per distance) compiles the loop for the same target, so the kernels inline into it.
+ */
+template <typename Function>
+auto inline Dispatch(Function const & function) noexcept -> void
+{
+    static InstructionSet const instructionSet = GetInstructionSet();
+
+    switch (instructionSet)
+    {
+        case InstructionSet::VNNI :
+            VNNIKernels::Run(function);
+            break;
+        case InstructionSet::AVX2 :
+            AVX2Kernels::Run(function);
+            break;
+        default :
+            break;
+    }
+}
+
+template <typename Kernels>
+auto inline CompareQuantizedL1() noexcept -> void
+{
+    std::uint32_t minDistance{0};
+    std::uint32_t currentDistance{0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<std::uint32_t>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Kernels::L1(quantized1[idx1], quantized2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesQuantizedL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+template <typename Kernels>
+auto inline CompareQuantizedL2() noexcept -> void
+{
+    std::uint32_t minDistance{0};
+    std::uint32_t currentDistance{0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<std::uint32_t>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Kernels::L2(quantized1[idx1], quantized2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesQuantizedL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
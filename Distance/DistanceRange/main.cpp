@@ -0,0 +1,644 @@
+/*
+## Range Search
+
+Instead of the nearest reference, every reference within the radius of the query is returned. The distances of
+a query are computed a block of REFERENCE_BLOCK references at a time and the block is then thresholded with SIMD
+compares. The hit indices are packed with a compress-store: VPCOMPRESSD under the compare mask on AVX-512, or on
+AVX2 a movemask whose 8 bits select a permutation from a 256-entry table. No branch depends on whether a reference
+is a hit.
+
+The queries are answered in chunks of QUERY_CHUNK, and every thread takes a contiguous range of a chunk. Each
+thread appends its hits to its own buffer and stores one count per query. After the chunk a prefix sum of the
+counts gives the CSR offsets, and every thread copies its buffer to its own disjoint range of the output without
+locks. Each finished chunk is handed to a consumer as CSR arrays (offsets and hit indices), and the buffers are
+reused, so memory grows with the hits of one chunk and never needs a vector per query.
+
+The radius is the HIT_FRACTION quantile of the distances of a sample of queries. The consumer recovers the nearest
+hit of every query and checks it against the brute-force search. Queries whose nearest neighbour is farther than
+the radius have no hits and are counted separately. It also checks the hit counts of the first NUM_OF_CHECKS
+queries against a scalar count. Every supported instruction set runs, and the hits of every query are compared
+with the ones of the first set, so the sets must agree on each hit, not only on the totals.
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <vector>
+#include <array>
+#include <utility>
+#include <stdexcept>
+#include <cstdlib>
+
+#include <immintrin.h>
+#include <omp.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    REFERENCE_BLOCK = 256,
+    QUERY_CHUNK = 1'024,
+    COMPRESS_SLACK = 16,
+    RADIUS_SAMPLE = 64,
+    NUM_OF_CHECKS = 100,
+};
+
+static constexpr double HIT_FRACTION{0.005};
+static constexpr std::uint64_t HIT_HASH_MULTIPLIER{0x9E3779B97F4A7C15UL};
+
+enum class InstructionSet : std::uint8_t
+{
+    AVX2,
+    AVX512,
+};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+enum class Norm : std::uint8_t
+{
+    L1,
+    L2,
+};
+
+
+/*
+ * For every 8-bit compare mask, the lanes of the set bits in order, padded with zeros.
+ */
+static constexpr auto COMPRESS_TABLE = []
+{
+    std::array<std::array<std::int32_t, 8>, 256> table{};
+
+    for (size_t mask = 0; mask < table.size(); ++mask)
+    {
+        size_t count{0};
+
+        for (std::int32_t lane = 0; lane < 8; ++lane)
+        {
+            if ((mask >> lane & 1U) != 0)
+            {
+                table[mask][count++] = lane;
+            }
+        }
+    }
+
+    return table;
+}();
+
+
+/*
+ * Threshold kernels: Select writes the indices (base + lane) of the distances of a block that are within the
+ * radius and returns how many it wrote. They may write up to COMPRESS_SLACK entries past the last hit.
+ */
+
+#pragma GCC push_options
+#pragma GCC target("avx2,popcnt")
+
+struct AVX2Kernels
+{
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::AVX2};
+    static constexpr size_t WIDTH{8};
+
+    static size_t Select(float const * const distances, float const radius, std::uint32_t const base, std::uint32_t * const output) noexcept
+    {
+        __m256 const threshold = _mm256_set1_ps(radius);
+        __m256i const step = _mm256_set1_epi32(WIDTH);
+        __m256i lanes = _mm256_add_epi32(_mm256_set1_epi32(static_cast<std::int32_t>(base)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+        size_t count{0};
+
+        for (size_t idx = 0; idx < REFERENCE_BLOCK; idx += WIDTH)
+        {
+            auto const mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_load_ps(distances + idx), threshold, _CMP_LE_OQ)));
+            __m256i const permutation = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(COMPRESS_TABLE[mask].data()));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + count), _mm256_permutevar8x32_epi32(lanes, permutation));
+
+            count += static_cast<size_t>(_mm_popcnt_u32(mask));
+            lanes = _mm256_add_epi32(lanes, step);
+        }
+
+        return count;
+    }
+};
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,popcnt")
+
+struct AVX512Kernels
+{
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::AVX512};
+    static constexpr size_t WIDTH{16};
+
+    static size_t Select(float const * const distances, float const radius, std::uint32_t const base, std::uint32_t * const output) noexcept
+    {
+        __m512 const threshold = _mm512_set1_ps(radius);
+        __m512i const step = _mm512_set1_epi32(WIDTH);
+        __m512i lanes = _mm512_add_epi32(_mm512_set1_epi32(static_cast<std::int32_t>(base)), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+        size_t count{0};
+
+        for (size_t idx = 0; idx < REFERENCE_BLOCK; idx += WIDTH)
+        {
+            __mmask16 const mask = _mm512_cmp_ps_mask(_mm512_load_ps(distances + idx), threshold, _CMP_LE_OQ);
+
+            _mm512_mask_compressstoreu_epi32(output + count, mask, lanes);
+
+            count += static_cast<size_t>(_mm_popcnt_u32(mask));
+            lanes = _mm512_add_epi32(lanes, step);
+        }
+
+        return count;
+    }
+};
+
+#pragma GCC pop_options
+
+
+/*
+ * Per-thread hit storage, grown geometrically and kept across chunks.
+ */
+struct HitBuffer
+{
+    void Reserve(size_t const extra)
+    {
+        if (size + extra > hits.size())
+        {
+            hits.resize(std::max(2 * hits.size(), size + extra));
+        }
+    }
+
+    std::vector<std::uint32_t> hits;
+    size_t size{0};
+};
+
+using Consumer = std::function<void(size_t const first, size_t const count, std::uint64_t const * offsets, std::uint32_t const * hits)>;
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+
+auto inline GetInstructionSet() -> InstructionSet;
+auto inline GetInstructionSetName(InstructionSet const instructionSet) noexcept -> std::string_view;
+
+template <typename Function>
+auto inline Dispatch(InstructionSet const instructionSet, Function const & function) noexcept -> void;
+
+template <Norm Metric>
+auto inline GetDistance(Descriptor const & lhs, Descriptor const & rhs) noexcept -> float;
+template <Norm Metric>
+auto inline ChooseRadius() -> float;
+
+template <Norm Metric>
+auto inline Compare(size_t * const indices) noexcept -> void;
+template <typename Kernels, Norm Metric>
+auto inline RangeSearch(float const radius, Consumer const & consumer) -> void;
+template <Norm Metric>
+auto inline TestRange(size_t const * const nearest, std::string_view const message) -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    try
+    {
+        std::cout << std::format("Instruction Set : {}\n", GetInstructionSetName(GetInstructionSet()));
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Starting Comparing L1 Norm\n";
+    TestSpeed([] { Compare<Norm::L1>(indicesL1); }, "CompareL1");
+
+    ComputeChecksum(indicesL1, "L1 Norm");
+
+    TestRange<Norm::L1>(indicesL1, "L1 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm\n";
+    TestSpeed([] { Compare<Norm::L2>(indicesL2); }, "CompareL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    TestRange<Norm::L2>(indicesL2, "L2 Norm");
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+/*
+ * The widest kernel set the CPU runs. Both sets also use POPCNT, and there is no fallback below AVX2.
+ */
+auto inline GetInstructionSet() -> InstructionSet
+{
+    __builtin_cpu_init();
+
+    if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("popcnt"))
+    {
+        throw std::runtime_error{"The range search needs a CPU with AVX2 and POPCNT"};
+    }
+
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return InstructionSet::AVX512;
+    }
+
+    return InstructionSet::AVX2;
+}
+
+auto inline GetInstructionSetName(InstructionSet const instructionSet) noexcept -> std::string_view
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::AVX512 :
+            return "AVX-512";
+        case InstructionSet::AVX2 :
+            return "AVX2";
+        default :
+            return "Unknown";
+    }
+}
+
+/*
+ * Runs the function once with the kernels of the given instruction set.
+ */
+template <typename Function>
+auto inline Dispatch(InstructionSet const instructionSet, Function const & function) noexcept -> void
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::AVX512 :
+            function.template operator()<AVX512Kernels>();
+            break;
+        case InstructionSet::AVX2 :
+            function.template operator()<AVX2Kernels>();
+            break;
+        default :
+            break;
+    }
+}
+
+template <Norm Metric>
+auto inline GetDistance(Descriptor const & lhs, Descriptor const & rhs) noexcept -> float
+{
+    return Metric == Norm::L2 ? Descriptor::getL2Norm(lhs, rhs) : Descriptor::getL1Norm(lhs, rhs);
+}
+
+/*
+ * The HIT_FRACTION quantile of the distances from the first RADIUS_SAMPLE queries to all references.
+ */
+template <Norm Metric>
+auto inline ChooseRadius() -> float
+{
+    std::vector<float> distances;
+    distances.reserve(RADIUS_SAMPLE * NUM_OF_POINTS);
+
+    for (size_t idx1 = 0; idx1 < RADIUS_SAMPLE; ++idx1)
+    {
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            distances.push_back(GetDistance<Metric>(set1[idx1], set2[idx2]));
+        }
+    }
+
+    auto const rank = distances.begin() + static_cast<std::ptrdiff_t>(HIT_FRACTION * static_cast<double>(distances.size()));
+    std::nth_element(distances.begin(), rank, distances.end());
+
+    return *rank;
+}
+
+template <Norm Metric>
+auto inline Compare(size_t * const indices) noexcept -> void
+{
+    #pragma omp parallel for schedule(static)
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        float minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            float const currentDistance = GetDistance<Metric>(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indices[idx1] = idx2;
+            }
+        }
+    }
+}
+
+/*
+ * Every reference within the radius of every query of set1, streamed to the consumer one chunk at a time.
+ */
+template <typename Kernels, Norm Metric>
+auto inline RangeSearch(float const radius, Consumer const & consumer) -> void
+{
+    std::vector<HitBuffer> buffers(static_cast<size_t>(omp_get_max_threads()));
+    std::vector<std::uint64_t> offsets(QUERY_CHUNK + 1);
+    std::vector<std::uint32_t> hits;
+
+    for (size_t chunk = 0; chunk < NUM_OF_POINTS; chunk += QUERY_CHUNK)
+    {
+        auto const numOfQueries = std::min<size_t>(QUERY_CHUNK, NUM_OF_POINTS - chunk);
+
+        #pragma omp parallel
+        {
+            auto const thread = static_cast<size_t>(omp_get_thread_num());
+            auto const numOfThreads = static_cast<size_t>(omp_get_num_threads());
+            auto const begin = numOfQueries * thread / numOfThreads;
+            auto const end = numOfQueries * (thread + 1) / numOfThreads;
+
+            auto & buffer = buffers[thread];
+            alignas(ALIGN) float distances[REFERENCE_BLOCK];
+
+            buffer.size = 0;
+
+            for (size_t query = begin; query < end; ++query)
+            {
+                size_t count{0};
+
+                for (size_t block = 0; block < NUM_OF_POINTS; block += REFERENCE_BLOCK)
+                {
+                    auto const blockSize = std::min<size_t>(REFERENCE_BLOCK, NUM_OF_POINTS - block);
+
+                    for (size_t idx = 0; idx < blockSize; ++idx)
+                    {
+                        distances[idx] = GetDistance<Metric>(set1[chunk + query], set2[block + idx]);
+                    }
+
+                    /* The padding of the last block can never be a hit */
+                    std::fill(distances + blockSize, distances + REFERENCE_BLOCK, std::numeric_limits<float>::max());
+
+                    buffer.Reserve(REFERENCE_BLOCK + COMPRESS_SLACK);
+
+                    auto const selected = Kernels::Select(distances, radius, static_cast<std::uint32_t>(block), buffer.hits.data() + buffer.size);
+
+                    buffer.size += selected;
+                    count += selected;
+                }
+
+                offsets[query + 1] = count;
+            }
+
+            #pragma omp barrier
+
+            #pragma omp single
+            {
+                offsets[0] = 0;
+                std::partial_sum(offsets.begin() + 1, offsets.begin() + static_cast<std::ptrdiff_t>(numOfQueries) + 1, offsets.begin() + 1);
+                hits.resize(std::max<size_t>(hits.size(), offsets[numOfQueries]));
+            }
+
+            /* The queries of a thread are contiguous, so its buffer already is its part of the CSR array */
+            std::copy_n(buffer.hits.begin(), buffer.size, hits.begin() + static_cast<std::ptrdiff_t>(offsets[begin]));
+        }
+
+        consumer(chunk, numOfQueries, offsets.data(), hits.data());
+    }
+}
+
+/*
+ * Range search with every supported instruction set. The consumer keeps the nearest hit of every query, the
+ * number and a checksum of all hits, and checks the counts of the first queries against a scalar count. It also
+ * hashes the hits of every query in the order they are returned (ascending), and the queries whose hash differs
+ * from the one of the first instruction set are counted as hit mismatches.
+ */
+template <Norm Metric>
+auto inline TestRange(size_t const * const nearest, std::string_view const message) -> void
+{
+    std::vector<size_t> nearestHits(NUM_OF_POINTS);
+    std::vector<std::uint64_t> hitHashes(NUM_OF_POINTS);
+    std::vector<std::uint64_t> referenceHashes;
+
+    auto const radius = ChooseRadius<Metric>();
+
+    std::cout << std::format("Radius for {} : {:.4f}\n", message, radius);
+
+    for (auto const instructionSet : {InstructionSet::AVX2, InstructionSet::AVX512})
+    {
+        if (instructionSet > GetInstructionSet())
+        {
+            break;
+        }
+
+        std::fill(nearestHits.begin(), nearestHits.end(), NUM_OF_POINTS);
+
+        std::uint64_t numOfHits{0};
+        std::uint64_t hitChecksum{0};
+        size_t mismatches{0};
+
+        auto const consumer = [&](size_t const first, size_t const count, std::uint64_t const * const offsets, std::uint32_t const * const hits)
+        {
+            for (size_t query = 0; query < count; ++query)
+            {
+                float minDistance = std::numeric_limits<float>::max();
+                std::uint64_t hitHash{offsets[query + 1] - offsets[query]};
+
+                for (auto hit = offsets[query]; hit < offsets[query + 1]; ++hit)
+                {
+                    float const currentDistance = GetDistance<Metric>(set1[first + query], set2[hits[hit]]);
+
+                    if (currentDistance < minDistance)
+                    {
+                        minDistance = currentDistance;
+                        nearestHits[first + query] = hits[hit];
+                    }
+
+                    hitChecksum ^= (first + query) * NUM_OF_POINTS + hits[hit];
+                    hitHash = hitHash * HIT_HASH_MULTIPLIER + hits[hit] + 1;
+                }
+
+                hitHashes[first + query] = hitHash;
+
+                if (first + query < NUM_OF_CHECKS)
+                {
+                    auto const expected = std::count_if(set2, set2 + NUM_OF_POINTS, [&](auto const & reference) { return GetDistance<Metric>(set1[first + query], reference) <= radius; });
+                    mismatches += static_cast<std::uint64_t>(expected) != offsets[query + 1] - offsets[query] ? 1 : 0;
+                }
+            }
+
+            numOfHits += offsets[count];
+        };
+
+        auto const name = GetInstructionSetName(instructionSet);
+
+        Cooldown();
+
+        std::cout << std::format("Starting Range Search {} ({})\n", message, name);
+        TestSpeed([&] { Dispatch(instructionSet, [&]<typename Kernels> { RangeSearch<Kernels, Metric>(radius, consumer); }); }, std::format("Range Search ({})", name));
+
+        std::cout << std::format("Hits : {} ({:.1f} per query), checksum {:#x}, count mismatches {} / {}\n", numOfHits,
+                                 static_cast<double>(numOfHits) / static_cast<double>(NUM_OF_POINTS), hitChecksum, mismatches, static_cast<size_t>(NUM_OF_CHECKS));
+
+        auto const empty = std::count(nearestHits.begin(), nearestHits.end(), NUM_OF_POINTS);
+        auto const wrong = std::inner_product(nearestHits.begin(), nearestHits.end(), nearest, 0UL, std::plus<>(),
+                                              [](size_t const hit, size_t const expected) { return hit != NUM_OF_POINTS && hit != expected; });
+
+        std::cout << std::format("Queries without hits : {}, nearest hit mismatches : {}\n", empty, wrong);
+
+        if (referenceHashes.empty())
+        {
+            referenceHashes = hitHashes;
+        }
+        else
+        {
+            auto const different = std::inner_product(hitHashes.begin(), hitHashes.end(), referenceHashes.begin(), 0UL, std::plus<>(), std::not_equal_to<>());
+            std::cout << std::format("Hit mismatches against {} : {} / {}\n", GetInstructionSetName(InstructionSet::AVX2), different, static_cast<size_t>(NUM_OF_POINTS));
+        }
+    }
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -1,261 +1,595 @@
-/*
-## Processor
-
-Name: Intel® Core™ i5-6600K
-Cores: 4
-Threads: 4
-Base Frequency: 3.5 GHz
-Max Frequency: 3.9 GHz
-Cache: 6 MB
-Memory Channels: 2
-Max Memory Bandwidth: 34.1 GB/s
-
-## Memory
-
-Name: Corsair Vengeance LPX
-Type: DDR4
-Size: 16 GB (Dual Channel - 2x8 GB)
-Speed: 3200 MT/s
-Latency (Timings): 16-18-18-36
-
-## Environment
-
-Operating System: Ubuntu 23.10 (Mantic Minotaur)
-Kernel: 6.5.0-21-generic
-Compiler: gcc 13.2.0
-*/
-
-/*
-## L1 Norm
-
-Execution Time (Compiler Optimized): 1366 ms
-
-## L2 Norm
-
-Execution Time (Compiler Optimized): 1143 ms
-*/
-
-#include <iostream>
-#include <random>
-#include <algorithm>
-#include <thread>
-#include <functional>
-#include <format>
-#include <new>
-
-#include <immintrin.h>
-
-
-#define ALIGN    std::hardware_destructive_interference_size
-
-#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
-                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
-                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
-                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
-                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
-                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
-
-#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
-                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
-                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
-                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
-                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
-
-#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
-                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
-                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
-                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
-                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
-                                    
-
-
-enum Constants
-{
-    NUM_OF_POINTS = 10'000UL,
-    SEED = 0xDEADBEEF42UL,
-    FLOAT_VECTOR_SIZE = 8
-};
-
-
-class Descriptor
-{
-public:
-    Descriptor() noexcept
-    {
-        std::generate(features, features + DIMENSIONS, generator);
-    }
-
-    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
-    {
-        __m256 left, right, diff, absDiff;
-        __m128 sum128, hi64, sum64, hi32, sum32;
-
-        __m256 sum = _mm256_setzero_ps();
-
-        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
-        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
-
-        float result{0.0};
-        REDUCE_SUM(result, sum);
-
-        return result;
-    }
-
-    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
-    {
-        __m256 left, right, diff, squared;
-        __m128 sum128, hi64, sum64, hi32, sum32;
-
-        __m256 sum = _mm256_setzero_ps();
-
-        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
-        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
-
-        float result{0.0};
-        REDUCE_SUM(result, sum);
-
-        return std::sqrt(result);
-    }
-
-private:
-    static constexpr size_t DIMENSIONS = 128;
-
-    static std::mt19937 randomEngine;
-    static std::uniform_real_distribution<float> randomDistribution;
-    static std::function<float()> generator;
-
-    alignas(ALIGN) float features[DIMENSIONS];
-};
-
-std::mt19937 Descriptor::randomEngine{SEED};
-std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
-std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
-
-
-alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
-alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
-
-alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
-alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
-
-auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void;
-auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
-
-auto inline CompareL1() noexcept -> void;
-auto inline CompareL2() noexcept -> void;
-
-auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
-
-
-int main()
-{
-    std::cout << "Starting Comparing L1 Norm\n";
-    TestSpeed(CompareL1, "CompareL1");
-
-    ComputeChecksum(indicesL1, "L1 Norm");
-
-    Cooldown();
-
-    std::cout << "Starting Comparing L2 Norm\n";
-    TestSpeed(CompareL2, "CompareL2");
-
-    ComputeChecksum(indicesL2, "L2 Norm");
-
-    return 0;
-}
-
-auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void
-{
-    auto const start = std::chrono::high_resolution_clock::now();
-    function();
-    auto const stop = std::chrono::high_resolution_clock::now();
-
-    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
-    auto const time_ms = difference_ms.count();
-
-    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
-}
-
-auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
-{
-    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
-    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
-}
-
-
-auto inline CompareL1() noexcept -> void
-{
-    float minDistance{0.0};
-    float currentDistance{0.0};
-
-    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
-    {
-        minDistance = std::numeric_limits<float>::max();
-
-        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
-        {
-            currentDistance = Descriptor::getL1Norm(set1[idx1], set2[idx2]);
-
-            if (currentDistance < minDistance)
-            {
-                minDistance = currentDistance;
-                indicesL1[idx1] = idx2;
-            }
-        }
-    }
-}
-
-auto inline CompareL2() noexcept -> void
-{
-    float minDistance{0.0};
-    float currentDistance{0.0};
-
-    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
-    {
-        minDistance = std::numeric_limits<float>::max();
-
-        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
-        {
-            currentDistance = Descriptor::getL2Norm(set1[idx1], set2[idx2]);
-
-            if (currentDistance < minDistance)
-            {
-                minDistance = currentDistance;
-                indicesL2[idx1] = idx2;
-            }
-        }
-    }
-}
-
-auto inline Cooldown(std::chrono::seconds const & seconds) -> void
-{
-    std::this_thread::sleep_for(seconds);
+/*
+## Processor
+
+Name: Intel® Core™ i5-6600K
+Cores: 4
+Threads: 4
+Base Frequency: 3.5 GHz
+Max Frequency: 3.9 GHz
+Cache: 6 MB
+Memory Channels: 2
+Max Memory Bandwidth: 34.1 GB/s
+
+## Memory
+
+Name: Corsair Vengeance LPX
+Type: DDR4
+Size: 16 GB (Dual Channel - 2x8 GB)
+Speed: 3200 MT/s
+Latency (Timings): 16-18-18-36
+
+## Environment
+
+Operating System: Ubuntu 23.10 (Mantic Minotaur)
+Kernel: 6.5.0-21-generic
+Compiler: gcc 13.2.0
+*/
+
+/*
+## L1 Norm
+
+Execution Time (Compiler Optimized): 1366 ms
+
+## L2 Norm
+
+Execution Time (Compiler Optimized): 1143 ms
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <utility>
+#include <new>
+#include <vector>
+#include <cstdlib>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    DIMENSIONS = 128,
+    NUM_OF_ACCUMULATORS = 4
+};
+
+enum class InstructionSet : std::uint8_t
+{
+    SSE,
+    AVX2,
+    AVX512,
+};
+
+
+/*
+ * Distance kernels, one set per instruction set. Each set lives in its own target region so it can be
+ * compiled (and dispatched to at runtime) regardless of the host the program is built on. The bodies are
+ * generated at compile time for any number of dimensions: the full-width part is unrolled through an index
+ * sequence over NUM_OF_ACCUMULATORS independent accumulators, and the remainder is handled with a masked load
+ * (AVX2/AVX-512) or a scalar loop (SSE).
+ *
+ * GCC only inlines a function into a caller compiled for at least the same instruction set, so a search loop
+ * built for the baseline target would call the kernels once per distance. Run() flattens the loop it is handed
+ * into the kernels' own target region instead, which makes the kernels inline whatever -march the program is
+ * built with.
+ */
+
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+
+struct SSEKernels
+{
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::SSE};
+    static constexpr size_t WIDTH{4};
+
+    template <size_t Dims>
+    static float L1(float const * const lhs, float const * const rhs) noexcept
+    {
+        __m128 const signMask = _mm_set1_ps(-0.0F);
+        __m128 sum[NUM_OF_ACCUMULATORS] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+
+        [&]<size_t... IDX>(std::index_sequence<IDX...>) -> void
+        {
+            ((sum[IDX % NUM_OF_ACCUMULATORS] = _mm_add_ps(sum[IDX % NUM_OF_ACCUMULATORS], _mm_andnot_ps(signMask, _mm_sub_ps(_mm_load_ps(lhs + IDX * WIDTH), _mm_load_ps(rhs + IDX * WIDTH))))), ...);
+        }(std::make_index_sequence<Dims / WIDTH>{});
+
+        float result = Reduce(sum);
+
+        for (size_t dim = Dims / WIDTH * WIDTH; dim < Dims; ++dim)
+        {
+            result += std::abs(lhs[dim] - rhs[dim]);
+        }
+
+        return result;
+    }
+
+    template <size_t Dims>
+    static float L2(float const * const lhs, float const * const rhs) noexcept
+    {
+        __m128 diff;
+        __m128 sum[NUM_OF_ACCUMULATORS] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+
+        [&]<size_t... IDX>(std::index_sequence<IDX...>) -> void
+        {
+            ((diff = _mm_sub_ps(_mm_load_ps(lhs + IDX * WIDTH), _mm_load_ps(rhs + IDX * WIDTH)),
+              sum[IDX % NUM_OF_ACCUMULATORS] = _mm_add_ps(sum[IDX % NUM_OF_ACCUMULATORS], _mm_mul_ps(diff, diff))), ...);
+        }(std::make_index_sequence<Dims / WIDTH>{});
+
+        float result = Reduce(sum);
+
+        for (size_t dim = Dims / WIDTH * WIDTH; dim < Dims; ++dim)
+        {
+            result += (lhs[dim] - rhs[dim]) * (lhs[dim] - rhs[dim]);
+        }
+
+        return result;
+    }
+
+    template <typename Function>
+    __attribute__((flatten)) static void Run(Function const & function) noexcept
+    {
+        function.template operator()<SSEKernels>();
+    }
+
+private:
+    static float Reduce(__m128 const * const sum) noexcept
+    {
+        __m128 const sum128 = _mm_add_ps(_mm_add_ps(sum[0], sum[1]), _mm_add_ps(sum[2], sum[3])); /* Combine the accumulators */
+        __m128 const hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));        /* Swap the 64-bit halves */
+        __m128 const sum64 = _mm_add_ps(hi64, sum128);                                          /* Add the two 64-bit halves */
+        __m128 const hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));          /* Swap the 32-bit halves */
+        return _mm_cvtss_f32(_mm_add_ps(sum64, hi32));                                          /* Add the two 32-bit halves */
+    }
+};
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+
+struct AVX2Kernels
+{
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::AVX2};
+    static constexpr size_t WIDTH{8};
+
+    template <size_t Dims>
+    static float L1(float const * const lhs, float const * const rhs) noexcept
+    {
+        __m256 const signMask = _mm256_set1_ps(-0.0F);
+        __m256 sum[NUM_OF_ACCUMULATORS] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+
+        [&]<size_t... IDX>(std::index_sequence<IDX...>) -> void
+        {
+            ((sum[IDX % NUM_OF_ACCUMULATORS] = _mm256_add_ps(sum[IDX % NUM_OF_ACCUMULATORS], _mm256_andnot_ps(signMask, _mm256_sub_ps(_mm256_load_ps(lhs + IDX * WIDTH), _mm256_load_ps(rhs + IDX * WIDTH))))), ...);
+        }(std::make_index_sequence<Dims / WIDTH>{});
+
+        if constexpr (Dims % WIDTH != 0)
+        {
+            __m256i const mask = TailMask<Dims % WIDTH>();
+            __m256 const diff = _mm256_sub_ps(_mm256_maskload_ps(lhs + Dims / WIDTH * WIDTH, mask), _mm256_maskload_ps(rhs + Dims / WIDTH * WIDTH, mask));
+            sum[0] = _mm256_add_ps(sum[0], _mm256_andnot_ps(signMask, diff));
+        }
+
+        return Reduce(sum);
+    }
+
+    template <size_t Dims>
+    static float L2(float const * const lhs, float const * const rhs) noexcept
+    {
+        __m256 diff;
+        __m256 sum[NUM_OF_ACCUMULATORS] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+
+        [&]<size_t... IDX>(std::index_sequence<IDX...>) -> void
+        {
+            ((diff = _mm256_sub_ps(_mm256_load_ps(lhs + IDX * WIDTH), _mm256_load_ps(rhs + IDX * WIDTH)),
+              sum[IDX % NUM_OF_ACCUMULATORS] = _mm256_fmadd_ps(diff, diff, sum[IDX % NUM_OF_ACCUMULATORS])), ...);
+        }(std::make_index_sequence<Dims / WIDTH>{});
+
+        if constexpr (Dims % WIDTH != 0)
+        {
+            __m256i const mask = TailMask<Dims % WIDTH>();
+            diff = _mm256_sub_ps(_mm256_maskload_ps(lhs + Dims / WIDTH * WIDTH, mask), _mm256_maskload_ps(rhs + Dims / WIDTH * WIDTH, mask));
+            sum[0] = _mm256_fmadd_ps(diff, diff, sum[0]);
+        }
+
+        return Reduce(sum);
+    }
+
+    template <typename Function>
+    __attribute__((flatten)) static void Run(Function const & function) noexcept
+    {
+        function.template operator()<AVX2Kernels>();
+    }
+
+private:
+    template <size_t Remainder>
+    static __m256i TailMask() noexcept
+    {
+        return _mm256_cmpgt_epi32(_mm256_set1_epi32(Remainder), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    }
+
+    static float Reduce(__m256 const * const sum) noexcept
+    {
+        __m256 const sum256 = _mm256_add_ps(_mm256_add_ps(sum[0], sum[1]), _mm256_add_ps(sum[2], sum[3]));     /* Combine the accumulators */
+        __m128 const sum128 = _mm_add_ps(_mm256_castps256_ps128(sum256), _mm256_extractf128_ps(sum256, 1)); /* Add the lower and upper halves */
+        __m128 const hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves */
+        __m128 const sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves */
+        __m128 const hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves */
+        return _mm_cvtss_f32(_mm_add_ps(sum64, hi32));                                                      /* Add the two 32-bit halves */
+    }
+};
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+struct AVX512Kernels
+{
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::AVX512};
+    static constexpr size_t WIDTH{16};
+
+    template <size_t Dims>
+    static float L1(float const * const lhs, float const * const rhs) noexcept
+    {
+        __m512 sum[NUM_OF_ACCUMULATORS] = {_mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps()};
+
+        [&]<size_t... IDX>(std::index_sequence<IDX...>) -> void
+        {
+            ((sum[IDX % NUM_OF_ACCUMULATORS] = _mm512_add_ps(sum[IDX % NUM_OF_ACCUMULATORS], _mm512_abs_ps(_mm512_sub_ps(_mm512_load_ps(lhs + IDX * WIDTH), _mm512_load_ps(rhs + IDX * WIDTH))))), ...);
+        }(std::make_index_sequence<Dims / WIDTH>{});
+
+        if constexpr (Dims % WIDTH != 0)
+        {
+            __mmask16 constexpr mask = (1U << (Dims % WIDTH)) - 1U;
+            __m512 const diff = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, lhs + Dims / WIDTH * WIDTH), _mm512_maskz_loadu_ps(mask, rhs + Dims / WIDTH * WIDTH));
+            sum[0] = _mm512_add_ps(sum[0], _mm512_abs_ps(diff));
+        }
+
+        return Reduce(sum);
+    }
+
+    template <size_t Dims>
+    static float L2(float const * const lhs, float const * const rhs) noexcept
+    {
+        __m512 diff;
+        __m512 sum[NUM_OF_ACCUMULATORS] = {_mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps()};
+
+        [&]<size_t... IDX>(std::index_sequence<IDX...>) -> void
+        {
+            ((diff = _mm512_sub_ps(_mm512_load_ps(lhs + IDX * WIDTH), _mm512_load_ps(rhs + IDX * WIDTH)),
+              sum[IDX % NUM_OF_ACCUMULATORS] = _mm512_fmadd_ps(diff, diff, sum[IDX % NUM_OF_ACCUMULATORS])), ...);
+        }(std::make_index_sequence<Dims / WIDTH>{});
+
+        if constexpr (Dims % WIDTH != 0)
+        {
+            __mmask16 constexpr mask = (1U << (Dims % WIDTH)) - 1U;
+            diff = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, lhs + Dims / WIDTH * WIDTH), _mm512_maskz_loadu_ps(mask, rhs + Dims / WIDTH * WIDTH));
+            sum[0] = _mm512_fmadd_ps(diff, diff, sum[0]);
+        }
+
+        return Reduce(sum);
+    }
+
+    template <typename Function>
+    __attribute__((flatten)) static void Run(Function const & function) noexcept
+    {
+        function.template operator()<AVX512Kernels>();
+    }
+
+private:
+    static float Reduce(__m512 const * const sum) noexcept
+    {
+        __m512 sum512 = _mm512_add_ps(_mm512_add_ps(sum[0], sum[1]), _mm512_add_ps(sum[2], sum[3]));     /* Combine the accumulators */
+        sum512 = _mm512_add_ps(sum512, _mm512_shuffle_f32x4(sum512, sum512, _MM_SHUFFLE(1U, 0U, 3U, 2U))); /* Add the 256-bit halves */
+        sum512 = _mm512_add_ps(sum512, _mm512_shuffle_f32x4(sum512, sum512, _MM_SHUFFLE(2U, 3U, 0U, 1U))); /* Add the 128-bit quarters */
+        __m128 const sum128 = _mm512_castps512_ps128(sum512);                                             /* Keep the lowest 128 bits */
+        __m128 const hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                  /* Swap the 64-bit halves */
+        __m128 const sum64 = _mm_add_ps(hi64, sum128);                                                    /* Add the two 64-bit halves */
+        __m128 const hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                    /* Swap the 32-bit halves */
+        return _mm_cvtss_f32(_mm_add_ps(sum64, hi32));                                                    /* Add the two 32-bit halves */
+    }
+};
+
+#pragma GCC pop_options
+
+
+class DescriptorGenerator
+{
+protected:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+};
+
+std::mt19937 DescriptorGenerator::randomEngine{SEED};
+std::uniform_real_distribution<float> DescriptorGenerator::randomDistribution{0.0, 1.0};
+std::function<float()> DescriptorGenerator::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+template <size_t Dims>
+class Descriptor : private DescriptorGenerator
+{
+public:
+    static constexpr size_t DIMENSIONS = Dims;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    template <typename Kernels>
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        return Kernels::template L1<Dims>(lhs.features, rhs.features);
+    }
+
+    template <typename Kernels>
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        return std::sqrt(Kernels::template L2<Dims>(lhs.features, rhs.features));
+    }
+
+    float operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+
+alignas(ALIGN) Descriptor<DIMENSIONS> set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor<DIMENSIONS> set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+
+auto inline GetInstructionSet() noexcept -> InstructionSet;
+auto inline GetInstructionSetName(InstructionSet const instructionSet) noexcept -> std::string_view;
+
+template <typename Function>
+auto inline Dispatch(Function const & function) noexcept -> void;
+
+template <typename Kernels>
+auto inline CompareL1() noexcept -> void;
+template <typename Kernels>
+auto inline CompareL2() noexcept -> void;
+
+template <size_t Dims>
+auto inline CheckKernels() -> size_t;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    std::cout << std::format("Instruction Set : {}\n", GetInstructionSetName(GetInstructionSet()));
+
+    std::cout << "Starting Comparing L1 Norm\n";
+    TestSpeed([] { Dispatch([]<typename Kernels> { CompareL1<Kernels>(); }); }, "CompareL1");
+
+    ComputeChecksum(indicesL1, "L1 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm\n";
+    TestSpeed([] { Dispatch([]<typename Kernels> { CompareL2<Kernels>(); }); }, "CompareL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    if (auto const mismatches = CheckKernels<100>() + CheckKernels<130>(); mismatches != 0)
+    {
+        std::cerr << std::format("{} kernel results disagree with the scalar reference\n", mismatches);
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+auto inline GetInstructionSet() noexcept -> InstructionSet
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return InstructionSet::AVX512;
+    }
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return InstructionSet::AVX2;
+    }
+
+    return InstructionSet::SSE;
+}
+
+auto inline GetInstructionSetName(InstructionSet const instructionSet) noexcept -> std::string_view
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::AVX512 :
+            return "AVX-512";
+        case InstructionSet::AVX2 :
+            return "AVX2";
+        case InstructionSet::SSE :
+            return "SSE";
+        default :
+            return "Unknown";
+    }
+}
+
+/*
+ * Runs the search once with the widest kernels the host supports. Dispatching around the whole loop through
+ * Kernels::Run() (instead of per distance) compiles the loop for the same target, so the kernels inline into it.
+ */
+template <typename Function>
+auto inline Dispatch(Function const & function) noexcept -> void
+{
+    static InstructionSet const instructionSet = GetInstructionSet();
+
+    switch (instructionSet)
+    {
+        case InstructionSet::AVX512 :
+            AVX512Kernels::Run(function);
+            break;
+        case InstructionSet::AVX2 :
+            AVX2Kernels::Run(function);
+            break;
+        case InstructionSet::SSE :
+            SSEKernels::Run(function);
+            break;
+        default :
+            break;
+    }
+}
+
+
+template <typename Kernels>
+auto inline CompareL1() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor<DIMENSIONS>::getL1Norm<Kernels>(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+template <typename Kernels>
+auto inline CompareL2() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor<DIMENSIONS>::getL2Norm<Kernels>(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+/*
+ * Every supported kernel set against a double precision scalar reference, for dimensions that leave a tail after
+ * the full vectors of every width (100 = 6 x 16 + 4 and 130 = 8 x 16 + 2), so the masked loads and the scalar
+ * remainder are exercised. A distance counts as a mismatch when it is off by more than a relative 1e-5; the
+ * mismatches of all kernel sets are returned.
+ */
+template <size_t Dims>
+auto inline CheckKernels() -> size_t
+{
+    constexpr size_t numOfPoints{256};
+    constexpr double tolerance{1e-5};
+
+    std::vector<Descriptor<Dims>> const lhs(numOfPoints);
+    std::vector<Descriptor<Dims>> const rhs(numOfPoints);
+
+    size_t total{0};
+
+    auto const check = [&]<typename Kernels> -> void
+    {
+        size_t mismatches{0};
+
+        Kernels::Run([&]<typename> -> void
+        {
+            for (auto const & left : lhs)
+            {
+                for (auto const & right : rhs)
+                {
+                    double l1{0.0};
+                    double l2{0.0};
+
+                    for (size_t dim = 0; dim < Dims; ++dim)
+                    {
+                        auto const diff = static_cast<double>(left[dim]) - static_cast<double>(right[dim]);
+                        l1 += std::abs(diff);
+                        l2 += diff * diff;
+                    }
+
+                    l2 = std::sqrt(l2);
+
+                    mismatches += std::abs(static_cast<double>(Descriptor<Dims>::template getL1Norm<Kernels>(left, right)) - l1) > tolerance * l1;
+                    mismatches += std::abs(static_cast<double>(Descriptor<Dims>::template getL2Norm<Kernels>(left, right)) - l2) > tolerance * l2;
+                }
+            }
+        });
+
+        std::cout << std::format("Kernel mismatches for {}-D ({}) : {} / {}\n", Dims, GetInstructionSetName(Kernels::INSTRUCTION_SET), mismatches,
+                                 2 * numOfPoints * numOfPoints);
+
+        total += mismatches;
+    };
+
+    auto const instructionSet = GetInstructionSet();
+
+    check.template operator()<SSEKernels>();
+
+    if (instructionSet >= InstructionSet::AVX2)
+    {
+        check.template operator()<AVX2Kernels>();
+    }
+
+    if (instructionSet >= InstructionSet::AVX512)
+    {
+        check.template operator()<AVX512Kernels>();
+    }
+
+    return total;
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
 }
\ No newline at end of file
@@ -0,0 +1,533 @@
+/*
+## Query Service
+
+The reference set is loaded once into a QueryService, which then answers top-TOP_K queries for as long as it
+lives. Submit takes a batch of query descriptors and returns either a std::future or calls a callback with one
+TopK list per query, so many clients can have queries in flight at the same time.
+
+A single worker thread micro-batches the requests: once a request arrives it waits at most the batch window for
+more, or until MAX_BATCH queries are queued, and then searches all of them together with the tiled kernel. The
+reference set is walked in tiles of REFERENCE_TILE descriptors and every tile is scored against the whole batch
+while it is in L2, so a larger batch reads the reference set fewer times per query. The window trades latency for
+that reuse.
+
+All of set1 is answered through the service first, to check the checksums against the standalone search. A closed
+loop load generator then runs CLIENT_COUNTS clients, each submitting REQUEST_SIZE queries and waiting for the
+answer before sending the next, and reports throughput, mean batch size and p50/p99 latency for every window in
+BATCH_WINDOWS. With fewer clients than MAX_BATCH the window only adds latency, since the queries that queue up
+while a batch is searched already form the next one.
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <vector>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    TOP_K = 10,
+    MAX_BATCH = 32,
+    REFERENCE_TILE = 512,
+    CHECK_REQUEST_SIZE = 100,
+    REQUEST_SIZE = 1,
+};
+
+static constexpr std::chrono::microseconds BATCH_WINDOWS[]{std::chrono::microseconds{0}, std::chrono::microseconds{250}, std::chrono::microseconds{2'000}};
+static constexpr size_t CLIENT_COUNTS[]{4, 32};
+static constexpr std::chrono::seconds LOAD_DURATION{3};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+enum class Norm : std::uint8_t
+{
+    L1,
+    L2,
+};
+
+
+template <size_t K>
+class TopK
+{
+public:
+    TopK() noexcept
+    {
+        std::fill(distances, distances + K, std::numeric_limits<float>::max());
+        std::fill(indices, indices + K, 0U);
+    }
+
+    /*
+     * Sorted insert without data-dependent branches, ties keep the earlier index in front.
+     */
+    void Insert(float const distance, std::uint32_t const index) noexcept
+    {
+        if (distance >= distances[K - 1])
+        {
+            return;
+        }
+
+#pragma GCC unroll 16
+        for (size_t slot = K - 1; slot > 0; --slot)
+        {
+            bool const shift = distance < distances[slot - 1];
+            bool const place = distance < distances[slot];
+
+            distances[slot] = shift ? distances[slot - 1] : (place ? distance : distances[slot]);
+            indices[slot] = shift ? indices[slot - 1] : (place ? index : indices[slot]);
+        }
+
+        bool const first = distance < distances[0];
+
+        distances[0] = first ? distance : distances[0];
+        indices[0] = first ? index : indices[0];
+    }
+
+    std::uint32_t Index(size_t const rank) const noexcept
+    {
+        return indices[rank];
+    }
+
+private:
+    float distances[K];
+    std::uint32_t indices[K];
+};
+
+using Neighbours = std::vector<TopK<TOP_K>>;
+using Callback = std::function<void(Neighbours)>;
+
+
+/*
+ * Top-k search service over a resident reference set. The reference set must outlive the service, and so must
+ * the queries of a request until its answer arrives.
+ */
+template <Norm Metric>
+class QueryService
+{
+public:
+    QueryService(Descriptor const * const references, size_t const numOfReferences, std::chrono::microseconds const window) :
+        references{references}, numOfReferences{numOfReferences}, window{window}, worker{[this](std::stop_token const & stop) { Run(stop); }}
+    {
+    }
+
+    QueryService(QueryService const &) = delete;
+    QueryService & operator=(QueryService const &) = delete;
+
+    ~QueryService()
+    {
+        worker.request_stop();
+        worker.join();
+    }
+
+    void Submit(Descriptor const * const queries, size_t const numOfQueries, Callback callback)
+    {
+        {
+            std::lock_guard const lock{mutex};
+
+            pending.push_back(Request{queries, numOfQueries, std::move(callback), std::chrono::steady_clock::now()});
+            pendingQueries += numOfQueries;
+        }
+
+        ready.notify_one();
+    }
+
+    std::future<Neighbours> Submit(Descriptor const * const queries, size_t const numOfQueries)
+    {
+        auto promise = std::make_shared<std::promise<Neighbours>>();
+        auto future = promise->get_future();
+
+        Submit(queries, numOfQueries, [promise](Neighbours neighbours) { promise->set_value(std::move(neighbours)); });
+
+        return future;
+    }
+
+    /*
+     * Number of batches searched and queries answered so far.
+     */
+    std::pair<size_t, size_t> Statistics() const noexcept
+    {
+        return {numOfBatches.load(), numOfAnswered.load()};
+    }
+
+private:
+    struct Request
+    {
+        Descriptor const * queries;
+        size_t numOfQueries;
+        Callback callback;
+        std::chrono::steady_clock::time_point arrival;
+    };
+
+    /*
+     * Waits for the first request, then for the window to close or the batch to fill, and takes whole requests
+     * up to MAX_BATCH queries (always at least one request, however large).
+     */
+    void Run(std::stop_token const & stop)
+    {
+        std::vector<Request> batch;
+        std::unique_lock lock{mutex};
+
+        while (true)
+        {
+            if (!ready.wait(lock, stop, [this] { return !pending.empty(); }))
+            {
+                return;
+            }
+
+            ready.wait_until(lock, stop, pending.front().arrival + window, [this] { return pendingQueries >= MAX_BATCH; });
+
+            size_t numOfQueries{0};
+
+            while (!pending.empty() && (batch.empty() || numOfQueries + pending.front().numOfQueries <= MAX_BATCH))
+            {
+                numOfQueries += pending.front().numOfQueries;
+                batch.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
+
+            pendingQueries -= numOfQueries;
+
+            lock.unlock();
+            Search(batch, numOfQueries);
+            batch.clear();
+            lock.lock();
+        }
+    }
+
+    void Search(std::vector<Request> & batch, size_t const numOfQueries)
+    {
+        std::vector<Descriptor const *> queries;
+        Neighbours neighbours(numOfQueries);
+
+        queries.reserve(numOfQueries);
+
+        for (auto const & request : batch)
+        {
+            for (size_t idx = 0; idx < request.numOfQueries; ++idx)
+            {
+                queries.push_back(request.queries + idx);
+            }
+        }
+
+        for (size_t tile = 0; tile < numOfReferences; tile += REFERENCE_TILE)
+        {
+            auto const tileEnd = std::min<size_t>(tile + REFERENCE_TILE, numOfReferences);
+
+            for (size_t idx1 = 0; idx1 < numOfQueries; ++idx1)
+            {
+                auto const & query = *queries[idx1];
+                auto & top = neighbours[idx1];
+
+                for (size_t idx2 = tile; idx2 < tileEnd; ++idx2)
+                {
+                    float const currentDistance = Metric == Norm::L2 ? Descriptor::getL2Norm(query, references[idx2]) : Descriptor::getL1Norm(query, references[idx2]);
+                    top.Insert(currentDistance, static_cast<std::uint32_t>(idx2));
+                }
+            }
+        }
+
+        ++numOfBatches;
+        numOfAnswered += numOfQueries;
+
+        auto answer = neighbours.begin();
+
+        for (auto & request : batch)
+        {
+            request.callback(Neighbours(answer, answer + static_cast<std::ptrdiff_t>(request.numOfQueries)));
+            answer += static_cast<std::ptrdiff_t>(request.numOfQueries);
+        }
+    }
+
+    Descriptor const * const references;
+    size_t const numOfReferences;
+    std::chrono::microseconds const window;
+
+    std::mutex mutex;
+    std::condition_variable_any ready;
+    std::deque<Request> pending;
+    size_t pendingQueries{0};
+
+    std::atomic<size_t> numOfBatches{0};
+    std::atomic<size_t> numOfAnswered{0};
+
+    std::jthread worker;
+};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+
+template <Norm Metric>
+auto inline AnswerAll(size_t * const indices) -> void;
+auto inline RunLoad(size_t const numOfClients, std::chrono::microseconds const window) -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    std::cout << "Starting Answering L1 Norm\n";
+    TestSpeed([] { AnswerAll<Norm::L1>(indicesL1); }, "AnswerL1");
+
+    ComputeChecksum(indicesL1, "L1 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Answering L2 Norm\n";
+    TestSpeed([] { AnswerAll<Norm::L2>(indicesL2); }, "AnswerL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    for (auto const numOfClients : CLIENT_COUNTS)
+    {
+        for (auto const window : BATCH_WINDOWS)
+        {
+            Cooldown();
+
+            RunLoad(numOfClients, window);
+        }
+    }
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+/*
+ * All of set1 in requests of CHECK_REQUEST_SIZE queries, submitted at once and collected through the futures.
+ */
+template <Norm Metric>
+auto inline AnswerAll(size_t * const indices) -> void
+{
+    QueryService<Metric> service{set2, NUM_OF_POINTS, BATCH_WINDOWS[0]};
+    std::vector<std::future<Neighbours>> answers;
+
+    for (size_t first = 0; first < NUM_OF_POINTS; first += CHECK_REQUEST_SIZE)
+    {
+        answers.push_back(service.Submit(set1 + first, std::min<size_t>(CHECK_REQUEST_SIZE, NUM_OF_POINTS - first)));
+    }
+
+    for (size_t request = 0; request < answers.size(); ++request)
+    {
+        auto const neighbours = answers[request].get();
+        std::transform(neighbours.begin(), neighbours.end(), indices + request * CHECK_REQUEST_SIZE, [](auto const & top) { return top.Index(0); });
+    }
+}
+
+/*
+ * Closed loop: every client waits for its answer before submitting its next request, so the offered load follows
+ * the service. Latency is measured from Submit to the answer.
+ */
+auto inline RunLoad(size_t const numOfClients, std::chrono::microseconds const window) -> void
+{
+    QueryService<Norm::L2> service{set2, NUM_OF_POINTS, window};
+    std::vector<std::vector<double>> latencies(numOfClients);
+
+    std::cout << std::format("Starting Load (window {} us, {} clients)\n", window.count(), numOfClients);
+
+    auto const start = std::chrono::steady_clock::now();
+    auto const end = start + LOAD_DURATION;
+
+    {
+        std::vector<std::jthread> clients;
+
+        for (size_t client = 0; client < numOfClients; ++client)
+        {
+            clients.emplace_back([&service, &latencies, client, numOfClients, end]
+            {
+                size_t next = client * NUM_OF_POINTS / numOfClients;
+
+                while (std::chrono::steady_clock::now() < end)
+                {
+                    auto const submitted = std::chrono::steady_clock::now();
+                    service.Submit(set1 + next, REQUEST_SIZE).get();
+                    auto const answered = std::chrono::steady_clock::now();
+
+                    latencies[client].push_back(std::chrono::duration<double, std::micro>(answered - submitted).count());
+                    next = (next + REQUEST_SIZE) % (NUM_OF_POINTS - REQUEST_SIZE + 1);
+                }
+            });
+        }
+    }
+
+    auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto const [numOfBatches, numOfAnswered] = service.Statistics();
+
+    std::vector<double> all;
+
+    for (auto const & client : latencies)
+    {
+        all.insert(all.end(), client.begin(), client.end());
+    }
+
+    auto const percentile = [&all](double const fraction) -> double
+    {
+        if (all.empty())
+        {
+            return std::numeric_limits<double>::quiet_NaN(); /* No query was answered, so there is no latency to rank */
+        }
+
+        auto const rank = all.begin() + static_cast<std::ptrdiff_t>(fraction * static_cast<double>(all.size() - 1));
+        std::nth_element(all.begin(), rank, all.end());
+        return *rank;
+    };
+
+    std::cout << std::format("Throughput : {:.0f} queries/s, mean batch {:.1f} queries\n", static_cast<double>(numOfAnswered) / elapsed,
+                             static_cast<double>(numOfAnswered) / static_cast<double>(std::max<size_t>(numOfBatches, 1)));
+    std::cout << std::format("Latency : p50 {:.0f} us, p99 {:.0f} us\n", percentile(0.50), percentile(0.99));
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -0,0 +1,672 @@
+/*
+## Sharded Search
+
+The reference set is split into contiguous shards, each owned by a worker process that keeps only its slice.
+The coordinator talks to every worker through a POSIX shared-memory channel, standing in for a network link.
+A channel holds two single-producer rings of RING_SLOTS slots: requests carrying QUERY_BATCH queries, and
+responses carrying one partial top-TOP_K list per query. Process-shared semaphores count the free and filled
+slots, so both sides sleep instead of spinning while they wait.
+
+Each batch is broadcast to all shards. The coordinator keeps PIPELINE_DEPTH batches in flight. For every answered
+batch it merges the partial lists in shard order, so on ties the lower global index still wins, as in the
+single-process search.
+
+The merged results are checked against the checksums with MAX_SHARDS shards. The L2 search is then timed with 1
+to MAX_SHARDS shards. Scaling efficiency is the one-shard time over N times the N-shard time. The mean time of
+each stage per batch is also reported: sending, compute on the slowest shard, merging, and end to end. Efficiency
+cannot exceed the share of the host's cores the shards get.
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+#include <immintrin.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    TOP_K = 10,
+    QUERY_BATCH = 64,
+    RING_SLOTS = 4,
+    PIPELINE_DEPTH = RING_SLOTS,
+    MAX_SHARDS = 8,
+};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+enum class Norm : std::uint8_t
+{
+    L1,
+    L2,
+};
+
+
+template <size_t K>
+class TopK
+{
+public:
+    void Reset() noexcept
+    {
+        std::fill(distances, distances + K, std::numeric_limits<float>::max());
+        std::fill(indices, indices + K, 0U);
+    }
+
+    /*
+     * Sorted insert without data-dependent branches, ties keep the earlier index in front.
+     */
+    void Insert(float const distance, std::uint32_t const index) noexcept
+    {
+        if (distance >= distances[K - 1])
+        {
+            return;
+        }
+
+#pragma GCC unroll 16
+        for (size_t slot = K - 1; slot > 0; --slot)
+        {
+            bool const shift = distance < distances[slot - 1];
+            bool const place = distance < distances[slot];
+
+            distances[slot] = shift ? distances[slot - 1] : (place ? distance : distances[slot]);
+            indices[slot] = shift ? indices[slot - 1] : (place ? index : indices[slot]);
+        }
+
+        bool const first = distance < distances[0];
+
+        distances[0] = first ? distance : distances[0];
+        indices[0] = first ? index : indices[0];
+    }
+
+    float Distance(size_t const rank) const noexcept
+    {
+        return distances[rank];
+    }
+
+    std::uint32_t Index(size_t const rank) const noexcept
+    {
+        return indices[rank];
+    }
+
+private:
+    float distances[K];
+    std::uint32_t indices[K];
+};
+
+
+/*
+ * Queries travel as raw bytes, since constructing a Descriptor draws from the generator.
+ */
+struct RequestSlot
+{
+    std::uint64_t batch;
+    std::uint32_t count;
+    alignas(ALIGN) std::byte queries[QUERY_BATCH * sizeof(Descriptor)];
+};
+
+struct ResponseSlot
+{
+    std::uint64_t batch;
+    std::uint32_t count;
+    double computeSeconds;
+    TopK<TOP_K> partials[QUERY_BATCH];
+};
+
+/*
+ * Single-producer single-consumer ring in shared memory. Each side owns its own cursor, and the semaphores
+ * both count the slots and order the slot contents between the processes.
+ */
+template <typename Slot>
+struct Ring
+{
+    void Initialize()
+    {
+        if (sem_init(&free, 1, RING_SLOTS) != 0 || sem_init(&filled, 1, 0) != 0)
+        {
+            throw std::runtime_error{std::format("Failed to initialize the ring semaphores: {}", std::strerror(errno))};
+        }
+
+        head = 0;
+        tail = 0;
+    }
+
+    void Destroy() noexcept
+    {
+        sem_destroy(&free);
+        sem_destroy(&filled);
+    }
+
+    Slot & BeginWrite() noexcept
+    {
+        Wait(free);
+        return slots[head % RING_SLOTS];
+    }
+
+    void EndWrite() noexcept
+    {
+        ++head;
+        sem_post(&filled);
+    }
+
+    Slot const & BeginRead() noexcept
+    {
+        Wait(filled);
+        return slots[tail % RING_SLOTS];
+    }
+
+    void EndRead() noexcept
+    {
+        ++tail;
+        sem_post(&free);
+    }
+
+private:
+    static void Wait(sem_t & semaphore) noexcept
+    {
+        while (sem_wait(&semaphore) != 0 && errno == EINTR)
+        {
+        }
+    }
+
+    sem_t free;
+    sem_t filled;
+    std::uint64_t head;
+    std::uint64_t tail;
+    Slot slots[RING_SLOTS];
+};
+
+struct ShardChannel
+{
+    Ring<RequestSlot> requests;
+    Ring<ResponseSlot> responses;
+};
+
+struct StageTimes
+{
+    double send{0.0};
+    double compute{0.0};
+    double merge{0.0};
+    double endToEnd{0.0};
+};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+
+/*
+ * Coordinator side of a sharded search: forks one worker per shard on construction and stops them on
+ * destruction. The channels are unlinked as soon as they are mapped, so nothing is left behind in /dev/shm.
+ */
+template <Norm Metric>
+class ShardedSearch
+{
+public:
+    explicit ShardedSearch(size_t const numOfShards)
+    {
+        for (size_t shard = 0; shard < numOfShards; ++shard)
+        {
+            auto const name = std::format("/pao-shard-{}-{}", getpid(), shard);
+            auto const descriptor = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+
+            if (descriptor < 0)
+            {
+                Stop();
+                throw std::runtime_error{std::format("Failed to create shared memory {}: {}", name, std::strerror(errno))};
+            }
+
+            void * address = MAP_FAILED;
+
+            if (ftruncate(descriptor, sizeof(ShardChannel)) == 0)
+            {
+                address = mmap(nullptr, sizeof(ShardChannel), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+            }
+
+            shm_unlink(name.c_str());
+            close(descriptor);
+
+            if (address == MAP_FAILED)
+            {
+                Stop();
+                throw std::runtime_error{std::format("Failed to map shared memory {}: {}", name, std::strerror(errno))};
+            }
+
+            auto * const channel = static_cast<ShardChannel *>(address);
+
+            channel->requests.Initialize();
+            channel->responses.Initialize();
+            channels.push_back(channel);
+        }
+
+        /* The children would otherwise inherit and flush the buffered output again */
+        std::cout.flush();
+
+        for (size_t shard = 0; shard < numOfShards; ++shard)
+        {
+            auto const pid = fork();
+
+            if (pid < 0)
+            {
+                Stop();
+                throw std::runtime_error{std::format("Failed to fork shard {}: {}", shard, std::strerror(errno))};
+            }
+
+            if (pid == 0)
+            {
+                RunWorker(*channels[shard], shard * NUM_OF_POINTS / numOfShards, (shard + 1) * NUM_OF_POINTS / numOfShards);
+                _exit(EXIT_SUCCESS);
+            }
+
+            workers.push_back(pid);
+        }
+    }
+
+    ShardedSearch(ShardedSearch const &) = delete;
+    ShardedSearch & operator=(ShardedSearch const &) = delete;
+
+    ~ShardedSearch()
+    {
+        Stop();
+    }
+
+    /*
+     * Top-1 of every query of set1 into indices, with the summed stage times of all batches.
+     */
+    StageTimes Search(size_t * const indices)
+    {
+        constexpr size_t numOfBatches = (NUM_OF_POINTS + QUERY_BATCH - 1) / QUERY_BATCH;
+
+        StageTimes times;
+        std::vector<std::chrono::steady_clock::time_point> sent(numOfBatches);
+
+        for (size_t batch = 0; batch < numOfBatches + PIPELINE_DEPTH - 1; ++batch)
+        {
+            if (batch < numOfBatches)
+            {
+                sent[batch] = std::chrono::steady_clock::now();
+                Send(batch);
+                times.send += Since(sent[batch]);
+            }
+
+            if (batch >= PIPELINE_DEPTH - 1)
+            {
+                auto const answered = batch - (PIPELINE_DEPTH - 1);
+
+                times.compute += Receive(answered, indices, times.merge);
+                times.endToEnd += Since(sent[answered]);
+            }
+        }
+
+        return times;
+    }
+
+private:
+    /*
+     * Scores every query of a request against the slice [begin, end) of set2 until the empty stop request.
+     */
+    static void RunWorker(ShardChannel & channel, size_t const begin, size_t const end)
+    {
+        std::vector<Descriptor> const slice(set2 + begin, set2 + end);
+
+        while (true)
+        {
+            auto const & request = channel.requests.BeginRead();
+
+            if (request.count == 0)
+            {
+                channel.requests.EndRead();
+                return;
+            }
+
+            auto & response = channel.responses.BeginWrite();
+            auto const * const queries = reinterpret_cast<Descriptor const *>(request.queries);
+            auto const start = std::chrono::steady_clock::now();
+
+            for (size_t idx1 = 0; idx1 < request.count; ++idx1)
+            {
+                auto & top = response.partials[idx1];
+                top.Reset();
+
+                for (size_t idx2 = 0; idx2 < slice.size(); ++idx2)
+                {
+                    float const currentDistance = Metric == Norm::L2 ? Descriptor::getL2Norm(queries[idx1], slice[idx2]) : Descriptor::getL1Norm(queries[idx1], slice[idx2]);
+                    top.Insert(currentDistance, static_cast<std::uint32_t>(begin + idx2));
+                }
+            }
+
+            response.batch = request.batch;
+            response.count = request.count;
+            response.computeSeconds = Since(start);
+
+            channel.requests.EndRead();
+            channel.responses.EndWrite();
+        }
+    }
+
+    void Send(size_t const batch) noexcept
+    {
+        auto const first = batch * QUERY_BATCH;
+        auto const count = std::min<size_t>(QUERY_BATCH, NUM_OF_POINTS - first);
+
+        for (auto * const channel : channels)
+        {
+            auto & request = channel->requests.BeginWrite();
+
+            request.batch = batch;
+            request.count = static_cast<std::uint32_t>(count);
+            std::memcpy(request.queries, set1 + first, count * sizeof(Descriptor));
+
+            channel->requests.EndWrite();
+        }
+    }
+
+    /*
+     * Waits for the partial lists of a batch from every shard and merges them. Returns the compute time of the
+     * slowest shard.
+     */
+    double Receive(size_t const batch, size_t * const indices, double & mergeSeconds) noexcept
+    {
+        auto const first = batch * QUERY_BATCH;
+        auto const count = std::min<size_t>(QUERY_BATCH, NUM_OF_POINTS - first);
+
+        std::vector<ResponseSlot const *> responses;
+        double slowest{0.0};
+
+        for (auto * const channel : channels)
+        {
+            responses.push_back(&channel->responses.BeginRead());
+            slowest = std::max(slowest, responses.back()->computeSeconds);
+        }
+
+        auto const start = std::chrono::steady_clock::now();
+
+        for (size_t idx = 0; idx < count; ++idx)
+        {
+            TopK<TOP_K> merged;
+            merged.Reset();
+
+            for (auto const * const response : responses)
+            {
+                for (size_t rank = 0; rank < TOP_K; ++rank)
+                {
+                    merged.Insert(response->partials[idx].Distance(rank), response->partials[idx].Index(rank));
+                }
+            }
+
+            indices[first + idx] = merged.Index(0);
+        }
+
+        mergeSeconds += Since(start);
+
+        for (auto * const channel : channels)
+        {
+            channel->responses.EndRead();
+        }
+
+        return slowest;
+    }
+
+    void Stop() noexcept
+    {
+        for (size_t shard = 0; shard < workers.size(); ++shard)
+        {
+            auto & request = channels[shard]->requests.BeginWrite();
+            request.count = 0;
+            channels[shard]->requests.EndWrite();
+        }
+
+        for (auto const worker : workers)
+        {
+            waitpid(worker, nullptr, 0);
+        }
+
+        for (auto * const channel : channels)
+        {
+            channel->requests.Destroy();
+            channel->responses.Destroy();
+            munmap(channel, sizeof(ShardChannel));
+        }
+
+        workers.clear();
+        channels.clear();
+    }
+
+    static double Since(std::chrono::steady_clock::time_point const start) noexcept
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::vector<ShardChannel *> channels;
+    std::vector<pid_t> workers;
+};
+
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> double;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+
+auto inline TestScaling() -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    try
+    {
+        {
+            ShardedSearch<Norm::L1> search{MAX_SHARDS};
+
+            std::cout << std::format("Starting Comparing L1 Norm ({} shards)\n", static_cast<size_t>(MAX_SHARDS));
+            TestSpeed([&] { search.Search(indicesL1); }, "CompareL1");
+
+            ComputeChecksum(indicesL1, "L1 Norm");
+        }
+
+        Cooldown();
+
+        {
+            ShardedSearch<Norm::L2> search{MAX_SHARDS};
+
+            std::cout << std::format("Starting Comparing L2 Norm ({} shards)\n", static_cast<size_t>(MAX_SHARDS));
+            TestSpeed([&] { search.Search(indicesL2); }, "CompareL2");
+
+            ComputeChecksum(indicesL2, "L2 Norm");
+        }
+
+        TestScaling();
+    }
+    catch (std::exception const & exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> double
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+/*
+ * L2 search with a doubling number of shards. The workers are started before the clock starts.
+ */
+auto inline TestScaling() -> void
+{
+    constexpr double numOfBatches = (NUM_OF_POINTS + QUERY_BATCH - 1) / QUERY_BATCH;
+
+    double baseline{0.0};
+
+    std::cout << std::format("Host cores : {}\n", std::thread::hardware_concurrency());
+
+    for (size_t numOfShards = 1; numOfShards <= MAX_SHARDS; numOfShards *= 2)
+    {
+        Cooldown();
+
+        ShardedSearch<Norm::L2> search{numOfShards};
+        StageTimes times;
+
+        std::cout << std::format("Starting Comparing L2 Norm ({} shards)\n", numOfShards);
+        auto const seconds = TestSpeed([&] { times = search.Search(indicesL2); }, std::format("CompareL2 ({} shards)", numOfShards));
+
+        baseline = numOfShards == 1 ? seconds : baseline;
+
+        std::cout << std::format("Speedup : {:.2f}x, efficiency {:.1f} %\n", baseline / seconds, 100.0 * baseline / (static_cast<double>(numOfShards) * seconds));
+        std::cout << std::format("Stages per batch : send {:.0f} us, compute {:.0f} us, merge {:.0f} us, end to end {:.0f} us\n", times.send / numOfBatches * 1e6,
+                                 times.compute / numOfBatches * 1e6, times.merge / numOfBatches * 1e6, times.endToEnd / numOfBatches * 1e6);
+    }
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -0,0 +1,467 @@
+/*
+## Blocked SoA Layout
+
+The pairwise kernels compute one distance per call and finish each with the REDUCE_SUM horizontal
+reduction. Here the reference set is repacked once into blocks of 8 descriptors interleaved per dimension
+([block][dim][8]), so a broadcast query component against one aligned load yields 8 partial distances with
+plain vertical adds. Two blocks (16 references) are scored against four queries per pass, so every reference
+row loaded is reused four times and the eight accumulators hide the add latency.
+
+The argmin is kept per lane with _mm256_cmp_ps/_mm256_blendv_ps, so no horizontal work runs per pair. The
+16 lane winners of each query are re-ranked with the pairwise kernel at the end, which keeps the checksum
+identical to the array-of-structs search despite the different summation order.
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <new>
+
+#include <immintrin.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+#define L1_VERTICAL(ROW)              query = _mm256_broadcast_ss(features##ROW + dim);                  /* Broadcast one query component */       \
+                                      diff = _mm256_sub_ps(query, right0);                               /* Query minus the first 8 references */  \
+                                      acc##ROW##0 = _mm256_add_ps(acc##ROW##0, _mm256_andnot_ps(signMask, diff));                                 \
+                                      diff = _mm256_sub_ps(query, right1);                               /* Query minus the second 8 references */ \
+                                      acc##ROW##1 = _mm256_add_ps(acc##ROW##1, _mm256_andnot_ps(signMask, diff));
+
+#define L2_VERTICAL(ROW)              query = _mm256_broadcast_ss(features##ROW + dim);                  /* Broadcast one query component */       \
+                                      diff = _mm256_sub_ps(query, right0);                               /* Query minus the first 8 references */  \
+                                      acc##ROW##0 = _mm256_fmadd_ps(diff, diff, acc##ROW##0);                                                     \
+                                      diff = _mm256_sub_ps(query, right1);                               /* Query minus the second 8 references */ \
+                                      acc##ROW##1 = _mm256_fmadd_ps(diff, diff, acc##ROW##1);
+
+#define ARGMIN_LANES(ROW, HALF)       mask = _mm256_cmp_ps(acc##ROW##HALF, best[ROW][HALF], _CMP_LT_OQ);                            /* Lanes that improved */       \
+                                      best[ROW][HALF] = _mm256_blendv_ps(best[ROW][HALF], acc##ROW##HALF, mask);                     /* Keep the smaller distance */ \
+                                      index[ROW][HALF] = _mm256_blendv_ps(index[ROW][HALF], _mm256_castsi256_ps(current##HALF), mask); /* Keep the matching index */
+
+#define ARGMIN_ROW(ROW)               ARGMIN_LANES(ROW, 0) \
+                                      ARGMIN_LANES(ROW, 1)
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    BLOCK_SIZE = FLOAT_VECTOR_SIZE,
+    BLOCKS_PER_PASS = 2,
+    QUERIES_PER_PASS = 4,
+    NUM_OF_BLOCKS = (NUM_OF_POINTS + BLOCK_SIZE * BLOCKS_PER_PASS - 1) / (BLOCK_SIZE * BLOCKS_PER_PASS) * BLOCKS_PER_PASS,
+};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+/*
+ * Reference set in blocked SoA form: block b holds descriptors 8b..8b+7, one row of 8 floats per dimension.
+ * Padding lanes are filled with infinity so their distance is never a new minimum.
+ */
+using DescriptorBlock = float[Descriptor::DIMENSIONS][BLOCK_SIZE];
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+alignas(ALIGN) Descriptor set2[NUM_OF_POINTS];
+
+alignas(ALIGN) DescriptorBlock blocks2[NUM_OF_BLOCKS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesVerticalL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesVerticalL2[NUM_OF_POINTS];
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void;
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, std::string_view const message) noexcept -> void;
+
+auto inline CompareL1() noexcept -> void;
+auto inline CompareL2() noexcept -> void;
+
+auto inline Repack() noexcept -> void;
+auto inline CompareVerticalL1() noexcept -> void;
+auto inline CompareVerticalL2() noexcept -> void;
+
+template <typename Norm>
+auto inline Rerank(size_t const idx1, __m256 const * const candidates, size_t * const indices, Norm const & norm) noexcept -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    std::cout << "Starting Comparing L1 Norm\n";
+    TestSpeed(CompareL1, "CompareL1");
+
+    ComputeChecksum(indicesL1, "L1 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm\n";
+    TestSpeed(CompareL2, "CompareL2");
+
+    ComputeChecksum(indicesL2, "L2 Norm");
+
+    Cooldown();
+
+    std::cout << "Starting Repacking Reference Set\n";
+    TestSpeed(Repack, "Repack");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L1 Norm (Vertical)\n";
+    TestSpeed(CompareVerticalL1, "CompareVerticalL1");
+
+    ComputeChecksum(indicesVerticalL1, "L1 Norm (Vertical)");
+    CountMismatches(indicesL1, indicesVerticalL1, "L1 Norm (Vertical)");
+
+    Cooldown();
+
+    std::cout << "Starting Comparing L2 Norm (Vertical)\n";
+    TestSpeed(CompareVerticalL2, "CompareVerticalL2");
+
+    ComputeChecksum(indicesVerticalL2, "L2 Norm (Vertical)");
+    CountMismatches(indicesL2, indicesVerticalL2, "L2 Norm (Vertical)");
+
+    return 0;
+}
+
+auto inline TestSpeed(std::function<void()> const & function, std::string_view const message) noexcept -> void
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    function();
+    auto const stop = std::chrono::high_resolution_clock::now();
+
+    auto const difference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    auto const time_ms = difference_ms.count();
+
+    std::cout << "Time taken for " << message << " : " << time_ms << " ms\n";
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+auto inline CountMismatches(size_t const * const lhs, size_t const * const rhs, std::string_view const message) noexcept -> void
+{
+    auto const mismatches = std::transform_reduce(lhs, lhs + NUM_OF_POINTS, rhs, 0UL, std::plus<>(), std::not_equal_to<>());
+    std::cout << std::format("Mismatches for {} : {} / {}\n", message, mismatches, static_cast<size_t>(NUM_OF_POINTS));
+}
+
+
+auto inline CompareL1() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL1Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL1[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline CompareL2() noexcept -> void
+{
+    float minDistance{0.0};
+    float currentDistance{0.0};
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; ++idx1)
+    {
+        minDistance = std::numeric_limits<float>::max();
+
+        for (size_t idx2 = 0; idx2 < NUM_OF_POINTS; ++idx2)
+        {
+            currentDistance = Descriptor::getL2Norm(set1[idx1], set2[idx2]);
+
+            if (currentDistance < minDistance)
+            {
+                minDistance = currentDistance;
+                indicesL2[idx1] = idx2;
+            }
+        }
+    }
+}
+
+auto inline Repack() noexcept -> void
+{
+    for (size_t idx = 0; idx < NUM_OF_BLOCKS * BLOCK_SIZE; ++idx)
+    {
+        for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+        {
+            blocks2[idx / BLOCK_SIZE][dim][idx % BLOCK_SIZE] = idx < NUM_OF_POINTS ? set2[idx][dim] : std::numeric_limits<float>::infinity();
+        }
+    }
+}
+
+auto inline CompareVerticalL1() noexcept -> void
+{
+    __m256 const signMask = _mm256_set1_ps(-0.0F);
+    __m256i const step = _mm256_set1_epi32(BLOCK_SIZE * BLOCKS_PER_PASS);
+
+    __m256 right0, right1, query, diff, mask;
+
+    alignas(ALIGN) __m256 best[QUERIES_PER_PASS][BLOCKS_PER_PASS];
+    alignas(ALIGN) __m256 index[QUERIES_PER_PASS][BLOCKS_PER_PASS];
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; idx1 += QUERIES_PER_PASS)
+    {
+        float const * const features0 = &set1[idx1][0];
+        float const * const features1 = &set1[std::min(idx1 + 1, NUM_OF_POINTS - 1UL)][0];
+        float const * const features2 = &set1[std::min(idx1 + 2, NUM_OF_POINTS - 1UL)][0];
+        float const * const features3 = &set1[std::min(idx1 + 3, NUM_OF_POINTS - 1UL)][0];
+
+        std::fill_n(&best[0][0], QUERIES_PER_PASS * BLOCKS_PER_PASS, _mm256_set1_ps(std::numeric_limits<float>::max()));
+        std::fill_n(&index[0][0], QUERIES_PER_PASS * BLOCKS_PER_PASS, _mm256_setzero_ps());
+
+        __m256i current0 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i current1 = _mm256_add_epi32(current0, _mm256_set1_epi32(BLOCK_SIZE));
+
+        for (size_t block = 0; block < NUM_OF_BLOCKS; block += BLOCKS_PER_PASS)
+        {
+            DescriptorBlock const & block0 = blocks2[block];
+            DescriptorBlock const & block1 = blocks2[block + 1];
+
+            __m256 acc00 = _mm256_setzero_ps(), acc01 = _mm256_setzero_ps();
+            __m256 acc10 = _mm256_setzero_ps(), acc11 = _mm256_setzero_ps();
+            __m256 acc20 = _mm256_setzero_ps(), acc21 = _mm256_setzero_ps();
+            __m256 acc30 = _mm256_setzero_ps(), acc31 = _mm256_setzero_ps();
+
+            for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+            {
+                right0 = _mm256_load_ps(block0[dim]);
+                right1 = _mm256_load_ps(block1[dim]);
+
+                L1_VERTICAL(0);
+                L1_VERTICAL(1);
+                L1_VERTICAL(2);
+                L1_VERTICAL(3);
+            }
+
+            ARGMIN_ROW(0);
+            ARGMIN_ROW(1);
+            ARGMIN_ROW(2);
+            ARGMIN_ROW(3);
+
+            current0 = _mm256_add_epi32(current0, step);
+            current1 = _mm256_add_epi32(current1, step);
+        }
+
+        for (size_t row = 0; row < QUERIES_PER_PASS && idx1 + row < NUM_OF_POINTS; ++row)
+        {
+            Rerank(idx1 + row, index[row], indicesVerticalL1, Descriptor::getL1Norm);
+        }
+    }
+}
+
+auto inline CompareVerticalL2() noexcept -> void
+{
+    __m256i const step = _mm256_set1_epi32(BLOCK_SIZE * BLOCKS_PER_PASS);
+
+    __m256 right0, right1, query, diff, mask;
+
+    alignas(ALIGN) __m256 best[QUERIES_PER_PASS][BLOCKS_PER_PASS];
+    alignas(ALIGN) __m256 index[QUERIES_PER_PASS][BLOCKS_PER_PASS];
+
+    for (size_t idx1 = 0; idx1 < NUM_OF_POINTS; idx1 += QUERIES_PER_PASS)
+    {
+        float const * const features0 = &set1[idx1][0];
+        float const * const features1 = &set1[std::min(idx1 + 1, NUM_OF_POINTS - 1UL)][0];
+        float const * const features2 = &set1[std::min(idx1 + 2, NUM_OF_POINTS - 1UL)][0];
+        float const * const features3 = &set1[std::min(idx1 + 3, NUM_OF_POINTS - 1UL)][0];
+
+        std::fill_n(&best[0][0], QUERIES_PER_PASS * BLOCKS_PER_PASS, _mm256_set1_ps(std::numeric_limits<float>::max()));
+        std::fill_n(&index[0][0], QUERIES_PER_PASS * BLOCKS_PER_PASS, _mm256_setzero_ps());
+
+        __m256i current0 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i current1 = _mm256_add_epi32(current0, _mm256_set1_epi32(BLOCK_SIZE));
+
+        for (size_t block = 0; block < NUM_OF_BLOCKS; block += BLOCKS_PER_PASS)
+        {
+            DescriptorBlock const & block0 = blocks2[block];
+            DescriptorBlock const & block1 = blocks2[block + 1];
+
+            __m256 acc00 = _mm256_setzero_ps(), acc01 = _mm256_setzero_ps();
+            __m256 acc10 = _mm256_setzero_ps(), acc11 = _mm256_setzero_ps();
+            __m256 acc20 = _mm256_setzero_ps(), acc21 = _mm256_setzero_ps();
+            __m256 acc30 = _mm256_setzero_ps(), acc31 = _mm256_setzero_ps();
+
+            for (size_t dim = 0; dim < Descriptor::DIMENSIONS; ++dim)
+            {
+                right0 = _mm256_load_ps(block0[dim]);
+                right1 = _mm256_load_ps(block1[dim]);
+
+                L2_VERTICAL(0);
+                L2_VERTICAL(1);
+                L2_VERTICAL(2);
+                L2_VERTICAL(3);
+            }
+
+            ARGMIN_ROW(0);
+            ARGMIN_ROW(1);
+            ARGMIN_ROW(2);
+            ARGMIN_ROW(3);
+
+            current0 = _mm256_add_epi32(current0, step);
+            current1 = _mm256_add_epi32(current1, step);
+        }
+
+        for (size_t row = 0; row < QUERIES_PER_PASS && idx1 + row < NUM_OF_POINTS; ++row)
+        {
+            Rerank(idx1 + row, index[row], indicesVerticalL2, Descriptor::getL2Norm);
+        }
+    }
+}
+
+template <typename Norm>
+auto inline Rerank(size_t const idx1, __m256 const * const candidates, size_t * const indices, Norm const & norm) noexcept -> void
+{
+    alignas(ALIGN) std::int32_t lanes[BLOCK_SIZE * BLOCKS_PER_PASS];
+
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), _mm256_castps_si256(candidates[0]));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes + BLOCK_SIZE), _mm256_castps_si256(candidates[1]));
+
+    float minDistance = std::numeric_limits<float>::max();
+    float currentDistance{0.0};
+
+    for (std::int32_t const lane: lanes)
+    {
+        auto const candidate = static_cast<size_t>(lane);
+        currentDistance = norm(set1[idx1], set2[candidate]);
+
+        if (currentDistance < minDistance || (currentDistance == minDistance && candidate < indices[idx1]))
+        {
+            minDistance = currentDistance;
+            indices[idx1] = candidate;
+        }
+    }
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
@@ -0,0 +1,633 @@
+/*
+## Out-of-Core Streaming
+
+The reference set stays on disk in the dataset container (64-byte header, 64-byte-aligned records) and is
+streamed in blocks of BLOCK_SIZE bytes through a ring of NUM_OF_BUFFERS buffers. A reader thread fills the ring
+with pread while the main thread scores the previous block, and two counting semaphores hand the buffers back
+and forth, so I/O and compute overlap and memory use does not depend on the size of the reference set.
+
+The file is opened with O_DIRECT when the file system allows it, so the page cache does not hide the disk;
+the reads are then widened to whole 4 KiB sectors and the records are found at their 64-byte offset inside the
+buffer. Without O_DIRECT the cached pages of the file are dropped before each pass.
+
+Every query keeps its top-TOP_K list in memory across blocks. Inside a block the references are scored in tiles
+of TILE_SIZE descriptors that stay in L2 while all queries run over them.
+
+The seeded set2 is streamed against all of set1 first, to check the checksums against the in-memory search.
+Then a LARGE_NUM_OF_POINTS reference file is streamed without computing, which measures the disk bandwidth, and
+once per query count in LARGE_NUM_OF_QUERIES. The search throughput is reported as a fraction of that
+bandwidth: close to 100% means the search is I/O bound.
+*/
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <format>
+#include <fstream>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <filesystem>
+#include <semaphore>
+#include <atomic>
+#include <new>
+
+#include <immintrin.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+#define ALIGN    std::hardware_destructive_interference_size
+
+#define REDUCE_SUM(RESULT, VECTOR)    sum128 = _mm_add_ps(_mm256_castps256_ps128(VECTOR), _mm256_extractf128_ps(VECTOR, 1)); /* Add the lower and upper halves of the vector */ \
+                                      hi64 = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1U, 0U, 3U, 2U));                    /* Swap the 64-bit halves of the vector */         \
+                                      sum64 = _mm_add_ps(hi64, sum128);                                                      /* Add the two 64-bit halves of the vector */      \
+                                      hi32 = _mm_shuffle_ps(sum64, sum64, _MM_SHUFFLE(2U, 3U, 0U, 1U));                      /* Swap the 32-bit halves of the vector */         \
+                                      sum32 = _mm_add_ps(sum64, hi32);                                                       /* Add the two 32-bit halves of the vector */      \
+                                      RESULT = _mm_cvtss_f32(sum32);                                                         /* Add the two 32-bit floats to the result */      \
+
+#define L1_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);               /* Load 8 floats from lhs into a vector */                                   \
+                                      right = _mm256_load_ps(RHS.features + IDX);              /* Load 8 floats from rhs into a vector */                                   \
+                                      diff = _mm256_sub_ps(left, right);                       /* Subtract the two vectors */                                               \
+                                      absDiff = _mm256_andnot_ps(_mm256_set1_ps(-0.0F), diff); /* Get the absolute value of the difference (trick to clear the sign bit) */ \
+                                      sum = _mm256_add_ps(sum, absDiff);                       /* Add the absolute differences to the sum */
+
+#define L2_NORM(LHS, RHS, IDX)        left = _mm256_load_ps(LHS.features + IDX);  /* Load 8 floats from lhs into a vector */   \
+                                      right = _mm256_load_ps(RHS.features + IDX); /* Load 8 floats from rhs into a vector */   \
+                                      diff = _mm256_sub_ps(left, right);          /* Subtract the two vectors */               \
+                                      squared = _mm256_mul_ps(diff, diff);        /* Square the difference */                  \
+                                      sum = _mm256_add_ps(sum, squared);          /* Add the squared differences to the sum */
+
+#define ALIGNED_NEW    std::align_val_t(SECTOR_SIZE)
+
+
+enum Constants
+{
+    NUM_OF_POINTS = 10'000UL,
+    SEED = 0xDEADBEEF42UL,
+    FLOAT_VECTOR_SIZE = 8,
+    TOP_K = 10,
+    PAYLOAD_ALIGNMENT = 64,
+    SECTOR_SIZE = 4'096,
+    BLOCK_SIZE = 16UL << 20U,
+    NUM_OF_BUFFERS = 3,
+    TILE_SIZE = 256,
+    LARGE_NUM_OF_POINTS = 2'000'000UL,
+    GENERATE_CHUNK = 8'192,
+    BANDWIDTH_REPETITIONS = 3,
+};
+
+static constexpr size_t LARGE_NUM_OF_QUERIES[]{1, 16, 64, 256};
+
+static constexpr std::uint32_t DATASET_MAGIC{0x54455344U}; /* "DSET" */
+static constexpr std::uint32_t DATASET_VERSION{1U};
+
+static constexpr std::string_view SEEDED_FILE{"../set2.dset"};
+static constexpr std::string_view LARGE_FILE{"../large.dset"};
+
+
+class Descriptor
+{
+public:
+    static constexpr size_t DIMENSIONS = 128;
+
+    Descriptor() noexcept
+    {
+        std::generate(features, features + DIMENSIONS, generator);
+    }
+
+    static float getL1Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, absDiff;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L1_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L1_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return result;
+    }
+
+    static float getL2Norm(Descriptor const & lhs, Descriptor const & rhs) noexcept
+    {
+        __m256 left, right, diff, squared;
+        __m128 sum128, hi64, sum64, hi32, sum32;
+
+        __m256 sum = _mm256_setzero_ps();
+
+        L2_NORM(lhs, rhs, 0 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 1 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 2 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 3 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 4 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 5 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 6 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 7 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 8 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 9 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 10 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 11 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 12 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 13 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 14 * FLOAT_VECTOR_SIZE);
+        L2_NORM(lhs, rhs, 15 * FLOAT_VECTOR_SIZE);
+
+        float result{0.0};
+        REDUCE_SUM(result, sum);
+
+        return std::sqrt(result);
+    }
+
+    float & operator[](size_t const dim) noexcept
+    {
+        return features[dim];
+    }
+
+    float const & operator[](size_t const dim) const noexcept
+    {
+        return features[dim];
+    }
+
+private:
+    static std::mt19937 randomEngine;
+    static std::uniform_real_distribution<float> randomDistribution;
+    static std::function<float()> generator;
+
+    alignas(ALIGN) float features[DIMENSIONS];
+};
+
+std::mt19937 Descriptor::randomEngine{SEED};
+std::uniform_real_distribution<float> Descriptor::randomDistribution{0.0, 1.0};
+std::function<float()> Descriptor::generator = []() -> float { return randomDistribution(randomEngine); };
+
+
+enum class Norm : std::uint8_t
+{
+    L1,
+    L2,
+};
+
+enum class DataType : std::uint32_t
+{
+    FLOAT32 = 0,
+    UINT8 = 1,
+};
+
+struct DatasetHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t dimensions;
+    DataType dtype;
+    std::uint64_t count;
+    std::uint64_t alignment;
+    std::uint64_t payloadOffset;
+    std::uint64_t stride;
+    std::uint8_t reserved[16];
+};
+
+static_assert(sizeof(DatasetHeader) == PAYLOAD_ALIGNMENT, "The payload must start on the first aligned boundary");
+
+
+template <size_t K>
+class TopK
+{
+public:
+    void Reset() noexcept
+    {
+        std::fill(distances, distances + K, std::numeric_limits<float>::max());
+        std::fill(indices, indices + K, 0U);
+    }
+
+    /*
+     * Sorted insert without data-dependent branches, ties keep the earlier index in front.
+     */
+    void Insert(float const distance, std::uint64_t const index) noexcept
+    {
+        if (distance >= distances[K - 1])
+        {
+            return;
+        }
+
+#pragma GCC unroll 16
+        for (size_t slot = K - 1; slot > 0; --slot)
+        {
+            bool const shift = distance < distances[slot - 1];
+            bool const place = distance < distances[slot];
+
+            distances[slot] = shift ? distances[slot - 1] : (place ? distance : distances[slot]);
+            indices[slot] = shift ? indices[slot - 1] : (place ? index : indices[slot]);
+        }
+
+        bool const first = distance < distances[0];
+
+        distances[0] = first ? distance : distances[0];
+        indices[0] = first ? index : indices[0];
+    }
+
+    std::uint64_t Index(size_t const rank) const noexcept
+    {
+        return indices[rank];
+    }
+
+private:
+    float distances[K];
+    std::uint64_t indices[K];
+};
+
+
+/*
+ * One slot of the ring: the aligned buffer and where the records of its block start inside it.
+ */
+struct Slot
+{
+    std::byte * buffer{nullptr};
+    Descriptor const * records{nullptr};
+    size_t first{0};
+    size_t count{0};
+};
+
+struct StreamStatistics
+{
+    size_t bytes;
+    double seconds;
+    bool direct;
+};
+
+
+/*
+ * Streams the records of a dataset file block by block. Run calls the consumer with (records, first index,
+ * count) for every block, on the calling thread, while the next blocks are being read.
+ */
+class ReferenceStream
+{
+public:
+    explicit ReferenceStream(std::string_view const fileName)
+    {
+        direct = true;
+        descriptor = open(fileName.data(), O_RDONLY | O_DIRECT);
+
+        if (descriptor < 0 && errno == EINVAL)
+        {
+            direct = false;
+            descriptor = open(fileName.data(), O_RDONLY);
+        }
+
+        if (descriptor < 0)
+        {
+            throw std::runtime_error{std::format("Failed to open dataset {}: {}", fileName, std::strerror(errno))};
+        }
+
+        for (auto & slot : slots)
+        {
+            slot.buffer = new(ALIGNED_NEW, std::nothrow) std::byte[BLOCK_SIZE + 2 * SECTOR_SIZE];
+
+            if (slot.buffer == nullptr)
+            {
+                Cleanup();
+                throw std::runtime_error{"Failed to allocate memory for the stream buffers"};
+            }
+        }
+
+        if (pread(descriptor, slots[0].buffer, SECTOR_SIZE, 0) < static_cast<ssize_t>(sizeof(DatasetHeader)))
+        {
+            Cleanup();
+            throw std::runtime_error{std::format("Failed to read the header of {}", fileName)};
+        }
+
+        std::memcpy(&header, slots[0].buffer, sizeof(header));
+
+        if (header.magic != DATASET_MAGIC || header.version != DATASET_VERSION || header.dtype != DataType::FLOAT32 || header.dimensions != Descriptor::DIMENSIONS ||
+            header.stride != sizeof(Descriptor) || header.payloadOffset % PAYLOAD_ALIGNMENT != 0)
+        {
+            Cleanup();
+            throw std::runtime_error{std::format("Dataset {} is not a set of {}-D float descriptors", fileName, Descriptor::DIMENSIONS)};
+        }
+    }
+
+    ReferenceStream(ReferenceStream const &) = delete;
+    ReferenceStream & operator=(ReferenceStream const &) = delete;
+
+    ~ReferenceStream()
+    {
+        Cleanup();
+    }
+
+    template <typename Consumer>
+    StreamStatistics Run(Consumer const & consumer)
+    {
+        constexpr size_t recordsPerBlock = BLOCK_SIZE / sizeof(Descriptor);
+        auto const numOfBlocks = (header.count + recordsPerBlock - 1) / recordsPerBlock;
+
+        if (!direct)
+        {
+            /* Cached pages would turn the disk benchmark into a memory copy */
+            posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+            posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+
+        std::counting_semaphore<NUM_OF_BUFFERS> free{NUM_OF_BUFFERS};
+        std::counting_semaphore<NUM_OF_BUFFERS> filled{0};
+        std::atomic<bool> failed{false};
+        std::string error;
+        size_t bytes{0};
+
+        auto const start = std::chrono::high_resolution_clock::now();
+
+        std::jthread reader{[&]
+        {
+            for (size_t block = 0; block < numOfBlocks; ++block)
+            {
+                free.acquire();
+
+                auto & slot = slots[block % NUM_OF_BUFFERS];
+
+                slot.first = block * recordsPerBlock;
+                slot.count = std::min(recordsPerBlock, header.count - slot.first);
+
+                /* Widen the byte range of the records to whole sectors, as O_DIRECT requires */
+                auto const begin = header.payloadOffset + slot.first * sizeof(Descriptor);
+                auto const end = begin + slot.count * sizeof(Descriptor);
+                auto const alignedBegin = begin / SECTOR_SIZE * SECTOR_SIZE;
+                auto const alignedEnd = (end + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE;
+
+                size_t done{0};
+
+                while (alignedBegin + done < end)
+                {
+                    auto const result = pread(descriptor, slot.buffer + done, alignedEnd - alignedBegin - done, static_cast<off_t>(alignedBegin + done));
+
+                    if (result <= 0)
+                    {
+                        /* errno is per thread, so the reason is kept here and reported by the calling thread */
+                        error = result < 0 ? std::strerror(errno) : "unexpected end of file";
+                        failed = true;
+                        break;
+                    }
+
+                    done += static_cast<size_t>(result);
+                }
+
+                bytes += done;
+                slot.records = reinterpret_cast<Descriptor const *>(slot.buffer + (begin - alignedBegin));
+
+                filled.release();
+
+                if (failed)
+                {
+                    return;
+                }
+            }
+        }};
+
+        for (size_t block = 0; block < numOfBlocks; ++block)
+        {
+            filled.acquire();
+
+            if (failed)
+            {
+                break;
+            }
+
+            auto const & slot = slots[block % NUM_OF_BUFFERS];
+            consumer(slot.records, slot.first, slot.count);
+
+            free.release();
+        }
+
+        reader.join();
+
+        if (failed)
+        {
+            throw std::runtime_error{std::format("Failed to read the reference set: {}", error)};
+        }
+
+        auto const stop = std::chrono::high_resolution_clock::now();
+
+        return StreamStatistics{bytes, std::chrono::duration<double>(stop - start).count(), direct};
+    }
+
+    size_t Count() const noexcept
+    {
+        return header.count;
+    }
+
+private:
+    void Cleanup() noexcept
+    {
+        for (auto & slot : slots)
+        {
+            operator delete[](slot.buffer, ALIGNED_NEW, std::nothrow);
+            slot.buffer = nullptr;
+        }
+
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+            descriptor = -1;
+        }
+    }
+
+    int descriptor{-1};
+    bool direct{false};
+    DatasetHeader header{};
+    Slot slots[NUM_OF_BUFFERS];
+};
+
+
+alignas(ALIGN) Descriptor set1[NUM_OF_POINTS];
+
+alignas(ALIGN) size_t indicesL1[NUM_OF_POINTS];
+alignas(ALIGN) size_t indicesL2[NUM_OF_POINTS];
+
+alignas(ALIGN) TopK<TOP_K> neighbours[NUM_OF_POINTS];
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void;
+
+template <Norm Metric>
+auto inline StreamSearch(ReferenceStream & stream, size_t const numOfQueries) -> StreamStatistics;
+auto inline ReportThroughput(StreamStatistics const & statistics, double const bandwidth, std::string_view const message) noexcept -> void;
+
+auto inline WriteDataset(std::string_view const fileName, size_t const count) -> void;
+
+auto inline Cooldown(std::chrono::seconds const & seconds = std::chrono::seconds{5}) -> void;
+
+
+int main()
+{
+    try
+    {
+        std::cout << "Starting Writing Seeded Reference Set\n";
+        WriteDataset(SEEDED_FILE, NUM_OF_POINTS);
+
+        {
+            ReferenceStream stream{SEEDED_FILE};
+
+            std::cout << "Starting Streaming L1 Norm (Seeded)\n";
+            ReportThroughput(StreamSearch<Norm::L1>(stream, NUM_OF_POINTS), 0.0, "L1 Norm (Seeded)");
+
+            std::transform(neighbours, neighbours + NUM_OF_POINTS, indicesL1, [](auto const & top) { return top.Index(0); });
+            ComputeChecksum(indicesL1, "L1 Norm");
+
+            Cooldown();
+
+            std::cout << "Starting Streaming L2 Norm (Seeded)\n";
+            ReportThroughput(StreamSearch<Norm::L2>(stream, NUM_OF_POINTS), 0.0, "L2 Norm (Seeded)");
+
+            std::transform(neighbours, neighbours + NUM_OF_POINTS, indicesL2, [](auto const & top) { return top.Index(0); });
+            ComputeChecksum(indicesL2, "L2 Norm");
+        }
+
+        Cooldown();
+
+        std::cout << std::format("Starting Writing Large Reference Set ({} descriptors)\n", static_cast<size_t>(LARGE_NUM_OF_POINTS));
+        WriteDataset(LARGE_FILE, LARGE_NUM_OF_POINTS);
+
+        {
+            ReferenceStream stream{LARGE_FILE};
+
+            std::cout << "Starting Streaming Without Compute (Large)\n";
+
+            double bandwidth{0.0};
+            bool direct{false};
+
+            /* The best of a few passes, since a single pass of a shared disk is noisy */
+            for (size_t repetition = 0; repetition < BANDWIDTH_REPETITIONS; ++repetition)
+            {
+                auto const io = stream.Run([](Descriptor const *, size_t, size_t) {});
+
+                bandwidth = std::max(bandwidth, static_cast<double>(io.bytes) / io.seconds);
+                direct = io.direct;
+            }
+
+            std::cout << std::format("Disk bandwidth{} : {:.2f} GB/s\n", direct ? " (O_DIRECT)" : "", bandwidth / 1e9);
+
+            for (auto const numOfQueries : LARGE_NUM_OF_QUERIES)
+            {
+                Cooldown();
+
+                std::cout << std::format("Starting Streaming L2 Norm (Large, {} queries)\n", numOfQueries);
+                ReportThroughput(StreamSearch<Norm::L2>(stream, numOfQueries), bandwidth, std::format("L2 Norm ({} queries)", numOfQueries));
+            }
+        }
+
+        std::filesystem::remove(LARGE_FILE);
+    }
+    catch (std::exception const & exception)
+    {
+        std::error_code ignored;
+        std::filesystem::remove(LARGE_FILE, ignored); /* A failed run must not leave the multi-gigabyte set behind */
+
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+auto inline ComputeChecksum(size_t const * const indices, std::string_view const message) noexcept -> void
+{
+    auto const checksum = std::reduce(indices, indices + NUM_OF_POINTS, 0UL, std::bit_xor<>());
+    std::cout << std::format("Checksum for {} : {:#x}\n", message, checksum);
+}
+
+/*
+ * The first numOfQueries descriptors of set1 against the whole stream. Each tile of references is scored
+ * against all queries before moving on, so it is read from memory once per block.
+ */
+template <Norm Metric>
+auto inline StreamSearch(ReferenceStream & stream, size_t const numOfQueries) -> StreamStatistics
+{
+    std::for_each(neighbours, neighbours + numOfQueries, [](auto & top) { top.Reset(); });
+
+    return stream.Run([numOfQueries](Descriptor const * const records, size_t const first, size_t const count)
+    {
+        float currentDistance{0.0};
+
+        for (size_t tile = 0; tile < count; tile += TILE_SIZE)
+        {
+            auto const tileEnd = std::min<size_t>(tile + TILE_SIZE, count);
+
+            for (size_t idx1 = 0; idx1 < numOfQueries; ++idx1)
+            {
+                auto & top = neighbours[idx1];
+
+                for (size_t idx2 = tile; idx2 < tileEnd; ++idx2)
+                {
+                    currentDistance = Metric == Norm::L2 ? Descriptor::getL2Norm(set1[idx1], records[idx2]) : Descriptor::getL1Norm(set1[idx1], records[idx2]);
+                    top.Insert(currentDistance, first + idx2);
+                }
+            }
+        }
+    });
+}
+
+auto inline ReportThroughput(StreamStatistics const & statistics, double const bandwidth, std::string_view const message) noexcept -> void
+{
+    auto const throughput = static_cast<double>(statistics.bytes) / statistics.seconds;
+
+    std::cout << std::format("Time taken for {} : {:.0f} ms\n", message, statistics.seconds * 1e3);
+
+    if (bandwidth > 0.0)
+    {
+        std::cout << std::format("Throughput for {} : {:.2f} GB/s, {:.1f} % of disk bandwidth\n", message, throughput / 1e9, 100.0 * throughput / bandwidth);
+    }
+}
+
+/*
+ * Writes count descriptors from the shared generator, so the first file written holds the seeded set2.
+ */
+auto inline WriteDataset(std::string_view const fileName, size_t const count) -> void
+{
+    std::ofstream file{fileName.data(), std::ios::binary};
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error{std::format("Failed to open output file: {}", fileName)};
+    }
+
+    DatasetHeader const header{DATASET_MAGIC, DATASET_VERSION, Descriptor::DIMENSIONS, DataType::FLOAT32, count, PAYLOAD_ALIGNMENT, sizeof(DatasetHeader), sizeof(Descriptor), {}};
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+
+    std::vector<Descriptor> chunk;
+
+    for (size_t written = 0; written < count; written += chunk.size())
+    {
+        /* Constructing the descriptors draws them from the generator */
+        chunk.clear();
+        chunk.resize(std::min<size_t>(GENERATE_CHUNK, count - written));
+
+        file.write(reinterpret_cast<char const *>(chunk.data()), static_cast<std::streamsize>(chunk.size() * sizeof(Descriptor)));
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error{std::format("Failed to write dataset: {}", fileName)};
+    }
+}
+
+auto inline Cooldown(std::chrono::seconds const & seconds) -> void
+{
+    std::this_thread::sleep_for(seconds);
+}
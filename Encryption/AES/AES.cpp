@@ -1,12 +1,25 @@
 #include "AES.hpp"
+#include "AESKernels.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
 #include <format>
 #include <fstream>
 #include <iostream>
+#include <new>
 #include <random>
+#include <semaphore>
+#include <stdexcept>
 #include <string>
+#include <thread>
+
+#include <x86intrin.h>
 
 
 #define INT128_PTRC(x)    reinterpret_cast<int128_t const *>(x)
@@ -38,10 +51,57 @@ auto MeasureTime(std::function<void()> const & function, std::string_view const
     std::cout << std::format("{}: {} ms\n", message, time_ms);
 }
 
+auto MeasureCyclesPerByte(std::function<void()> const & function, std::size_t const bytes, std::string_view const message) -> double
+{
+    auto const start = __rdtsc();
+    function();
+    auto const stop = __rdtsc();
+    auto const cyclesPerByte = static_cast<double>(stop - start) / static_cast<double>(bytes);
+    std::cout << std::format("{}: {:.3f} cycles/byte\n", message, cyclesPerByte);
+    return cyclesPerByte;
+}
 
-AES::AES(std::string_view const stringKey) : keySize{GetKeySize(stringKey)},
-                                             rounds{GetNumRounds(stringKey)},
-                                             roundKeys{GetRoundKeys(stringKey)} { }
+
+auto GetSupportedInstructionSet() noexcept -> InstructionSet
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("vaes") && __builtin_cpu_supports("vpclmulqdq"))
+    {
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        {
+            return InstructionSet::VAES512;
+        }
+
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return InstructionSet::VAES256;
+        }
+    }
+
+    return InstructionSet::AESNI;
+}
+
+auto GetInstructionSetName(InstructionSet const instructionSet) noexcept -> std::string_view
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::VAES512 :
+            return "VAES-512";
+        case InstructionSet::VAES256 :
+            return "VAES-256";
+        case InstructionSet::AESNI :
+            return "AES-NI";
+        default :
+            return "Unknown";
+    }
+}
+
+
+AES::AES(std::string_view const stringKey, InstructionSet const instructionSet) : keySize{GetKeySize(stringKey)},
+                                                                                  rounds{GetNumRounds(stringKey)},
+                                                                                  roundKeys{GetRoundKeys(stringKey)},
+                                                                                  instructionSet{instructionSet} { }
 
 auto AES::Encrypt(BufferType const * const plaintext) const noexcept -> BufferPointer
 {
@@ -79,6 +139,63 @@ auto AES::Decrypt(BufferType const * const ciphertext) const noexcept -> BufferP
     return result;
 }
 
+auto AES::CounterMode(BufferType const * const input, BufferType * const output, std::size_t const size, std::size_t const firstBlock) const noexcept -> void
+{
+    static const auto NONCE = GetNonce();
+    int128_t const nonce = _mm_loadu_si128(INT128_PTRC(NONCE.get()));
+
+    Dispatch([&]<typename Modes> -> void
+    {
+        Modes::Counter(INT128_PTRC(roundKeys.get()), nonce, input, output, size, firstBlock);
+    });
+}
+
+auto AES::EncryptECB(BufferType const * const input, BufferType * const output, std::size_t const size) const -> void
+{
+    if (size % BLOCK_SIZE != 0)
+    {
+        throw std::invalid_argument{std::format("ECB size {} is not a multiple of the block size", size)};
+    }
+
+    Dispatch([&]<typename Modes> -> void
+    {
+        Modes::EncryptECB(INT128_PTRC(roundKeys.get()), input, output, size / BLOCK_SIZE);
+    });
+}
+
+auto AES::DecryptECB(BufferType const * const input, BufferType * const output, std::size_t const size) const -> void
+{
+    if (size % BLOCK_SIZE != 0)
+    {
+        throw std::invalid_argument{std::format("ECB size {} is not a multiple of the block size", size)};
+    }
+
+    Dispatch([&]<typename Modes> -> void
+    {
+        Modes::DecryptECB(INT128_PTRC(roundKeys.get()), input, output, size / BLOCK_SIZE);
+    });
+}
+
+auto AES::EncryptXTS(AES const & tweakCipher, BufferType const * const input, BufferType * const output, std::size_t const size, std::uint64_t const dataUnit) const -> void
+{
+    auto const tweak = GetTweak(tweakCipher, size, dataUnit);
+
+    Dispatch([&]<typename Modes> -> void
+    {
+        Modes::EncryptXTS(INT128_PTRC(roundKeys.get()), tweak, input, output, size / BLOCK_SIZE);
+    });
+}
+
+auto AES::DecryptXTS(AES const & tweakCipher, BufferType const * const input, BufferType * const output, std::size_t const size, std::uint64_t const dataUnit) const -> void
+{
+    auto const tweak = GetTweak(tweakCipher, size, dataUnit);
+
+    Dispatch([&]<typename Modes> -> void
+    {
+        Modes::DecryptXTS(INT128_PTRC(roundKeys.get()), tweak, input, output, size / BLOCK_SIZE);
+    });
+}
+
 auto AES::EncryptFile(std::string_view const inputFileName, std::string_view const outputFileName) const -> std::uint8_t
 {
     return EncryptDecryptFile(inputFileName, outputFileName, true);
@@ -105,95 +222,222 @@ auto AES::GetRandomKey(KeyType const keyType) noexcept -> std::string
     return key;
 }
 
+/*
+ *  Streams the file through FILE_CHUNK_DEPTH page-aligned buffers of FILE_CHUNK_SIZE bytes: a reader thread fills
+ *  them, this thread encrypts them in place and a writer thread drains them, so the three stages overlap and the
+ *  memory stays bounded whatever the file size. Only the last chunk is padded (encrypt) or trimmed (decrypt), and
+ *  a failure in one stage lets the others run through the remaining chunks without touching them.
+ */
 auto AES::EncryptDecryptFile(std::string_view const inputFileName, std::string_view const outputFileName, bool const encrypt, std::uint8_t const lastBytes) const -> std::uint8_t
 {
-    std::ifstream file{inputFileName.data(), std::ios::binary};
+    std::ifstream inputFile{inputFileName.data(), std::ios::binary};
 
-    if (!file.is_open())
+    if (!inputFile.is_open())
     {
         throw std::runtime_error{std::format("Failed to open input file: {}", inputFileName)};
     }
 
-    std::vector<BufferType> input(std::istreambuf_iterator<char>(file), {});
+    auto const inputSize = static_cast<std::size_t>(std::filesystem::file_size(inputFileName));
 
-    file.close();
+    if (!encrypt && (inputSize % BLOCK_SIZE != 0 || lastBytes >= BLOCK_SIZE || (inputSize == 0 && lastBytes != 0)))
+    {
+        throw std::runtime_error{std::format("Invalid encrypted file {} for last bytes {}", inputFileName, static_cast<unsigned>(lastBytes))};
+    }
 
-    auto const remainingBytes = static_cast<uint8_t>(input.size() % keySize);
+    std::ofstream outputFile{outputFileName.data(), std::ios::binary};
 
-    if (remainingBytes != 0)
+    if (!outputFile.is_open())
     {
-        for (std::size_t idx = 0; idx < keySize - remainingBytes; ++idx)
-        {
-            input.push_back(0U);
-        }
+        throw std::runtime_error{std::format("Failed to open output file: {}", outputFileName)};
+    }
+
+    auto const remainingBytes = static_cast<std::uint8_t>(inputSize % BLOCK_SIZE);
+    auto const paddedSize = inputSize + (remainingBytes != 0 ? BLOCK_SIZE - remainingBytes : 0);
+    auto const outputSize = encrypt ? paddedSize : inputSize - (lastBytes != 0 ? BLOCK_SIZE - lastBytes : 0);
+    auto const chunks = (inputSize + FILE_CHUNK_SIZE - 1) / FILE_CHUNK_SIZE;
+
+    std::unique_ptr<BufferType, decltype(&std::free)> const buffers{
+        static_cast<BufferType *>(std::aligned_alloc(FILE_CHUNK_ALIGNMENT, FILE_CHUNK_DEPTH * FILE_CHUNK_SIZE)), &std::free
+    };
+
+    if (!buffers)
+    {
+        throw std::bad_alloc{};
     }
 
-    input.shrink_to_fit();
+    auto const buffer = [&buffers](std::size_t const chunk) -> BufferType *
+    {
+        return buffers.get() + (chunk % FILE_CHUNK_DEPTH) * FILE_CHUNK_SIZE;
+    };
+
+    std::counting_semaphore<FILE_CHUNK_DEPTH> emptyBuffers{FILE_CHUNK_DEPTH};
+    std::counting_semaphore<FILE_CHUNK_DEPTH> readBuffers{0};
+    std::counting_semaphore<FILE_CHUNK_DEPTH> processedBuffers{0};
 
-    auto const processFunction = encrypt ? &AES::EncryptSequence : &AES::DecryptSequence;
-    std::vector<BufferType> processed;
+    std::atomic<bool> failed{false};
+    std::exception_ptr readError;
+    std::exception_ptr writeError;
 
     MeasureTime(
         [&] -> void
         {
-            processed = (this->*processFunction)(input);
+            std::jthread const reader{
+                [&] -> void
+                {
+                    for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+                    {
+                        emptyBuffers.acquire();
+
+                        auto const bytes = std::min(FILE_CHUNK_SIZE, inputSize - chunk * FILE_CHUNK_SIZE);
+
+                        if (!failed.load(std::memory_order_relaxed) && !inputFile.read(reinterpret_cast<char *>(buffer(chunk)), static_cast<std::streamsize>(bytes)))
+                        {
+                            readError = std::make_exception_ptr(std::runtime_error{std::format("Failed to read input file: {}", inputFileName)});
+                            failed.store(true, std::memory_order_relaxed);
+                        }
+
+                        readBuffers.release();
+                    }
+                }
+            };
+
+            std::jthread const writer{
+                [&] -> void
+                {
+                    for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+                    {
+                        processedBuffers.acquire();
+
+                        auto const bytes = std::min(FILE_CHUNK_SIZE, outputSize - chunk * FILE_CHUNK_SIZE);
+
+                        if (!failed.load(std::memory_order_relaxed) && !outputFile.write(reinterpret_cast<char const *>(buffer(chunk)), static_cast<std::streamsize>(bytes)))
+                        {
+                            writeError = std::make_exception_ptr(std::runtime_error{std::format("Failed to write output file: {}", outputFileName)});
+                            failed.store(true, std::memory_order_relaxed);
+                        }
+
+                        emptyBuffers.release();
+                    }
+                }
+            };
+
+            for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+            {
+                readBuffers.acquire();
+
+                auto const offset = chunk * FILE_CHUNK_SIZE;
+                auto const bytes = std::min(FILE_CHUNK_SIZE, inputSize - offset);
+                auto const padded = std::min(FILE_CHUNK_SIZE, paddedSize - offset);
+
+                if (!failed.load(std::memory_order_relaxed))
+                {
+                    std::memset(buffer(chunk) + bytes, 0, padded - bytes);
+                    EncryptDecryptChunk(buffer(chunk), padded, offset / BLOCK_SIZE);
+                }
+
+                processedBuffers.release();
+            }
         }, encrypt ? "Encryption" : "Decryption"
     );
 
-    std::ofstream outputFile{outputFileName.data(), std::ios::binary};
-
-    if (!outputFile.is_open())
+    if (readError)
     {
-        throw std::runtime_error{std::format("Failed to open output file: {}", outputFileName)};
+        std::rethrow_exception(readError);
     }
 
-    if (encrypt)
+    if (writeError)
     {
-        outputFile.write(reinterpret_cast<char const *>(processed.data()), processed.size());
-    }
-    else
-    {
-        outputFile.write(reinterpret_cast<char const *>(processed.data()), processed.size() - (BLOCK_SIZE - lastBytes));
+        std::rethrow_exception(writeError);
     }
 
     outputFile.close();
 
+    if (outputFile.fail())
+    {
+        throw std::runtime_error{std::format("Failed to write output file: {}", outputFileName)};
+    }
+
     return remainingBytes;
 }
 
-auto AES::EncryptSequence(std::vector<BufferType> const & input) const noexcept -> std::vector<BufferType>
+/*
+ *  CTR over one file chunk in place, split into CHUNK_BLOCKS pieces across the OpenMP threads. The first block
+ *  of the chunk keeps the counters continuous from one chunk to the next.
+ */
+auto AES::EncryptDecryptChunk(BufferType * const data, std::size_t const size, std::size_t const firstBlock) const noexcept -> void
 {
-    return EncryptDecryptSequence(input);
-}
+    auto const blocks = size / BLOCK_SIZE;
+    auto const pieces = (blocks + CHUNK_BLOCKS - 1) / CHUNK_BLOCKS;
 
-auto AES::DecryptSequence(std::vector<BufferType> const & input) const noexcept -> std::vector<BufferType>
-{
-    return EncryptDecryptSequence(input);
+    #pragma omp parallel for default(none) shared(data, firstBlock, blocks, pieces) schedule(static)
+    for (std::size_t piece = 0; piece < pieces; ++piece)
+    {
+        auto const block = piece * CHUNK_BLOCKS;
+        auto const count = std::min(CHUNK_BLOCKS, blocks - block);
+        auto * const pieceData = data + block * BLOCK_SIZE;
+
+        CounterMode(pieceData, pieceData, count * BLOCK_SIZE, firstBlock + block);
+    }
 }
 
-auto AES::EncryptDecryptSequence(std::vector<BufferType> const & input) const -> std::vector<BufferType>
+/*
+ *  Runs function with the modes of the configured instruction set and key size. Dispatching around the whole
+ *  buffer leaves a single call into the target code of the set per operation.
+ */
+template <typename Function>
+auto AES::Dispatch(Function const & function) const noexcept -> void
 {
-    static const auto NONCE = GetNonce();
-    int128_t const nonce = _mm_loadu_si128(INT128_PTRC(NONCE.get()));
+    auto const dispatchRounds = [&]<template <std::size_t> typename Modes> -> void
+    {
+        switch (rounds)
+        {
+            case as_num(RoundSize::AES128) - 1 :
+                function.template operator()<Modes<as_num(RoundSize::AES128) - 1>>();
+                break;
+            case as_num(RoundSize::AES192) - 1 :
+                function.template operator()<Modes<as_num(RoundSize::AES192) - 1>>();
+                break;
+            default :
+                function.template operator()<Modes<as_num(RoundSize::AES256) - 1>>();
+                break;
+        }
+    };
 
-    std::vector<BufferType> result(input.size(), 0U);
+    switch (instructionSet)
+    {
+        case InstructionSet::VAES512 :
+            dispatchRounds.template operator()<VAES512::AESModes>();
+            break;
+        case InstructionSet::VAES256 :
+            dispatchRounds.template operator()<VAES256::AESModes>();
+            break;
+        default :
+            dispatchRounds.template operator()<AESNI::AESModes>();
+            break;
+    }
+}
 
-    int128_t current;
-    std::array<BufferType, BLOCK_SIZE> currentVal{};
+/*
+ *  XTS works on whole blocks of one data unit (no ciphertext stealing) with a tweak key of the same size. The
+ *  initial tweak is the data unit number, little-endian, encrypted with the tweak key.
+ */
+auto AES::GetTweak(AES const & tweakCipher, std::size_t const size, std::uint64_t const dataUnit) const -> int128_t
+{
+    if (size % BLOCK_SIZE != 0)
+    {
+        throw std::invalid_argument{std::format("XTS size {} is not a multiple of the block size", size)};
+    }
 
-    #pragma omp parallel for default(none) shared(input, result, nonce) private(currentVal, current) schedule(static)
-    for (std::size_t idx = 0; idx < input.size() / BLOCK_SIZE; ++idx)
+    if (tweakCipher.keySize != keySize)
     {
-        current = _mm_xor_si128(nonce, _mm_set_epi64x(0, idx));
-        _mm_storeu_si128(INT128_PTR(currentVal.data()), current);
-        auto const processed = Encrypt(currentVal.data());
-        current = _mm_loadu_si128(INT128_PTRC(processed.get()));
-        int128_t inputBlock = _mm_loadu_si128(INT128_PTRC(input.data() + idx * BLOCK_SIZE));
-        current = _mm_xor_si128(current, inputBlock);
-        _mm_storeu_si128(INT128_PTR(result.data() + idx * BLOCK_SIZE), current);
+        throw std::invalid_argument{std::format("XTS tweak key has {} bytes instead of {}", tweakCipher.keySize, keySize)};
     }
 
-    return result;
+    std::array<BufferType, BLOCK_SIZE> unit{};
+    std::memcpy(unit.data(), &dataUnit, sizeof(dataUnit));
+
+    auto const tweak = tweakCipher.Encrypt(unit.data());
+    return _mm_loadu_si128(INT128_PTRC(tweak.get()));
 }
 
 auto AES::GetKeySize(std::string_view const stringKey) -> std::size_t
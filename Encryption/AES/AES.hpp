@@ -22,6 +22,13 @@ enum class KeyType : std::uint8_t
     AES256 = 32,
 };
 
+enum class InstructionSet : std::uint8_t
+{
+    AESNI,
+    VAES256,
+    VAES512,
+};
+
 enum class KeyLenSize : std::uint8_t;
 
 enum class RoundSize : std::uint8_t;
@@ -36,37 +43,62 @@ constexpr auto as_num(Enumeration const value) noexcept -> std::size_t requires
 
 auto MeasureTime(std::function<void()> const & function, std::string_view const message) -> void;
 
+auto MeasureCyclesPerByte(std::function<void()> const & function, std::size_t const bytes, std::string_view const message) -> double;
+
+auto GetSupportedInstructionSet() noexcept -> InstructionSet;
+
+auto GetInstructionSetName(InstructionSet const instructionSet) noexcept -> std::string_view;
+
 
 class AES
 {
 public:
-    explicit AES(std::string_view const stringKey);
+    explicit AES(std::string_view const stringKey, InstructionSet const instructionSet = GetSupportedInstructionSet());
 
     auto Encrypt(BufferType const * const plaintext) const noexcept -> BufferPointer;
 
     auto Decrypt(BufferType const * const ciphertext) const noexcept -> BufferPointer;
 
+    auto CounterMode(BufferType const * const input, BufferType * const output, std::size_t const size, std::size_t const firstBlock = 0) const noexcept -> void;
+
+    auto EncryptECB(BufferType const * const input, BufferType * const output, std::size_t const size) const -> void;
+
+    auto DecryptECB(BufferType const * const input, BufferType * const output, std::size_t const size) const -> void;
+
+    auto EncryptXTS(AES const & tweakCipher, BufferType const * const input, BufferType * const output, std::size_t const size, std::uint64_t const dataUnit) const -> void;
+
+    auto DecryptXTS(AES const & tweakCipher, BufferType const * const input, BufferType * const output, std::size_t const size, std::uint64_t const dataUnit) const -> void;
+
     auto EncryptFile(std::string_view const inputFileName, std::string_view const outputFileName) const -> std::uint8_t;
 
     auto DecryptFile(std::string_view const inputFileName, std::string_view const outputFileName, std::uint8_t const lastBytes) const -> void;
 
     static auto GetRandomKey(KeyType const keyType = KeyType::AES128) noexcept -> std::string;
 
+    static auto GetNonce() -> BufferPointer;
+
+    static constexpr std::size_t BLOCK_SIZE{16U};
+
 private:
     static constexpr std::size_t SEED{0xDEADBEEF42UL};
-    static constexpr std::size_t BLOCK_SIZE{16U};
+    static constexpr std::size_t CHUNK_BLOCKS{4096U};
+    static constexpr std::size_t FILE_CHUNK_SIZE{8UL * 1024 * 1024};
+    static constexpr std::size_t FILE_CHUNK_DEPTH{4U};
+    static constexpr std::size_t FILE_CHUNK_ALIGNMENT{4096U};
 
     std::size_t const keySize;
     std::size_t const rounds;
     BufferPointer const roundKeys;
+    InstructionSet const instructionSet;
 
     auto EncryptDecryptFile(std::string_view const inputFileName, std::string_view const outputFileName, bool const encrypt, std::uint8_t const lastBytes = 0) const -> std::uint8_t;
 
-    auto EncryptSequence(std::vector<BufferType> const & input) const noexcept -> std::vector<BufferType>;
+    auto EncryptDecryptChunk(BufferType * const data, std::size_t const size, std::size_t const firstBlock) const noexcept -> void;
 
-    auto DecryptSequence(std::vector<BufferType> const & input) const noexcept -> std::vector<BufferType>;
+    template <typename Function>
+    auto Dispatch(Function const & function) const noexcept -> void;
 
-    auto EncryptDecryptSequence(std::vector<BufferType> const & input) const -> std::vector<BufferType>;
+    auto GetTweak(AES const & tweakCipher, std::size_t const size, std::uint64_t const dataUnit) const -> int128_t;
 
     static auto GetKeySize(std::string_view const stringKey) -> std::size_t;
 
@@ -89,6 +121,4 @@ private:
     static auto KeyExpansionFirstAssist256(int128_t * const temp1, int128_t * const temp2) noexcept -> void;
 
     static auto KeyExpansionSecondAssist256(int128_t * const temp1, int128_t * const temp3) noexcept -> void;
-
-    static auto GetNonce() -> BufferPointer;
 };
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+#include "AES.hpp"
+
+
+/*
+ *  Block primitives, one set per instruction set, each in its own target region so it can be dispatched to at
+ *  runtime. A Vector holds LANES blocks and the round keys are broadcast to every lane. The mode loops are written
+ *  once in AESModes.hpp and included in every region, so they are built for that set whatever the -march of the
+ *  build: the primitives inline into them and no Vector is passed to code built for another instruction set.
+ */
+
+#pragma GCC push_options
+#pragma GCC target("aes,pclmul,sse4.1")
+
+struct AESNIKernels
+{
+    using Vector = __m128i;
+
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::AESNI};
+    static constexpr std::size_t LANES{1U};
+
+    static auto Broadcast(int128_t const block) noexcept -> Vector
+    {
+        return block;
+    }
+
+    static auto Load(BufferType const * const source) noexcept -> Vector
+    {
+        return _mm_loadu_si128(reinterpret_cast<Vector const *>(source));
+    }
+
+    static auto Store(BufferType * const destination, Vector const value) noexcept -> void
+    {
+        _mm_storeu_si128(reinterpret_cast<Vector *>(destination), value);
+    }
+
+    static auto LoadPartial(BufferType const * const source, std::size_t const /* blocks */) noexcept -> Vector
+    {
+        return Load(source);
+    }
+
+    static auto StorePartial(BufferType * const destination, Vector const value, std::size_t const /* blocks */) noexcept -> void
+    {
+        Store(destination, value);
+    }
+
+    static auto Xor(Vector const lhs, Vector const rhs) noexcept -> Vector
+    {
+        return _mm_xor_si128(lhs, rhs);
+    }
+
+    static auto Encrypt(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm_aesenc_si128(state, key);
+    }
+
+    static auto EncryptLast(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm_aesenclast_si128(state, key);
+    }
+
+    static auto Decrypt(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm_aesdec_si128(state, key);
+    }
+
+    static auto DecryptLast(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm_aesdeclast_si128(state, key);
+    }
+
+    static auto CounterStart(std::size_t const block) noexcept -> Vector
+    {
+        return _mm_set_epi64x(0, static_cast<long long>(block));
+    }
+
+    static auto CounterAdd(Vector const counter) noexcept -> Vector
+    {
+        return _mm_add_epi64(counter, _mm_set_epi64x(0, LANES));
+    }
+
+    static auto FromLanes(int128_t const * const lanes) noexcept -> Vector
+    {
+        return lanes[0];
+    }
+
+    /*
+     *  Multiplies every 128-bit lane by x^Shift in GF(2^128) mod x^128 + x^7 + x^2 + x + 1: the bits shifted out
+     *  of the low qword move to the high one, and the ones shifted out of the top are folded back with 0x87.
+     */
+    template <int Shift>
+    static auto MultiplyAlpha(Vector const tweak) noexcept -> Vector
+    {
+        Vector const carries = _mm_srli_epi64(tweak, 64 - Shift);
+        Vector const folded = _mm_clmulepi64_si128(_mm_srli_si128(carries, 8), _mm_set_epi64x(0, 0x87), 0x00);
+        return _mm_xor_si128(_mm_xor_si128(_mm_slli_epi64(tweak, Shift), _mm_slli_si128(carries, 8)), folded);
+    }
+};
+
+namespace AESNI
+{
+    using Kernels = AESNIKernels;
+
+    #include "AESModes.hpp"
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("aes,pclmul,avx2,vaes,vpclmulqdq")
+
+struct VAES256Kernels
+{
+    using Vector = __m256i;
+
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::VAES256};
+    static constexpr std::size_t LANES{2U};
+
+    static auto Broadcast(int128_t const block) noexcept -> Vector
+    {
+        return _mm256_broadcastsi128_si256(block);
+    }
+
+    static auto Load(BufferType const * const source) noexcept -> Vector
+    {
+        return _mm256_loadu_si256(reinterpret_cast<Vector const *>(source));
+    }
+
+    static auto Store(BufferType * const destination, Vector const value) noexcept -> void
+    {
+        _mm256_storeu_si256(reinterpret_cast<Vector *>(destination), value);
+    }
+
+    static auto LoadPartial(BufferType const * const source, std::size_t const blocks) noexcept -> Vector
+    {
+        return _mm256_maskload_epi64(reinterpret_cast<long long const *>(source), Mask(blocks));
+    }
+
+    static auto StorePartial(BufferType * const destination, Vector const value, std::size_t const blocks) noexcept -> void
+    {
+        _mm256_maskstore_epi64(reinterpret_cast<long long *>(destination), Mask(blocks), value);
+    }
+
+    static auto Xor(Vector const lhs, Vector const rhs) noexcept -> Vector
+    {
+        return _mm256_xor_si256(lhs, rhs);
+    }
+
+    static auto Encrypt(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm256_aesenc_epi128(state, key);
+    }
+
+    static auto EncryptLast(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm256_aesenclast_epi128(state, key);
+    }
+
+    static auto Decrypt(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm256_aesdec_epi128(state, key);
+    }
+
+    static auto DecryptLast(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm256_aesdeclast_epi128(state, key);
+    }
+
+    static auto CounterStart(std::size_t const block) noexcept -> Vector
+    {
+        auto const first = static_cast<long long>(block);
+        return _mm256_set_epi64x(0, first + 1, 0, first);
+    }
+
+    static auto CounterAdd(Vector const counter) noexcept -> Vector
+    {
+        return _mm256_add_epi64(counter, _mm256_set_epi64x(0, LANES, 0, LANES));
+    }
+
+    static auto FromLanes(int128_t const * const lanes) noexcept -> Vector
+    {
+        return _mm256_loadu_si256(reinterpret_cast<Vector const *>(lanes));
+    }
+
+    template <int Shift>
+    static auto MultiplyAlpha(Vector const tweak) noexcept -> Vector
+    {
+        Vector const carries = _mm256_srli_epi64(tweak, 64 - Shift);
+        Vector const folded = _mm256_clmulepi64_epi128(_mm256_bsrli_epi128(carries, 8), _mm256_set_epi64x(0, 0x87, 0, 0x87), 0x00);
+        return _mm256_xor_si256(_mm256_xor_si256(_mm256_slli_epi64(tweak, Shift), _mm256_bslli_epi128(carries, 8)), folded);
+    }
+
+private:
+    static auto Mask(std::size_t const blocks) noexcept -> Vector
+    {
+        return _mm256_cmpgt_epi64(_mm256_set1_epi64x(static_cast<long long>(blocks * 2)), _mm256_setr_epi64x(0, 1, 2, 3));
+    }
+};
+
+namespace VAES256
+{
+    using Kernels = VAES256Kernels;
+
+    #include "AESModes.hpp"
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("aes,pclmul,avx512f,avx512bw,vaes,vpclmulqdq")
+
+struct VAES512Kernels
+{
+    using Vector = __m512i;
+
+    static constexpr InstructionSet INSTRUCTION_SET{InstructionSet::VAES512};
+    static constexpr std::size_t LANES{4U};
+
+    static auto Broadcast(int128_t const block) noexcept -> Vector
+    {
+        return _mm512_broadcast_i32x4(block);
+    }
+
+    static auto Load(BufferType const * const source) noexcept -> Vector
+    {
+        return _mm512_loadu_si512(source);
+    }
+
+    static auto Store(BufferType * const destination, Vector const value) noexcept -> void
+    {
+        _mm512_storeu_si512(destination, value);
+    }
+
+    static auto LoadPartial(BufferType const * const source, std::size_t const blocks) noexcept -> Vector
+    {
+        return _mm512_maskz_loadu_epi64(Mask(blocks), source);
+    }
+
+    static auto StorePartial(BufferType * const destination, Vector const value, std::size_t const blocks) noexcept -> void
+    {
+        _mm512_mask_storeu_epi64(destination, Mask(blocks), value);
+    }
+
+    static auto Xor(Vector const lhs, Vector const rhs) noexcept -> Vector
+    {
+        return _mm512_xor_si512(lhs, rhs);
+    }
+
+    static auto Encrypt(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm512_aesenc_epi128(state, key);
+    }
+
+    static auto EncryptLast(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm512_aesenclast_epi128(state, key);
+    }
+
+    static auto Decrypt(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm512_aesdec_epi128(state, key);
+    }
+
+    static auto DecryptLast(Vector const state, Vector const key) noexcept -> Vector
+    {
+        return _mm512_aesdeclast_epi128(state, key);
+    }
+
+    static auto CounterStart(std::size_t const block) noexcept -> Vector
+    {
+        auto const first = static_cast<long long>(block);
+        return _mm512_set_epi64(0, first + 3, 0, first + 2, 0, first + 1, 0, first);
+    }
+
+    static auto CounterAdd(Vector const counter) noexcept -> Vector
+    {
+        return _mm512_add_epi64(counter, _mm512_set_epi64(0, LANES, 0, LANES, 0, LANES, 0, LANES));
+    }
+
+    static auto FromLanes(int128_t const * const lanes) noexcept -> Vector
+    {
+        return _mm512_loadu_si512(lanes);
+    }
+
+    template <int Shift>
+    static auto MultiplyAlpha(Vector const tweak) noexcept -> Vector
+    {
+        Vector const carries = _mm512_srli_epi64(tweak, 64 - Shift);
+        Vector const folded = _mm512_clmulepi64_epi128(_mm512_bsrli_epi128(carries, 8), _mm512_set_epi64(0, 0x87, 0, 0x87, 0, 0x87, 0, 0x87), 0x00);
+        return _mm512_xor_si512(_mm512_xor_si512(_mm512_slli_epi64(tweak, Shift), _mm512_bslli_epi128(carries, 8)), folded);
+    }
+
+private:
+    static auto Mask(std::size_t const blocks) noexcept -> __mmask8
+    {
+        return static_cast<__mmask8>((1U << (blocks * 2)) - 1U);
+    }
+};
+
+namespace VAES512
+{
+    using Kernels = VAES512Kernels;
+
+    #include "AESModes.hpp"
+}
+
+#pragma GCC pop_options
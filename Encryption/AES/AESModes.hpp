@@ -0,0 +1,283 @@
+/*
+ *  No include guard: AESKernels.hpp includes this once per kernel set, inside the target region of the set and a
+ *  namespace that names it Kernels, so every copy of the mode loops is compiled for the instruction set it uses.
+ */
+
+/*
+ *  CTR, ECB and XTS over whole buffers. Every loop keeps PIPELINE_VECTORS independent vectors in flight through
+ *  each round, so the aesenc latency is hidden behind the other vectors, and handles the last partial vector with
+ *  masked loads and stores. The round keys are broadcast once into locals that stay in registers.
+ */
+template <std::size_t Rounds>
+struct AESModes
+{
+    using Vector = typename Kernels::Vector;
+
+    static constexpr std::size_t PIPELINE_VECTORS{8U};
+    static constexpr std::size_t LANES{Kernels::LANES};
+    static constexpr std::size_t BLOCK_SIZE{AES::BLOCK_SIZE};
+
+    /*
+     *  The counter of block i is the nonce with i XORed into its low 64 bits. A trailing partial block uses only
+     *  part of its keystream.
+     */
+    static auto Counter(int128_t const * const roundKeys, int128_t const nonce, BufferType const * const input, BufferType * const output, std::size_t const size,
+                        std::size_t const firstBlock) noexcept -> void
+    {
+        Vector keys[Rounds + 1];
+        LoadEncryptionKeys(roundKeys, keys);
+
+        Vector const nonces = Kernels::Broadcast(nonce);
+        Vector counter = Kernels::CounterStart(firstBlock);
+
+        auto const blocks = size / BLOCK_SIZE;
+        std::size_t block = 0;
+
+        for (; block + PIPELINE_VECTORS * LANES <= blocks; block += PIPELINE_VECTORS * LANES)
+        {
+            Vector state[PIPELINE_VECTORS];
+
+            #pragma GCC unroll 8
+            for (std::size_t vector = 0; vector < PIPELINE_VECTORS; ++vector)
+            {
+                state[vector] = Kernels::Xor(nonces, counter);
+                counter = Kernels::CounterAdd(counter);
+            }
+
+            EncryptVectors(state, keys);
+
+            #pragma GCC unroll 8
+            for (std::size_t vector = 0; vector < PIPELINE_VECTORS; ++vector)
+            {
+                auto const offset = (block + vector * LANES) * BLOCK_SIZE;
+                Kernels::Store(output + offset, Kernels::Xor(state[vector], Kernels::Load(input + offset)));
+            }
+        }
+
+        for (; block < blocks; block += LANES)
+        {
+            auto const count = std::min(LANES, blocks - block);
+            Vector state[1]{Kernels::Xor(nonces, counter)};
+            counter = Kernels::CounterAdd(counter);
+
+            EncryptVectors(state, keys);
+
+            auto const offset = block * BLOCK_SIZE;
+            Kernels::StorePartial(output + offset, Kernels::Xor(state[0], Kernels::LoadPartial(input + offset, count)), count);
+        }
+
+        if (auto const bytes = size % BLOCK_SIZE; bytes != 0)
+        {
+            Vector state[1]{Kernels::Xor(nonces, Kernels::CounterStart(firstBlock + blocks))};
+            EncryptVectors(state, keys);
+
+            alignas(64) std::array<BufferType, LANES * BLOCK_SIZE> keystream{};
+            Kernels::Store(keystream.data(), state[0]);
+
+            for (std::size_t idx = 0; idx < bytes; ++idx)
+            {
+                output[blocks * BLOCK_SIZE + idx] = input[blocks * BLOCK_SIZE + idx] ^ keystream[idx];
+            }
+        }
+    }
+
+    static auto EncryptECB(int128_t const * const roundKeys, BufferType const * const input, BufferType * const output, std::size_t const blocks) noexcept -> void
+    {
+        Vector keys[Rounds + 1];
+        LoadEncryptionKeys(roundKeys, keys);
+
+        ProcessECB(input, output, blocks, [&keys]<std::size_t Count>(Vector (&state)[Count]) { EncryptVectors(state, keys); });
+    }
+
+    static auto DecryptECB(int128_t const * const roundKeys, BufferType const * const input, BufferType * const output, std::size_t const blocks) noexcept -> void
+    {
+        Vector keys[Rounds + 1];
+        LoadDecryptionKeys(roundKeys, keys);
+
+        ProcessECB(input, output, blocks, [&keys]<std::size_t Count>(Vector (&state)[Count]) { DecryptVectors(state, keys); });
+    }
+
+    /*
+     *  XTS of one data unit: block j is whitened with T * x^j before and after the cipher, where T is the
+     *  encrypted data unit number. Every vector holds LANES consecutive tweaks and the next vector is this one
+     *  times x^LANES.
+     */
+    static auto EncryptXTS(int128_t const * const roundKeys, int128_t const tweak, BufferType const * const input, BufferType * const output, std::size_t const blocks) noexcept -> void
+    {
+        Vector keys[Rounds + 1];
+        LoadEncryptionKeys(roundKeys, keys);
+
+        ProcessXTS(tweak, input, output, blocks, [&keys]<std::size_t Count>(Vector (&state)[Count]) { EncryptVectors(state, keys); });
+    }
+
+    static auto DecryptXTS(int128_t const * const roundKeys, int128_t const tweak, BufferType const * const input, BufferType * const output, std::size_t const blocks) noexcept -> void
+    {
+        Vector keys[Rounds + 1];
+        LoadDecryptionKeys(roundKeys, keys);
+
+        ProcessXTS(tweak, input, output, blocks, [&keys]<std::size_t Count>(Vector (&state)[Count]) { DecryptVectors(state, keys); });
+    }
+
+private:
+    static auto LoadEncryptionKeys(int128_t const * const roundKeys, Vector (&keys)[Rounds + 1]) noexcept -> void
+    {
+        #pragma GCC unroll 16
+        for (std::size_t round = 0; round <= Rounds; ++round)
+        {
+            keys[round] = Kernels::Broadcast(_mm_loadu_si128(roundKeys + round));
+        }
+    }
+
+    /*
+     *  The decryption schedule is the last encryption key, the InvMixColumns keys stored after the encryption
+     *  ones, and the first encryption key.
+     */
+    static auto LoadDecryptionKeys(int128_t const * const roundKeys, Vector (&keys)[Rounds + 1]) noexcept -> void
+    {
+        keys[0] = Kernels::Broadcast(_mm_loadu_si128(roundKeys + Rounds));
+
+        #pragma GCC unroll 16
+        for (std::size_t round = 1; round < Rounds; ++round)
+        {
+            keys[round] = Kernels::Broadcast(_mm_loadu_si128(roundKeys + Rounds + round));
+        }
+
+        keys[Rounds] = Kernels::Broadcast(_mm_loadu_si128(roundKeys));
+    }
+
+    template <std::size_t Count>
+    static auto EncryptVectors(Vector (&state)[Count], Vector const (&keys)[Rounds + 1]) noexcept -> void
+    {
+        #pragma GCC unroll 8
+        for (std::size_t vector = 0; vector < Count; ++vector)
+        {
+            state[vector] = Kernels::Xor(state[vector], keys[0]);
+        }
+
+        #pragma GCC unroll 16
+        for (std::size_t round = 1; round < Rounds; ++round)
+        {
+            #pragma GCC unroll 8
+            for (std::size_t vector = 0; vector < Count; ++vector)
+            {
+                state[vector] = Kernels::Encrypt(state[vector], keys[round]);
+            }
+        }
+
+        #pragma GCC unroll 8
+        for (std::size_t vector = 0; vector < Count; ++vector)
+        {
+            state[vector] = Kernels::EncryptLast(state[vector], keys[Rounds]);
+        }
+    }
+
+    template <std::size_t Count>
+    static auto DecryptVectors(Vector (&state)[Count], Vector const (&keys)[Rounds + 1]) noexcept -> void
+    {
+        #pragma GCC unroll 8
+        for (std::size_t vector = 0; vector < Count; ++vector)
+        {
+            state[vector] = Kernels::Xor(state[vector], keys[0]);
+        }
+
+        #pragma GCC unroll 16
+        for (std::size_t round = 1; round < Rounds; ++round)
+        {
+            #pragma GCC unroll 8
+            for (std::size_t vector = 0; vector < Count; ++vector)
+            {
+                state[vector] = Kernels::Decrypt(state[vector], keys[round]);
+            }
+        }
+
+        #pragma GCC unroll 8
+        for (std::size_t vector = 0; vector < Count; ++vector)
+        {
+            state[vector] = Kernels::DecryptLast(state[vector], keys[Rounds]);
+        }
+    }
+
+    template <typename Cipher>
+    static auto ProcessECB(BufferType const * const input, BufferType * const output, std::size_t const blocks, Cipher const & cipher) noexcept -> void
+    {
+        std::size_t block = 0;
+
+        for (; block + PIPELINE_VECTORS * LANES <= blocks; block += PIPELINE_VECTORS * LANES)
+        {
+            Vector state[PIPELINE_VECTORS];
+
+            #pragma GCC unroll 8
+            for (std::size_t vector = 0; vector < PIPELINE_VECTORS; ++vector)
+            {
+                state[vector] = Kernels::Load(input + (block + vector * LANES) * BLOCK_SIZE);
+            }
+
+            cipher(state);
+
+            #pragma GCC unroll 8
+            for (std::size_t vector = 0; vector < PIPELINE_VECTORS; ++vector)
+            {
+                Kernels::Store(output + (block + vector * LANES) * BLOCK_SIZE, state[vector]);
+            }
+        }
+
+        for (; block < blocks; block += LANES)
+        {
+            auto const count = std::min(LANES, blocks - block);
+            Vector state[1]{Kernels::LoadPartial(input + block * BLOCK_SIZE, count)};
+
+            cipher(state);
+
+            Kernels::StorePartial(output + block * BLOCK_SIZE, state[0], count);
+        }
+    }
+
+    template <typename Cipher>
+    static auto ProcessXTS(int128_t const tweak, BufferType const * const input, BufferType * const output, std::size_t const blocks, Cipher const & cipher) noexcept -> void
+    {
+        int128_t lanes[LANES]{};
+        lanes[0] = tweak;
+
+        for (std::size_t lane = 1; lane < LANES; ++lane)
+        {
+            lanes[lane] = AESNIKernels::MultiplyAlpha<1>(lanes[lane - 1]);
+        }
+
+        Vector tweaks = Kernels::FromLanes(lanes);
+        std::size_t block = 0;
+
+        for (; block + PIPELINE_VECTORS * LANES <= blocks; block += PIPELINE_VECTORS * LANES)
+        {
+            Vector state[PIPELINE_VECTORS];
+            Vector whitening[PIPELINE_VECTORS];
+
+            #pragma GCC unroll 8
+            for (std::size_t vector = 0; vector < PIPELINE_VECTORS; ++vector)
+            {
+                whitening[vector] = tweaks;
+                tweaks = Kernels::template MultiplyAlpha<LANES>(tweaks);
+
+                state[vector] = Kernels::Xor(Kernels::Load(input + (block + vector * LANES) * BLOCK_SIZE), whitening[vector]);
+            }
+
+            cipher(state);
+
+            #pragma GCC unroll 8
+            for (std::size_t vector = 0; vector < PIPELINE_VECTORS; ++vector)
+            {
+                Kernels::Store(output + (block + vector * LANES) * BLOCK_SIZE, Kernels::Xor(state[vector], whitening[vector]));
+            }
+        }
+
+        for (; block < blocks; block += LANES)
+        {
+            auto const count = std::min(LANES, blocks - block);
+            Vector state[1]{Kernels::Xor(Kernels::LoadPartial(input + block * BLOCK_SIZE, count), tweaks)};
+
+            cipher(state);
+
+            Kernels::StorePartial(output + block * BLOCK_SIZE, Kernels::Xor(state[0], tweaks), count);
+            tweaks = Kernels::template MultiplyAlpha<LANES>(tweaks);
+        }
+    }
+};
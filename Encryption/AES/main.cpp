@@ -26,12 +26,95 @@ Compiler: gcc 13.2.0
 */
 
 /*
-File Size: 5.5 MB
-Execution Time (Compiler Optimized): 4 ms
+Streaming, measured on a single-core VAES-512 host rather than the processor above:
+
+File Size: 100 MB
+Peak Memory: 36 MB (203 MB before streaming)
+Encryption Time (Including I/O): 126 ms
+
+File Size: 7.8 MB
+Encryption Time (Including I/O): 6-8 ms
 */
 
 #include "AES.hpp"
 
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+
+static constexpr std::size_t BENCHMARK_SIZE{64UL * 1024 * 1024};
+static constexpr std::size_t TAIL_BLOCKS{3U};
+
+
+struct KnownAnswer
+{
+    std::string_view key;
+    std::string_view tweakKey;
+    std::uint64_t dataUnit;
+    std::string_view plaintext;
+    std::string_view ciphertext;
+};
+
+/*
+ *  FIPS-197 appendix C.1 and C.3 (ECB, no tweak key) and IEEE 1619 XTS-AES-128 vectors 1, 2 and 4. The last two
+ *  are 32 blocks long, enough for a full pipeline of the widest set: vector 4 itself, and its ciphertext (which
+ *  has no repeated block) encrypted in ECB with the C.3 key, checked against OpenSSL.
+ */
+static constexpr std::array<KnownAnswer, 6> KNOWN_ANSWERS{{
+    {"000102030405060708090A0B0C0D0E0F", "", 0, "00112233445566778899AABBCCDDEEFF", "69C4E0D86A7B0430D8CDB78070B4C55A"},
+    {"000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F", "", 0, "00112233445566778899AABBCCDDEEFF", "8EA2B7CA516745BFEAFC49904B496089"},
+    {"00000000000000000000000000000000", "00000000000000000000000000000000", 0, "0000000000000000000000000000000000000000000000000000000000000000",
+     "917CF69EBD68B2EC9B9FE9A3EADDA692CD43D2F59598ED858C02C2652FBF922E"},
+    {"11111111111111111111111111111111", "22222222222222222222222222222222", 0x3333333333, "4444444444444444444444444444444444444444444444444444444444444444",
+     "C454185E6A16936E39334038ACEF838BFB186FFF7480ADC4289382ECD6D394F0"},
+    {"27182818284590452353602874713526", "31415926535897932384626433832795", 0,
+     "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+     "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+     "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9FA0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+     "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDFE0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF"
+     "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+     "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+     "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9FA0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+     "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDFE0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF",
+     "27A7479BEFA1D476489F308CD4CFA6E2A96E4BBE3208FF25287DD3819616E89CC78CF7F5E543445F8333D8FA7F56000005279FA5D8B5E4AD40E736DDB4D35412"
+     "328063FD2AAB53E5EA1E0A9F332500A5DF9487D07A5C92CC512C8866C7E860CE93FDF166A24912B422976146AE20CE846BB7DC9BA94A767AAEF20C0D61AD0265"
+     "5EA92DC4C4E41A8952C651D33174BE51A10C421110E6D81588EDE82103A252D8A750E8768DEFFFED9122810AAEB99F9172AF82B604DC4B8E51BCB08235A6F434"
+     "1332E4CA60482A4BA1A03B3E65008FC5DA76B70BF1690DB4EAE29C5F1BADD03C5CCF2A55D705DDCD86D449511CEB7EC30BF12B1FA35B913F9F747A8AFD1B130E"
+     "94BFF94EFFD01A91735CA1726ACD0B197C4E5B03393697E126826FB6BBDE8ECC1E08298516E2C9ED03FF3C1B7860F6DE76D4CECD94C8119855EF5297CA67E9F3"
+     "E7FF72B1E99785CA0A7E7720C5B36DC6D72CAC9574C8CBBC2F801E23E56FD344B07F22154BEBA0F08CE8891E643ED995C94D9A69C9F1B5F499027A78572AEEBD"
+     "74D20CC39881C213EE770B1010E4BEA718846977AE119F7A023AB58CCA0AD752AFE656BB3C17256A9F6E9BF19FDD5A38FC82BBE872C5539EDB609EF4F79C203E"
+     "BB140F2E583CB2AD15B4AA5B655016A8449277DBD477EF2C8D6C017DB738B18DEB4A427D1923CE3FF262735779A418F20A282DF920147BEABE421EE5319D0568"},
+    {"000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F", "", 0,
+     "27A7479BEFA1D476489F308CD4CFA6E2A96E4BBE3208FF25287DD3819616E89CC78CF7F5E543445F8333D8FA7F56000005279FA5D8B5E4AD40E736DDB4D35412"
+     "328063FD2AAB53E5EA1E0A9F332500A5DF9487D07A5C92CC512C8866C7E860CE93FDF166A24912B422976146AE20CE846BB7DC9BA94A767AAEF20C0D61AD0265"
+     "5EA92DC4C4E41A8952C651D33174BE51A10C421110E6D81588EDE82103A252D8A750E8768DEFFFED9122810AAEB99F9172AF82B604DC4B8E51BCB08235A6F434"
+     "1332E4CA60482A4BA1A03B3E65008FC5DA76B70BF1690DB4EAE29C5F1BADD03C5CCF2A55D705DDCD86D449511CEB7EC30BF12B1FA35B913F9F747A8AFD1B130E"
+     "94BFF94EFFD01A91735CA1726ACD0B197C4E5B03393697E126826FB6BBDE8ECC1E08298516E2C9ED03FF3C1B7860F6DE76D4CECD94C8119855EF5297CA67E9F3"
+     "E7FF72B1E99785CA0A7E7720C5B36DC6D72CAC9574C8CBBC2F801E23E56FD344B07F22154BEBA0F08CE8891E643ED995C94D9A69C9F1B5F499027A78572AEEBD"
+     "74D20CC39881C213EE770B1010E4BEA718846977AE119F7A023AB58CCA0AD752AFE656BB3C17256A9F6E9BF19FDD5A38FC82BBE872C5539EDB609EF4F79C203E"
+     "BB140F2E583CB2AD15B4AA5B655016A8449277DBD477EF2C8D6C017DB738B18DEB4A427D1923CE3FF262735779A418F20A282DF920147BEABE421EE5319D0568",
+     "B6896C13464E1C234C6F45F91B9C66BCCF4C11DC588D8C5D038CDCA225E5D98C3C115F67ABE2DF14998A7393466EFBA1214D9C625751708F7458AFBC1701FF20"
+     "0A5997ABD5EBCEFF08D3179C75578F60D0DCD182664BF072E55DB55C41EBF9CC5ADD116C2166CE6036D84124354A7B9A28D071D9C9E402E558C6766FC38D4A44"
+     "948C2A7920B8A57B5071B8F70BF2B350D6BB5B39492A39F1884795BFA6D9A1BA513A8F3C6F4A059EF7C7E8DFC3B75B4582C1AA197BD20DFDA25DDFA4671AEB1A"
+     "24E7A82EC7AB6E931C3175D89E63DAB2CA8100CE849C3D75F738D4CBAA612A921E1BD9858822EE1D3236BAEE4987FA7D721F0BECD405B07F0C9B7ADAA804FB90"
+     "D214BAD9D1ABC8BED338811B9DA8B2D6A1DE0BE1664307DFC6DC981D90E143752AE2721EB724ED6935EE4DC7FFCCF33596D521D40C8A9375A722B41BA97D79AA"
+     "5EC946403E17BF342C9E21E0AAAE47B6884B3038F1DF45CC6B49CBF97483FC7053103F0097344A359EC90CCE64E1D6F84A8FBFC64F97D2F1CAE7AC144C5FDA0C"
+     "CA04840DBB714CFBF63486BE632C4334EA44D9F638507C9F18056B496591E4C4703FADF5A519AAC2D728F03AAA7C28D695223D61CCC55235E39E9FFC4E2240BB"
+     "677036ACDEDEE805AFF27A119C9C397101E37743338C23919986E274FAB3943416B6EA887378143D9AF937FAAE98919A26EA5840FD05620BAA9771719C144F8D"},
+}};
+
+
+auto BenchmarkCounterMode(KeyType const keyType) -> void;
+
+auto GetInstructionSets() -> std::vector<InstructionSet>;
+
+auto FromHex(std::string_view const hex) -> std::vector<BufferType>;
+
+auto CheckKnownAnswers() -> void;
+
+auto BenchmarkInstructionSets(KeyType const keyType) -> void;
+
 
 auto main() -> int
 {
@@ -41,5 +124,194 @@ auto main() -> int
 
     aes.DecryptFile("../encrypted.txt", "../decrypted.txt", lastBytes);
 
+    BenchmarkCounterMode(KeyType::AES128);
+    BenchmarkCounterMode(KeyType::AES192);
+    BenchmarkCounterMode(KeyType::AES256);
+
+    CheckKnownAnswers();
+
+    BenchmarkInstructionSets(KeyType::AES128);
+    BenchmarkInstructionSets(KeyType::AES256);
+
     return EXIT_SUCCESS;
 }
+
+/*
+ * Single-thread CTR over BENCHMARK_SIZE bytes: the previous path (one Encrypt() call and one heap block per 16
+ * bytes) against the pipelined CounterMode(), which must produce the same ciphertext.
+ */
+auto BenchmarkCounterMode(KeyType const keyType) -> void
+{
+    AES const aes(AES::GetRandomKey(keyType));
+
+    std::vector<BufferType> input(BENCHMARK_SIZE);
+    std::vector<BufferType> expected(BENCHMARK_SIZE);
+    std::vector<BufferType> output(BENCHMARK_SIZE);
+
+    std::mt19937_64 randomEngine{as_num(keyType)};
+    std::generate(input.begin(), input.end(), [&randomEngine] { return static_cast<BufferType>(randomEngine()); });
+
+    auto const nonce = _mm_loadu_si128(reinterpret_cast<int128_t const *>(AES::GetNonce().get()));
+
+    std::cout << std::format("AES-{} CTR on {} MB\n", as_num(keyType) * 8, BENCHMARK_SIZE / (1024 * 1024));
+
+    auto const perBlock = MeasureCyclesPerByte(
+        [&] -> void
+        {
+            std::array<BufferType, AES::BLOCK_SIZE> counter{};
+
+            for (std::size_t idx = 0; idx < BENCHMARK_SIZE / AES::BLOCK_SIZE; ++idx)
+            {
+                _mm_storeu_si128(reinterpret_cast<int128_t *>(counter.data()), _mm_xor_si128(nonce, _mm_set_epi64x(0, static_cast<long long>(idx))));
+                auto const keystream = aes.Encrypt(counter.data());
+
+                for (std::size_t byte = 0; byte < AES::BLOCK_SIZE; ++byte)
+                {
+                    expected[idx * AES::BLOCK_SIZE + byte] = input[idx * AES::BLOCK_SIZE + byte] ^ keystream[byte];
+                }
+            }
+        }, BENCHMARK_SIZE, "Per-block"
+    );
+
+    auto const pipelined = MeasureCyclesPerByte(
+        [&] -> void
+        {
+            aes.CounterMode(input.data(), output.data(), BENCHMARK_SIZE);
+        }, BENCHMARK_SIZE, "Pipelined"
+    );
+
+    if (output != expected)
+    {
+        throw std::runtime_error{std::format("Pipelined AES-{} CTR does not match the per-block reference", as_num(keyType) * 8)};
+    }
+
+    std::cout << std::format("Speedup: {:.1f}x\n", perBlock / pipelined);
+}
+
+
+/*
+ *  AES-NI and every wider instruction set the host supports.
+ */
+auto GetInstructionSets() -> std::vector<InstructionSet>
+{
+    std::vector<InstructionSet> instructionSets{InstructionSet::AESNI};
+
+    switch (GetSupportedInstructionSet())
+    {
+        case InstructionSet::VAES512 :
+            instructionSets.push_back(InstructionSet::VAES256);
+            instructionSets.push_back(InstructionSet::VAES512);
+            break;
+        case InstructionSet::VAES256 :
+            instructionSets.push_back(InstructionSet::VAES256);
+            break;
+        default :
+            break;
+    }
+
+    return instructionSets;
+}
+
+auto FromHex(std::string_view const hex) -> std::vector<BufferType>
+{
+    std::vector<BufferType> bytes(hex.size() / 2);
+
+    for (std::size_t idx = 0; idx < bytes.size(); ++idx)
+    {
+        bytes[idx] = static_cast<BufferType>(std::stoul(std::string{hex.substr(idx * 2, 2)}, nullptr, 16));
+    }
+
+    return bytes;
+}
+
+auto CheckKnownAnswers() -> void
+{
+    for (auto const instructionSet : GetInstructionSets())
+    {
+        for (auto const & answer : KNOWN_ANSWERS)
+        {
+            AES const aes(answer.key, instructionSet);
+
+            auto const plaintext = FromHex(answer.plaintext);
+            auto const ciphertext = FromHex(answer.ciphertext);
+
+            std::vector<BufferType> encrypted(plaintext.size());
+            std::vector<BufferType> decrypted(plaintext.size());
+
+            if (answer.tweakKey.empty())
+            {
+                aes.EncryptECB(plaintext.data(), encrypted.data(), plaintext.size());
+                aes.DecryptECB(encrypted.data(), decrypted.data(), encrypted.size());
+            }
+            else
+            {
+                AES const tweakCipher(answer.tweakKey, instructionSet);
+
+                aes.EncryptXTS(tweakCipher, plaintext.data(), encrypted.data(), plaintext.size(), answer.dataUnit);
+                aes.DecryptXTS(tweakCipher, encrypted.data(), decrypted.data(), encrypted.size(), answer.dataUnit);
+            }
+
+            if (encrypted != ciphertext || decrypted != plaintext)
+            {
+                throw std::runtime_error{std::format("{} fails the known answer for key {}", GetInstructionSetName(instructionSet), answer.key)};
+            }
+        }
+    }
+
+    std::cout << "Known answers: OK\n";
+}
+
+/*
+ *  Single-thread CTR, ECB and XTS with every supported instruction set over BENCHMARK_SIZE bytes plus a few
+ *  blocks, so the partial vectors are exercised too. Every output must match the AES-NI one and decrypt back.
+ */
+auto BenchmarkInstructionSets(KeyType const keyType) -> void
+{
+    auto const size = BENCHMARK_SIZE + TAIL_BLOCKS * AES::BLOCK_SIZE;
+
+    std::vector<BufferType> input(size);
+    std::mt19937_64 randomEngine{as_num(keyType)};
+    std::generate(input.begin(), input.end(), [&randomEngine] { return static_cast<BufferType>(randomEngine()); });
+
+    std::array<std::vector<BufferType>, 3> expected{};
+    std::vector<BufferType> output(size);
+    std::vector<BufferType> roundTrip(size);
+
+    auto const key = AES::GetRandomKey(keyType);
+    auto const tweakKey = AES::GetRandomKey(keyType).substr(0, key.size() / 2) + key.substr(0, key.size() / 2);
+
+    std::cout << std::format("AES-{} on {} MB\n", as_num(keyType) * 8, size / (1024 * 1024));
+
+    for (auto const instructionSet : GetInstructionSets())
+    {
+        AES const aes(key, instructionSet);
+        AES const tweakCipher(tweakKey, instructionSet);
+
+        auto const name = GetInstructionSetName(instructionSet);
+
+        auto const check = [&](std::size_t const mode, std::string_view const modeName) -> void
+        {
+            if (instructionSet == InstructionSet::AESNI)
+            {
+                expected[mode] = output;
+            }
+
+            if (output != expected[mode] || roundTrip != input)
+            {
+                throw std::runtime_error{std::format("{} {} does not match AES-NI", name, modeName)};
+            }
+        };
+
+        MeasureCyclesPerByte([&] -> void { aes.CounterMode(input.data(), output.data(), size); }, size, std::format("{} CTR", name));
+        aes.CounterMode(output.data(), roundTrip.data(), size);
+        check(0, "CTR");
+
+        MeasureCyclesPerByte([&] -> void { aes.EncryptECB(input.data(), output.data(), size); }, size, std::format("{} ECB encrypt", name));
+        MeasureCyclesPerByte([&] -> void { aes.DecryptECB(output.data(), roundTrip.data(), size); }, size, std::format("{} ECB decrypt", name));
+        check(1, "ECB");
+
+        MeasureCyclesPerByte([&] -> void { aes.EncryptXTS(tweakCipher, input.data(), output.data(), size, 0); }, size, std::format("{} XTS encrypt", name));
+        MeasureCyclesPerByte([&] -> void { aes.DecryptXTS(tweakCipher, output.data(), roundTrip.data(), size, 0); }, size, std::format("{} XTS decrypt", name));
+        check(2, "XTS");
+    }
+}
\ No newline at end of file